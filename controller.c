@@ -0,0 +1,1019 @@
+#include "controller.h"
+
+/* ============================================================================
+ * INTERSECTION GEOMETRY
+ * pedPhase[]      vehicle phase each crosswalk runs alongside
+ * bayPhase[]      protected left each bay feeds
+ * trapPhase[]     through phase each speed-trap approach protects
+ * detectorPhase[] phase each chain detector calls and extends
+ * ========================================================================= */
+
+const Phase pedPhase[NUM_DEVICES] = {
+    [PED_NORTH] = PHASE_2,
+    [PED_SOUTH] = PHASE_6,
+    [PED_EAST]  = PHASE_8,
+    [PED_WEST]  = PHASE_4
+};
+
+const Phase bayPhase[NUM_LEFT_BAYS] = {
+    [BAY_NORTH_LEFT] = PHASE_1,
+    [BAY_SOUTH_LEFT] = PHASE_5
+};
+
+const Phase trapPhase[NUM_APPROACHES] = {
+    [APPROACH_NORTH] = PHASE_2,
+    [APPROACH_SOUTH] = PHASE_6,
+    [APPROACH_EAST]  = PHASE_8,
+    [APPROACH_WEST]  = PHASE_4
+};
+
+const Phase detectorPhase[NUM_DETECTORS] = {
+    [DET_N_THRU]         = PHASE_2,
+    [DET_N_THRU_ADVANCE] = PHASE_2,
+    [DET_S_THRU]         = PHASE_6,
+    [DET_S_THRU_ADVANCE] = PHASE_6,
+    [DET_S_RIGHT]        = PHASE_6,
+    [DET_E_THRU]         = PHASE_8,
+    [DET_E_THRU_ADVANCE] = PHASE_8,
+    [DET_E_LEFT]         = PHASE_8,
+    [DET_W_THRU]         = PHASE_4,
+    [DET_W_THRU_ADVANCE] = PHASE_4,
+    [DET_W_RIGHT]        = PHASE_4
+};
+
+static void setStateTimer(IntersectionContext *ctx, uint32_t ms);
+static void startPhaseEngine(IntersectionContext *ctx, uint8_t barrier);
+static bool servicePhaseEngine(IntersectionContext *ctx);
+static bool handlePhaseEvents(IntersectionContext *ctx);
+static void serviceLeftBays(IntersectionContext *ctx);
+static void displayPedState(IntersectionContext *ctx);
+static void start_walk(IntersectionContext *ctx, uint8_t device,
+                       uint8_t walkTime);
+
+/* ============================================================================
+ * PEDESTRIANS
+ * ========================================================================= */
+
+/* Called as each phase turns green - fires the walk on the crosswalks that
+ * run with it. Also resets the per-phase extension flag for those
+ * directions so each pedestrian gets a fresh extension opportunity at the
+ * start of every green */
+static void triggerPedWalk(IntersectionContext *ctx, Phase phase) {
+    uint8_t i;
+    for (i = 0; i < NUM_DEVICES; i++) {
+        if (pedPhase[i] != phase) continue;
+        ctx->pedExtendUsed[i] = false;
+        if (i == PED_NORTH || i == PED_SOUTH) {
+            start_walk(ctx, i, WALK_TIME_NS);
+        } else {
+            start_walk(ctx, i, WALK_TIME_EW);
+        }
+    }
+}
+
+bool pedPhaseGreen(const IntersectionContext *ctx, uint8_t device) {
+    return ctx->state == STATE_PHASE_ENGINE &&
+           ringPhaseGreen(&ctx->engine, pedPhase[device]);
+}
+
+/* Phases that may not leave green while their crosswalk is still walking
+ * or counting down - the per-phase form of anyPedestrianActive() */
+static uint16_t pedHoldMask(const IntersectionContext *ctx) {
+    uint16_t hold = 0;
+    uint8_t i;
+    for (i = 0; i < NUM_DEVICES; i++) {
+        if (ctx->state_walking[i] == STATE_WALK ||
+            ctx->state_walking[i] == STATE_COUNTDOWN) {
+            hold |= PHASE_BIT(pedPhase[i]);
+        }
+    }
+    return hold;
+}
+
+static void updatePedStateMachine(IntersectionContext *ctx) {
+    uint8_t i;
+    for (i = 0; i < NUM_DEVICES; i++) {
+        switch (ctx->state_walking[i]) {
+            case STATE_WALK:
+                if (ctx->walk_display_time[i] > 0) {
+                    ctx->walk_display_time[i]--;
+                }
+                if (ctx->walk_display_time[i] == 0) {
+                    ctx->state_walking[i] = STATE_COUNTDOWN;
+                    ctx->walk_counter[i]  = 9;
+                }
+                break;
+
+            case STATE_COUNTDOWN:
+                if (ctx->walk_counter[i] > 0) ctx->walk_counter[i]--;
+                else ctx->state_walking[i] = STATE_HAND;
+                break;
+
+            default:
+                break;
+        }
+    }
+}
+
+static void displayPedState(IntersectionContext *ctx) {
+    uint8_t image[NUM_DEVICES];
+    uint8_t i;
+    for (i = 0; i < NUM_DEVICES; i++) {
+        switch (ctx->state_walking[i]) {
+            case STATE_HAND:      image[i] = PED_IMAGE_HAND;       break;
+            case STATE_WALK:      image[i] = PED_IMAGE_WALK;       break;
+            case STATE_COUNTDOWN: image[i] = ctx->walk_counter[i]; break;
+            default:              image[i] = PED_IMAGE_HAND;       break;
+        }
+    }
+    ctx->hw->showPeds(ctx->board, image);
+}
+
+static void start_walk(IntersectionContext *ctx, uint8_t device,
+                       uint8_t walkTime) {
+    if (ctx->state_walking[device] == STATE_HAND) {
+        ctx->state_walking[device]     = STATE_WALK;
+        ctx->walk_display_time[device] = walkTime;
+    }
+}
+
+/* Returns true if ANY direction is currently walking or counting down.
+ * Used to block traffic state transitions until pedestrians finish
+ * crossing. */
+bool anyPedestrianActive(const IntersectionContext *ctx) {
+    uint8_t i;
+    for (i = 0; i < NUM_DEVICES; i++) {
+        if (ctx->state_walking[i] == STATE_WALK ||
+            ctx->state_walking[i] == STATE_COUNTDOWN) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* Any WALK drops straight into the countdown so the crosswalk clears while
+ * the vehicle clearance runs; queued requests are discarded. */
+static void truncatePedWalks(IntersectionContext *ctx) {
+    uint8_t i;
+    for (i = 0; i < NUM_DEVICES; i++) {
+        ctx->pedWalkRequest[i] = false;
+        if (ctx->state_walking[i] == STATE_WALK) {
+            ctx->walk_display_time[i] = 1;
+        }
+    }
+}
+
+/* ============================================================================
+ * BUZZERS
+ *
+ * Each buzzer mirrors the state of its corresponding pedestrian display:
+ *   STATE_HAND      -> silent
+ *   STATE_WALK      -> slow steady beep
+ *   STATE_COUNTDOWN -> accelerating beep, GAP_COUNTDOWN_MAX at counter 9
+ *                      down to GAP_COUNTDOWN_MIN at counter 0
+ *
+ * Each beep pulse and gap is a one-shot on buzzTimer[] (timer wheel).
+ * ========================================================================= */
+
+/* Returns the current gap (off-time) in ms for this device based on its
+ * state. Returns 0 when the buzzer should be silent */
+static uint16_t buzzerGapForDevice(const IntersectionContext *ctx,
+                                   uint8_t device) {
+    uint32_t span;
+
+    switch (ctx->state_walking[device]) {
+        case STATE_WALK:
+            return GAP_WALK_MS;
+
+        case STATE_COUNTDOWN:
+            /* gap = MIN + (MAX - MIN) * counter / 9 */
+            span = (uint32_t)(GAP_COUNTDOWN_MAX - GAP_COUNTDOWN_MIN);
+            return (uint16_t)(GAP_COUNTDOWN_MIN +
+                              (span * ctx->walk_counter[device]) / 9U);
+
+        default:
+            return 0;
+    }
+}
+
+static void serviceBuzzers(IntersectionContext *ctx) {
+    uint8_t i;
+
+    for (i = 0; i < NUM_DEVICES; i++) {
+        /* Silent state - turn off and stop the cycle */
+        if (buzzerGapForDevice(ctx, i) == 0) {
+            if (timerArmed(&ctx->buzzTimer[i]) || ctx->buzzPhaseOn[i]) {
+                timerCancel(&ctx->buzzTimer[i]);
+                ctx->hw->setBuzzer(ctx->board, i, false);
+                ctx->buzzPhaseOn[i] = false;
+            }
+        }
+        /* Active state - the first beep comes after one gap */
+        else if (!timerArmed(&ctx->buzzTimer[i])) {
+            timerStart(ctx->wheel, &ctx->buzzTimer[i],
+                       buzzerGapForDevice(ctx, i), 0);
+        }
+    }
+}
+
+/* End of a beep pulse or gap; the gap is re-read each cycle so the
+ * countdown beeps speed up as walk_counter falls */
+static void buzzerTimeout(void *owner, uint8_t device) {
+    IntersectionContext *ctx = owner;
+    uint16_t gap = buzzerGapForDevice(ctx, device);
+
+    if (gap == 0) {
+        ctx->hw->setBuzzer(ctx->board, device, false);
+        ctx->buzzPhaseOn[device] = false;
+        return;
+    }
+
+    ctx->buzzPhaseOn[device] = !ctx->buzzPhaseOn[device];
+    ctx->hw->setBuzzer(ctx->board, device, ctx->buzzPhaseOn[device]);
+    timerStart(ctx->wheel, &ctx->buzzTimer[device],
+               ctx->buzzPhaseOn[device] ? BEEP_ON_MS : gap, 0);
+}
+
+/* ============================================================================
+ * DILEMMA-ZONE PROTECTION
+ * Speed-trap edges are paired into vehicle speeds (dilemma_zone.c). A
+ * through green that is due to end is held while a measured vehicle is in
+ * its dilemma zone, up to the max-out; a vehicle that cannot stop after the
+ * green has ended stretches the red clearance until it is through.
+ * ========================================================================= */
+
+static void serviceSpeedTraps(IntersectionContext *ctx) {
+    uint32_t now = ctx->wheel->now;
+    uint8_t edges = ctx->trapEdges;
+    SpeedTrap *trap;
+    uint8_t ring, a;
+    Phase phase;
+
+    ctx->trapEdges = 0;
+
+    for (a = 0; a < NUM_APPROACHES; a++) {
+        trap = &ctx->trap[a];
+        if (edges & TRAP_EDGE(a, TRAP_UP)) {
+            dzUpstream(trap, ctx->trapCapture[a][TRAP_UP]);
+        }
+        if (!(edges & TRAP_EDGE(a, TRAP_DOWN))) continue;
+        if (!dzDownstream(trap, ctx->trapCapture[a][TRAP_DOWN], now)) {
+            continue;
+        }
+
+        if (ctx->state != STATE_PHASE_ENGINE) continue;
+
+        /* Red-light runner: its phase is already in yellow or red clearance */
+        phase = trapPhase[a];
+        ring  = phaseDefs[phase].ring;
+        if (ctx->engine.ring[ring].phase == phase &&
+            !ringPhaseGreen(&ctx->engine, phase) && dzCannotStop(trap)) {
+            ringExtendClearance(&ctx->engine, ring,
+                                dzRunnerClearance(trap, now));
+        }
+    }
+}
+
+static uint16_t dzHoldMask(IntersectionContext *ctx) {
+    uint32_t now = ctx->wheel->now;
+    uint16_t hold = 0;
+    uint8_t ring, a;
+    Phase phase;
+    bool due;
+
+    for (a = 0; a < NUM_APPROACHES; a++) {
+        phase = trapPhase[a];
+        ring  = phaseDefs[phase].ring;
+
+        due = ringPhaseGreen(&ctx->engine, phase) &&
+              (ringGreenRemaining(&ctx->engine, ring) == 0 ||
+               ctx->engine.endBarrier);
+        if (dzHoldGreen(&ctx->trap[a], due, now)) hold |= PHASE_BIT(phase);
+    }
+    return hold;
+}
+
+/* ============================================================================
+ * VEHICLE ACTUATION
+ * A detector rising edge on a phase that is not green places a call on it;
+ * while the phase is green every edge or occupied scan counts as an
+ * actuation. A green past its minimum with no actuation for DET_PASSAGE_MS
+ * gaps out. Coordinated operation keeps its fixed splits, and failed
+ * detectors (serviceDetectorHealth) are ignored, their phases never gapping
+ * out.
+ *
+ * The chain is not trusted until it has produced its first edge - on a
+ * board without one fitted, never. Until then it actuates nothing, is not
+ * diagnosed, and every phase it serves is on max recall as though its
+ * detectors had failed, without the fault lamp.
+ * ========================================================================= */
+
+static void serviceDetectors(IntersectionContext *ctx) {
+    uint8_t rose[DET_CHAIN_DEVICES];
+    uint8_t fell[DET_CHAIN_DEVICES];
+    uint32_t now = ctx->wheel->now;
+    RingEngine *eng = &ctx->engine;
+    Phase phase;
+    uint8_t d, r;
+
+    detTakeEdges(&ctx->detectors, rose, fell);
+
+    for (d = 0; d < NUM_DETECTORS; d++) {
+        if (!detEdge(rose, (Detector)d)) continue;
+        ctx->chainEdges[d]++;
+        ctx->chainLive = true;
+    }
+
+    if (!ctx->chainLive || ctx->state != STATE_PHASE_ENGINE) return;
+
+    for (d = 0; d < NUM_DETECTORS; d++) {
+        if (healthFailed(&ctx->chainHealth[d])) continue;
+
+        phase = detectorPhase[d];
+        if (ringPhaseGreen(eng, phase)) {
+            if (detEdge(rose, (Detector)d) ||
+                detOccupied(&ctx->detectors, (Detector)d)) {
+                ctx->phaseActuationTick[phase] = now;
+            }
+        }
+        else if (detEdge(rose, (Detector)d)) {
+            ringPlaceCall(eng, phase);
+        }
+    }
+
+    if (ctx->coord.enabled) return;
+
+    for (r = 0; r < NUM_RINGS; r++) {
+        phase = ringGreenPhase(eng, r);
+        if (phase == PHASE_NONE || phaseDefs[phase].approaches == 0 ||
+            (ctx->failedPhases & PHASE_BIT(phase))) continue;
+        if (ringGreenElapsed(eng, r) < eng->plan->minGreen[phase] ||
+            now - ctx->phaseActuationTick[phase] < DET_PASSAGE_MS) continue;
+        ringSetGreenRemaining(eng, r, 0);
+    }
+}
+
+/* ============================================================================
+ * DETECTOR DIAGNOSTICS
+ * Runs every DET_HEALTH_PERIOD_MS (1s tick). Status changes are logged
+ * with the RTC time; a chattering bay stays masked until its retry, when
+ * its interrupt is re-armed. A bay's ISR also masks it on its own edge
+ * count, whose window is not this period's, and may have lost edges to a
+ * full event queue - so a bay that masked itself (bayChattered) is failed
+ * as chattering whatever this period counted, and is re-armed the same
+ * way. Every phase with a failed detector is put on
+ * max recall (engine.recall) and the fault lamp is lit.
+ * ========================================================================= */
+
+static void serviceDetectorHealth(IntersectionContext *ctx) {
+    uint16_t failed = 0;
+    uint16_t recall = 0;            /* failed, or not yet trusted */
+    uint16_t edges;
+    DetStatus before, after;
+    uint8_t i;
+
+    for (i = 0; i < NUM_LEFT_BAYS; i++) {
+        edges = ctx->bayEdges[i];
+        ctx->bayEdges[i] = 0;
+
+        before = ctx->bayHealth[i].status;
+        if (ctx->hw->bayChattered(ctx->board, (LeftBay)i)) {
+            healthChatter(&ctx->bayHealth[i]);
+            after = ctx->bayHealth[i].status;
+        } else {
+            after = healthUpdate(&ctx->bayHealth[i], edges,
+                                 ctx->hw->bayOccupied(ctx->board, (LeftBay)i),
+                                 DET_HEALTH_PERIOD_MS);
+        }
+
+        if (after != before) {
+            healthLog(ctx->detLog, DET_ID_BAY(i), after, ctx->minuteOfDay);
+            if (before == DET_FAIL_CHATTER) {
+                ctx->hw->maskBay(ctx->board, (LeftBay)i, false);
+            }
+        }
+        if (healthMasked(&ctx->bayHealth[i])) {
+            ctx->hw->maskBay(ctx->board, (LeftBay)i, true);
+        }
+        if (healthFailed(&ctx->bayHealth[i])) {
+            failed |= PHASE_BIT(bayPhase[i]);
+        }
+    }
+
+    for (i = 0; i < NUM_DETECTORS; i++) {
+        if (!ctx->chainLive) {
+            recall |= PHASE_BIT(detectorPhase[i]);
+            continue;
+        }
+        before = ctx->chainHealth[i].status;
+        after  = healthUpdate(&ctx->chainHealth[i], ctx->chainEdges[i],
+                              detOccupied(&ctx->detectors, (Detector)i),
+                              DET_HEALTH_PERIOD_MS);
+        ctx->chainEdges[i] = 0;
+
+        if (after != before) {
+            healthLog(ctx->detLog, i, after, ctx->minuteOfDay);
+        }
+        if (healthFailed(&ctx->chainHealth[i])) {
+            failed |= PHASE_BIT(detectorPhase[i]);
+        }
+    }
+    recall |= failed;
+
+    ctx->failedPhases  = recall;
+    ctx->engine.recall = recall;
+    ctx->hw->setFaultLamp(ctx->board, failed != 0);
+}
+
+/* ============================================================================
+ * LEFT-TURN BAY SERVICE
+ * Drains the arrival counters into the queue model and discharges for
+ * the time since the last update. A bay about to spill back places a call
+ * on its left phase and, from the E/W barrier, ends that barrier early so
+ * the left comes round sooner. A bay that is currently green is never
+ * flagged; instead its left is cut short once the bay has gapped out, so
+ * concurrent N and S lefts end independently.
+ * ========================================================================= */
+
+static void serviceLeftBays(IntersectionContext *ctx) {
+    uint32_t now = ctx->wheel->now;
+    uint32_t elapsed = now - ctx->lastBayUpdateTick;
+    RingEngine *eng = &ctx->engine;
+    BayQueue *bay;
+    Phase phase;
+    uint8_t i;
+
+    ctx->lastBayUpdateTick = now;
+
+    for (i = 0; i < NUM_LEFT_BAYS; i++) {
+        bay = &ctx->leftBay[i];
+        queueArrival(bay, ctx->leftArrivals[i]);
+        ctx->leftArrivals[i] = 0;
+        queueUpdate(bay, elapsed);
+
+        /* A failed bay is on max recall - its queue estimate means nothing */
+        if (ctx->state != STATE_PHASE_ENGINE ||
+            healthFailed(&ctx->bayHealth[i])) continue;
+
+        phase = bayPhase[i];
+        if (queueGappedOut(bay) && ringPhaseGreen(eng, phase)) {
+            ringSetGreenRemaining(eng, phaseDefs[phase].ring, 0);
+            continue;
+        }
+        if (bay->greenActive || !queueSpillbackImminent(bay)) continue;
+
+        ringPlaceCall(eng, phase);
+        if (eng->barrier != phaseDefs[phase].barrier) ringEndBarrier(eng);
+    }
+}
+
+static uint8_t currentLeftArrows(const IntersectionContext *ctx) {
+    uint16_t greens;
+    uint8_t arrows = 0;
+    uint8_t p;
+
+    if (ctx->state != STATE_PHASE_ENGINE) {
+        return getStateLeftArrows(ctx->state);
+    }
+
+    greens = ringGreens(&ctx->engine);
+    for (p = PHASE_1; p < NUM_PHASES; p++) {
+        if (greens & PHASE_BIT(p)) arrows |= phaseDefs[p].leftArrows;
+    }
+    return arrows;
+}
+
+static void setLeftBayGreens(IntersectionContext *ctx) {
+    uint8_t arrows = currentLeftArrows(ctx);
+    queueSetGreen(&ctx->leftBay[BAY_NORTH_LEFT],
+                  (arrows & APPROACH_BIT(APPROACH_NORTH)) != 0);
+    queueSetGreen(&ctx->leftBay[BAY_SOUTH_LEFT],
+                  (arrows & APPROACH_BIT(APPROACH_SOUTH)) != 0);
+}
+
+/* Phase-engine frames get the flashing yellow arrow overlay; every other
+ * state renders through executeState() */
+static void renderSignals(IntersectionContext *ctx) {
+    if (ctx->state == STATE_PHASE_ENGINE) {
+        ringRender(&ctx->engine, &ctx->leds);
+        fyaApply(&ctx->leds, ringGreens(&ctx->engine), ctx->leftPermissive,
+                 ctx->fyaFlashOn);
+    } else {
+        executeState(&ctx->leds, ctx->state);
+    }
+    ctx->hw->showSignals(ctx->board, &ctx->leds);
+}
+
+/* ============================================================================
+ * GREEN TIME
+ * Split from the plan, adjusted by transit priority (early-green cuts and
+ * repayment of earlier cuts), protected lefts sized from the bay queue
+ * estimate, and finally the coordination offset correction, which absorbs
+ * any of those changes.
+ * ========================================================================= */
+
+static void phaseGreenStart(IntersectionContext *ctx, Phase phase) {
+    const PhaseDef *def = &phaseDefs[phase];
+    uint32_t duration = ctx->engine.plan->split[phase];
+
+    duration = tspGreenStart(&ctx->tsp, def->approaches, duration);
+    if (ctx->failedPhases & PHASE_BIT(phase)) {
+        /* Max recall - keep the full split */
+    }
+    else if (def->leftArrows & APPROACH_BIT(APPROACH_NORTH)) {
+        duration = queueGreenTime(&ctx->leftBay[BAY_NORTH_LEFT]);
+    }
+    else if (def->leftArrows & APPROACH_BIT(APPROACH_SOUTH)) {
+        duration = queueGreenTime(&ctx->leftBay[BAY_SOUTH_LEFT]);
+    }
+    duration = coordGreenTime(&ctx->coord, phase, duration);
+
+    ctx->phaseActuationTick[phase] = ctx->wheel->now;
+    ringSetGreenRemaining(&ctx->engine, def->ring, duration);
+    triggerPedWalk(ctx, phase);
+}
+
+/* ============================================================================
+ * PHASE ENGINE SERVICE
+ * Called every pass while the state is STATE_PHASE_ENGINE. Left-turn
+ * latches become calls, crosswalks in use hold their phases, and the
+ * engine is stepped by the elapsed ms. Returns true if the displayed
+ * intervals changed.
+ * ========================================================================= */
+
+static void startPhaseEngine(IntersectionContext *ctx, uint8_t barrier) {
+    ctx->state = STATE_PHASE_ENGINE;
+    setStateTimer(ctx, 0);
+    ctx->leftPermissive = ctx->fyaScheduled;    /* nothing green yet */
+
+    ctx->lastEngineTick = ctx->wheel->now;
+    ringStart(&ctx->engine, ctx->planOverride ? ctx->planOverride
+                                              : getPlanForMode(ctx->mode),
+              barrier);
+    handlePhaseEvents(ctx);
+}
+
+static bool servicePhaseEngine(IntersectionContext *ctx) {
+    uint32_t now = ctx->wheel->now;
+    uint32_t elapsed = now - ctx->lastEngineTick;
+    uint8_t i;
+
+    ctx->lastEngineTick = now;
+
+    for (i = 0; i < NUM_LEFT_BAYS; i++) {
+        if (ctx->leftDemand[i]) {
+            ctx->leftDemand[i] = false;
+            ringPlaceCall(&ctx->engine, bayPhase[i]);
+        }
+    }
+
+    ctx->leftPermissive = fyaLatch(ctx->leftPermissive, ctx->fyaScheduled,
+                                   ringGreens(&ctx->engine));
+    ctx->engine.hold = pedHoldMask(ctx) | dzHoldMask(ctx);
+    ringStep(&ctx->engine, elapsed);
+    return handlePhaseEvents(ctx);
+}
+
+static bool handlePhaseEvents(IntersectionContext *ctx) {
+    RingEngine *eng = &ctx->engine;
+    bool changed = eng->changed;
+    uint8_t p;
+
+    /* Before the greens - coordination loads its correction first */
+    if (eng->cycleStarted) {
+        eng->cycleStarted = false;
+        coordCycleStart(&ctx->coord, eng->plan, ctx->wheel->now);
+    }
+
+    for (p = PHASE_1; p < NUM_PHASES; p++) {
+        if (eng->greenStarted & PHASE_BIT(p)) phaseGreenStart(ctx, (Phase)p);
+    }
+
+    eng->greenStarted = 0;
+    eng->greenEnded   = 0;
+    eng->changed      = false;
+    return changed;
+}
+
+/* ============================================================================
+ * MODE CONTROL
+ * ========================================================================= */
+
+/* Starts the current mode from an all-red display, or from the night flash
+ * through its all-red transition */
+static void enterMode(IntersectionContext *ctx) {
+    switch (ctx->mode) {
+        case MODE_DAYTIME:
+        case MODE_HIGH_TRAFFIC:
+            if (ctx->state != STATE_NIGHT_FLASH_ON &&
+                ctx->state != STATE_NIGHT_FLASH_OFF) {
+                startPhaseEngine(ctx, 0);
+                return;
+            }
+            ctx->state = STATE_NIGHT_TRANSITION;
+            break;
+        case MODE_NIGHT:
+            ctx->state = STATE_NIGHT_FLASH_ON;
+            break;
+        default:
+            break;
+    }
+
+    setStateTimer(ctx, getStateDuration(ctx->state));
+}
+
+/* A running phase engine is left through its clearances: it is forced off
+ * and the new mode entered once every ring is red (serviceStates) */
+static void handleModeChange(IntersectionContext *ctx, OperatingMode mode) {
+    ctx->mode = mode;
+
+    if (ctx->state == STATE_PHASE_ENGINE && !ringIdle(&ctx->engine)) {
+        ringForceOff(&ctx->engine);
+        return;
+    }
+    enterMode(ctx);
+}
+
+static void requestMode(IntersectionContext *ctx, OperatingMode mode) {
+    if (mode == ctx->mode) return;
+
+    if (preemptActive(&ctx->preempt)) {
+        /* Applied when the preemption sequence exits */
+        ctx->preempt.returnMode = mode;
+    } else {
+        handleModeChange(ctx, mode);
+        ctx->redraw = true;
+    }
+}
+
+/* ============================================================================
+ * PREEMPTION CALL HANDLER
+ * Every preemption frame lands here with the approach of the receiver that
+ * saw it. Starting a preemption forces the phase engine off (every green to
+ * its yellow), truncates pedestrian walks, and hands sequencing to
+ * preemption.c once the rings have cleared. Repeat frames only keep the
+ * call alive.
+ * Returns true if the displayed state changed.
+ * ========================================================================= */
+
+static bool handlePreemptCall(IntersectionContext *ctx, Approach approach) {
+    TrafficState entry;
+
+    if (!preemptCall(&ctx->preempt, approach, ctx->mode, ctx->state,
+                     &entry)) {
+        return false;
+    }
+
+    truncatePedWalks(ctx);
+    ctx->mode = MODE_EMERGENCY;
+
+    if (entry == STATE_PHASE_ENGINE) {
+        ringForceOff(&ctx->engine);
+        return servicePhaseEngine(ctx);
+    }
+
+    ctx->state = entry;
+    setStateTimer(ctx, getStateDuration(ctx->state));
+    return true;
+}
+
+/* ============================================================================
+ * STATE SEQUENCING
+ * Night flash, emergency and preemption states run on stateTimer. The
+ * phase engine hands over to the preemption track green once every ring
+ * has cleared.
+ * ========================================================================= */
+
+/* Times the current night / emergency / preempt state; 0 = no expiry */
+static void setStateTimer(IntersectionContext *ctx, uint32_t ms) {
+    ctx->stateExpired = false;
+    if (ms == 0) timerCancel(&ctx->stateTimer);
+    else         timerStart(ctx->wheel, &ctx->stateTimer, ms, 0);
+}
+
+static void stateTimeout(void *owner, uint8_t id) {
+    IntersectionContext *ctx = owner;
+    (void)id;
+    ctx->stateExpired = true;
+}
+
+static void advancePreempt(IntersectionContext *ctx) {
+    TrafficState next = preemptNextState(&ctx->preempt, ctx->state);
+
+    if (!preemptActive(&ctx->preempt)) {
+        /* Sequence complete - resume the plan past the preempted approach */
+        ctx->mode = ctx->preempt.returnMode;
+        if (next == STATE_PHASE_ENGINE) {
+            startPhaseEngine(ctx, preemptExitBarrier(&ctx->preempt));
+        } else {
+            ctx->state = next;
+            setStateTimer(ctx, getStateDuration(ctx->state));
+        }
+    }
+    else if (next == ctx->state) {
+        /* Track green held while the call is still present */
+        setStateTimer(ctx, TIME_PREEMPT_RECHECK);
+    }
+    else {
+        ctx->state = next;
+        setStateTimer(ctx, getStateDuration(ctx->state));
+    }
+}
+
+static void serviceStates(IntersectionContext *ctx) {
+    TrafficState next;
+
+    if (ctx->state == STATE_PHASE_ENGINE) {
+        if (servicePhaseEngine(ctx)) ctx->redraw = true;
+
+        if (!ringIdle(&ctx->engine)) return;
+
+        /* Every ring has cleared - hand over to the track green, or to the
+         * mode that forced the engine off */
+        if (preemptActive(&ctx->preempt)) {
+            ctx->state = preemptNextState(&ctx->preempt, ctx->state);
+            setStateTimer(ctx, getStateDuration(ctx->state));
+        } else {
+            enterMode(ctx);
+        }
+        ctx->redraw = true;
+        return;
+    }
+
+    if (!ctx->stateExpired) return;
+
+    /* CRITICAL: do not advance state if any pedestrian is still walking or
+     * counting down. Inside the phase engine this is a per-phase hold
+     * (pedHoldMask); here it covers the flash and preemption states.
+     * Preemption bypasses this check - safety override always wins. */
+    if (!preemptActive(&ctx->preempt) && anyPedestrianActive(ctx)) {
+        /* Re-arm with a 1 second holdover so we keep checking without
+         * spinning */
+        setStateTimer(ctx, 1000);
+        return;
+    }
+
+    ctx->stateExpired = false;
+
+    if (preemptActive(&ctx->preempt)) {
+        advancePreempt(ctx);
+    } else {
+        next = getNextState(ctx->state, ctx->mode);
+        if (next == STATE_PHASE_ENGINE) {
+            startPhaseEngine(ctx, 0);
+        } else {
+            ctx->state = next;
+            setStateTimer(ctx, getStateDuration(ctx->state));
+        }
+    }
+    ctx->redraw = true;
+}
+
+/* 1-second pedestrian and housekeeping tick */
+static void secondTick(void *owner, uint8_t id) {
+    IntersectionContext *ctx = owner;
+    uint8_t i;
+    (void)id;
+
+    for (i = 0; i < NUM_DEVICES; i++) {
+        if (ctx->pedWalkRequest[i]) {
+            /* Dropped if the phase ended since the press */
+            if (pedPhaseGreen(ctx, i)) start_walk(ctx, i, WALK_TIME_NS);
+            ctx->pedWalkRequest[i] = false;
+        }
+    }
+
+    preemptService(&ctx->preempt, 1000);
+    serviceDetectorHealth(ctx);
+    serviceLeftBays(ctx);
+    updatePedStateMachine(ctx);
+    displayPedState(ctx);
+}
+
+/* ============================================================================
+ * SETUP
+ * ========================================================================= */
+
+/* The board is up and `wheel` initialised; shows all red and the stop
+ * hands until ctlStart() */
+void ctlInit(IntersectionContext *ctx, const CtlBindings *hw, void *board,
+             TimerWheel *wheel, DetLog *detLog) {
+    uint8_t i;
+
+    ctx->hw     = hw;
+    ctx->board  = board;
+    ctx->wheel  = wheel;
+    ctx->detLog = detLog;
+
+    ctx->state        = STATE_PHASE_ENGINE;
+    ctx->mode         = MODE_DAYTIME;
+    ctx->redraw       = false;
+    ctx->stateExpired = false;
+    initLEDState(&ctx->leds);
+    setAllRed(&ctx->leds);
+    hw->showSignals(board, &ctx->leds);
+
+    ctx->lastEngineTick    = wheel->now;
+    ctx->planOverride      = 0;
+    ctx->fyaFlashOn        = false;
+    ctx->leftPermissive    = 0;
+    ctx->fyaScheduled      = 0;
+    ctx->minuteOfDay       = 0;
+    ctx->lastBayUpdateTick = wheel->now;
+    ctx->trapEdges         = 0;
+    ctx->failedPhases      = 0;
+
+    ringInit(&ctx->engine);
+    tspInit(&ctx->tsp);
+    preemptInit(&ctx->preempt);
+    coordInit(&ctx->coord, COORD_OFFSET_MS);
+
+    for (i = 0; i < NUM_LEFT_BAYS; i++) {
+        queueInit(&ctx->leftBay[i]);
+        healthInit(&ctx->bayHealth[i]);
+        ctx->leftDemand[i]   = false;
+        ctx->leftArrivals[i] = 0;
+        ctx->bayEdges[i]     = 0;
+    }
+    for (i = 0; i < NUM_APPROACHES; i++) dzInit(&ctx->trap[i]);
+
+    detInit(&ctx->detectors);
+    ctx->chainLive = false;
+    for (i = 0; i < NUM_DETECTORS; i++) {
+        healthInit(&ctx->chainHealth[i]);
+        ctx->chainEdges[i] = 0;
+    }
+    for (i = 0; i < NUM_PHASES; i++) ctx->phaseActuationTick[i] = 0;
+
+    for (i = 0; i < NUM_DEVICES; i++) {
+        ctx->state_walking[i]     = STATE_HAND;
+        ctx->pedWalkRequest[i]    = false;
+        ctx->pedExtendUsed[i]     = false;
+        ctx->walk_counter[i]      = 0;
+        ctx->walk_display_time[i] = 0;
+        ctx->buzzPhaseOn[i]       = false;
+        timerInit(&ctx->buzzTimer[i], buzzerTimeout, ctx, i);
+    }
+    displayPedState(ctx);
+
+    timerInit(&ctx->stateTimer, stateTimeout, ctx, 0);
+    timerInit(&ctx->secondTimer, secondTick, ctx, 0);
+    timerStart(wheel, &ctx->secondTimer, 1000, 1000);
+}
+
+void ctlStart(IntersectionContext *ctx) {
+    ctx->mode         = MODE_DAYTIME;
+    ctx->fyaScheduled = fyaPermissiveAt(ctx->minuteOfDay);
+    startPhaseEngine(ctx, 0);
+    renderSignals(ctx);
+}
+
+/* ============================================================================
+ * INPUTS
+ * ========================================================================= */
+
+/* Hall sensor edge in a left-turn bay: latched as a call on its left,
+ * counted into the queue model and the diagnostics */
+void ctlLeftArrival(IntersectionContext *ctx, LeftBay bay) {
+    ctx->leftDemand[bay] = true;
+    ctx->leftArrivals[bay]++;
+    ctx->bayEdges[bay]++;
+}
+
+void ctlSyncPulse(IntersectionContext *ctx, uint32_t tick) {
+    coordSyncPulse(&ctx->coord, tick);
+}
+
+/* RTC second boundary: master time for coordination, and the time-of-day
+ * left-turn mode */
+void ctlRtcSecond(IntersectionContext *ctx, uint32_t msOfDay,
+                  uint32_t tick) {
+    coordSetMasterTime(&ctx->coord, msOfDay, tick);
+    ctx->minuteOfDay  = (uint16_t)(msOfDay / 60000UL);
+    ctx->fyaScheduled = fyaPermissiveAt(ctx->minuteOfDay);
+}
+
+void ctlFyaFlash(IntersectionContext *ctx, bool on) {
+    ctx->fyaFlashOn = on;
+    if (ctx->state == STATE_PHASE_ENGINE && ctx->leftPermissive != 0) {
+        ctx->redraw = true;
+    }
+}
+
+/* Speed-trap edge with its trap-clock capture (DZ_TIMER_HZ) */
+void ctlTrapEdge(IntersectionContext *ctx, Approach approach,
+                 uint8_t detector, uint16_t capture) {
+    ctx->trapCapture[approach][detector] = capture;
+    ctx->trapEdges |= TRAP_EDGE(approach, detector);
+}
+
+/* Raw bytes of a finished detector chain scan */
+void ctlDetectorScan(IntersectionContext *ctx, const uint8_t *scan) {
+    detLatch(&ctx->detectors, scan);
+}
+
+/* ============================================================================
+ * TRANSIT CALL HANDLER
+ * Extends or truncates the running greens through the TSP module. When the
+ * bus approach is green only its ring is touched (extended); otherwise every
+ * green is a candidate for truncation. Ignored in night flash and during
+ * emergency - preemption always outranks a bus.
+ * ========================================================================= */
+
+void ctlTransitCall(IntersectionContext *ctx, Approach approach) {
+    RingEngine *eng = &ctx->engine;
+    uint8_t greens = 0;
+    uint32_t adjusted;
+    Phase phase;
+    uint8_t r;
+
+    if (preemptActive(&ctx->preempt)) return;
+    if (ctx->state != STATE_PHASE_ENGINE) return;
+
+    for (r = 0; r < NUM_RINGS; r++) {
+        greens |= phaseDefs[ringGreenPhase(eng, r)].approaches;
+    }
+
+    if (ringGreens(eng) == 0) {
+        /* Both rings in clearance - the call waits for the next green */
+        tspCall(&ctx->tsp, approach, 0, 0, 0);
+        return;
+    }
+
+    for (r = 0; r < NUM_RINGS; r++) {
+        phase = ringGreenPhase(eng, r);
+        if (phase == PHASE_NONE) continue;
+        if ((greens & APPROACH_BIT(approach)) &&
+            !(phaseDefs[phase].approaches & APPROACH_BIT(approach))) continue;
+
+        adjusted = tspCall(&ctx->tsp, approach, phaseDefs[phase].approaches,
+                           ringGreenElapsed(eng, r),
+                           ringGreenRemaining(eng, r));
+        ringSetGreenRemaining(eng, r, adjusted);
+    }
+}
+
+/* `from` is the approach the receiver that decoded it faces */
+void ctlCommand(IntersectionContext *ctx, CtlCommand cmd, Approach from) {
+    switch (cmd) {
+        case CMD_MODE_DAYTIME:      requestMode(ctx, MODE_DAYTIME);      break;
+        case CMD_MODE_NIGHT:        requestMode(ctx, MODE_NIGHT);        break;
+        case CMD_MODE_HIGH_TRAFFIC: requestMode(ctx, MODE_HIGH_TRAFFIC); break;
+        case CMD_PREEMPT:
+            if (handlePreemptCall(ctx, from)) ctx->redraw = true;
+            break;
+        case CMD_COORD_TOGGLE:
+            coordEnable(&ctx->coord, !ctx->coord.enabled);
+            break;
+        default:
+            break;
+    }
+}
+
+/* ============================================================================
+ * PEDESTRIAN BUTTON HANDLER
+ * Called every pass while a button is held. Two behaviors based on the
+ * current display state:
+ *
+ *   1. STATE_HAND during a green phase: queue a fresh walk request
+ *   2. STATE_WALK with extension unused: reset walk timer to full duration
+ *      (one extension per green phase per direction)
+ *
+ * Presses during STATE_COUNTDOWN are ignored - too late to extend.
+ * ========================================================================= */
+
+void ctlPedButton(IntersectionContext *ctx, uint8_t device) {
+    if (ctx->state_walking[device] == STATE_WALK &&
+        !ctx->pedExtendUsed[device]) {
+        ctx->walk_display_time[device] =
+            (device == PED_NORTH || device == PED_SOUTH) ? WALK_TIME_NS
+                                                         : WALK_TIME_EW;
+        ctx->pedExtendUsed[device] = true;
+    }
+    else if (pedPhaseGreen(ctx, device)) {
+        ctx->pedWalkRequest[device] = true;
+    }
+}
+
+/* ============================================================================
+ * STEP
+ * One main-loop pass: speed traps and detectors, then the phase engine or
+ * the timed states, then the signal heads if anything changed, then the
+ * buzzers. Due timers have already run in wheelAdvance().
+ * ========================================================================= */
+
+void ctlStep(IntersectionContext *ctx) {
+    serviceSpeedTraps(ctx);
+    serviceDetectors(ctx);
+    serviceStates(ctx);
+
+    if (ctx->redraw) {
+        ctx->redraw = false;
+        renderSignals(ctx);
+        serviceLeftBays(ctx);
+        setLeftBayGreens(ctx);
+    }
+
+    /* Starts or silences beep cycles as the ped states change */
+    serviceBuzzers(ctx);
+}
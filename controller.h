@@ -0,0 +1,215 @@
+#ifndef CONTROLLER_H
+#define CONTROLLER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "traffic_states.h"
+#include "transit_priority.h"
+#include "preemption.h"
+#include "coordination.h"
+#include "queue_model.h"
+#include "ring_engine.h"
+#include "fya.h"
+#include "dilemma_zone.h"
+#include "detector_bus.h"
+#include "detector_health.h"
+#include "timer_wheel.h"
+
+/* ============================================================================
+ * INTERSECTION CONTROLLER
+ *
+ * Everything that decides what one intersection shows - mode and state,
+ * the phase engine, left-bay queues, speed traps, detector actuation and
+ * diagnostics, preemption, transit priority, coordination, the pedestrian
+ * crosswalks and their buzzers - lives in an IntersectionContext. Nothing
+ * here touches a register, so the same code runs on the MSP430 (main.c,
+ * one instance) and on the host (host/, thousands of instances).
+ *
+ * The owner of a context supplies:
+ *
+ *   CtlBindings   the outputs of its board - signal heads, pedestrian
+ *                 displays, buzzers, bay detector level and interrupt
+ *                 mask, fault lamp. `board` is passed back to every call.
+ *   TimerWheel    the wheel its timers run on. A wheel may be shared by
+ *                 every context stepped from the same thread.
+ *   DetLog        where detector faults are logged (FRAM on the target).
+ *
+ * and drives it with the ctl*() inputs below - the main-loop side of each
+ * ISR event - followed by one ctlStep() per pass, after advancing the
+ * wheel. A context is only ever touched from one thread.
+ * ========================================================================= */
+
+/* ============================================================================
+ * PEDESTRIAN CROSSWALKS
+ * Device index to intersection direction mapping
+ * NOTE: PED_SOUTH and PED_EAST swapped from 1/2 to 2/1
+ * This corrects the physical matrix positions on the board without
+ * changing the daisy chain wiring order.
+ * ========================================================================= */
+
+#define NUM_DEVICES     4
+#define PED_NORTH       0
+#define PED_SOUTH       2
+#define PED_EAST        1
+#define PED_WEST        3
+
+/* Walk display time (seconds) before countdown begins */
+#define WALK_TIME_NS    8
+#define WALK_TIME_EW    8
+
+/* Pedestrian display images, see CtlBindings.showPeds: 0-9 are digits */
+#define PED_IMAGE_HAND  10
+#define PED_IMAGE_WALK  11
+
+typedef enum {
+    STATE_HAND,
+    STATE_WALK,
+    STATE_COUNTDOWN
+} State_walking;
+
+/* Buzzer timing in milliseconds
+ * During WALK: slow steady beep
+ * During COUNTDOWN: accelerates as counter approaches 0 */
+#define BEEP_ON_MS          40      /* beep pulse duration */
+#define GAP_WALK_MS         700     /* walk - slow steady beep */
+#define GAP_COUNTDOWN_MAX   700     /* counter == 9 -> matches walk pace */
+#define GAP_COUNTDOWN_MIN   200     /* counter == 0 -> near continuous */
+
+/* Gap between actuations that ends a green */
+#define DET_PASSAGE_MS      3000
+
+/* Log ids are the chain's Detector values, then the bays */
+#define DET_ID_BAY(b)       (NUM_DETECTORS + (b))
+
+/* ============================================================================
+ * REMOTE COMMANDS
+ * What a decoded IR frame asks for; the board maps raw codes onto these.
+ * ========================================================================= */
+
+typedef enum {
+    CMD_NONE = 0,
+    CMD_MODE_DAYTIME,
+    CMD_MODE_NIGHT,
+    CMD_MODE_HIGH_TRAFFIC,
+    CMD_PREEMPT,            /* emergency vehicle on the receiver's approach */
+    CMD_COORD_TOGGLE
+} CtlCommand;
+
+/* ============================================================================
+ * BOARD BINDINGS
+ * ========================================================================= */
+
+typedef struct {
+    void (*showSignals)(void *board, const LEDState *leds);
+    void (*showPeds)(void *board, const uint8_t image[NUM_DEVICES]);
+    void (*setBuzzer)(void *board, uint8_t device, bool on);
+    bool (*bayOccupied)(void *board, LeftBay bay);
+    void (*maskBay)(void *board, LeftBay bay, bool masked);
+    bool (*bayChattered)(void *board, LeftBay bay); /* masked itself since
+                                                       last asked */
+    void (*setFaultLamp)(void *board, bool on);
+} CtlBindings;
+
+typedef struct {
+    const CtlBindings *hw;
+    void              *board;
+    TimerWheel        *wheel;
+    DetLog            *detLog;
+
+    /* Signal state */
+    TrafficState  state;
+    OperatingMode mode;
+    LEDState      leds;
+    bool          redraw;               /* leds out of date */
+    SoftTimer     stateTimer;           /* night / emergency / preempt */
+    bool          stateExpired;
+    SoftTimer     secondTimer;          /* 1 s pedestrian + housekeeping */
+
+    /* Phase engine - DAYTIME and HIGH TRAFFIC */
+    RingEngine    engine;
+    uint32_t      lastEngineTick;
+    const PhasePlan *planOverride;      /* run instead of the mode's plan */
+
+    /* Flashing yellow arrow - leftPermissive follows fyaScheduled only
+     * while the left's through is not green (fyaLatch) */
+    bool          fyaFlashOn;
+    uint8_t       leftPermissive;
+    uint8_t       fyaScheduled;
+    uint16_t      minuteOfDay;          /* from the last RTC second */
+
+    PreemptState  preempt;
+    CoordState    coord;
+    TspState      tsp;
+
+    /* Left-turn bays */
+    BayQueue      leftBay[NUM_LEFT_BAYS];
+    bool          leftDemand[NUM_LEFT_BAYS];
+    uint16_t      leftArrivals[NUM_LEFT_BAYS];
+    uint32_t      lastBayUpdateTick;
+
+    /* Speed traps - trapCapture[][] holds the latest edge on each detector
+     * and trapEdges flags which are new (TRAP_EDGE) */
+    SpeedTrap     trap[NUM_APPROACHES];
+    uint16_t      trapCapture[NUM_APPROACHES][2];
+    uint8_t       trapEdges;
+
+    /* Detector chain and diagnostics */
+    DetectorBus   detectors;
+    bool          chainLive;            /* has produced an edge */
+    uint32_t      phaseActuationTick[NUM_PHASES];
+    DetHealth     chainHealth[NUM_DETECTORS];
+    DetHealth     bayHealth[NUM_LEFT_BAYS];
+    uint16_t      chainEdges[NUM_DETECTORS];
+    uint16_t      bayEdges[NUM_LEFT_BAYS];
+    uint16_t      failedPhases;         /* on max recall */
+
+    /* Pedestrians */
+    State_walking state_walking[NUM_DEVICES];
+    uint8_t       walk_counter[NUM_DEVICES];
+    uint8_t       walk_display_time[NUM_DEVICES];
+    bool          pedWalkRequest[NUM_DEVICES];  /* cleared on the 1s tick */
+    bool          pedExtendUsed[NUM_DEVICES];   /* one extension per green */
+
+    /* Buzzers - buzzPhaseOn: in the BEEP_ON_MS pulse, else in the gap */
+    SoftTimer     buzzTimer[NUM_DEVICES];
+    bool          buzzPhaseOn[NUM_DEVICES];
+} IntersectionContext;
+
+#define TRAP_UP             0
+#define TRAP_DOWN           1
+#define TRAP_EDGE(a, d)     ((uint8_t)(1u << ((a) * 2 + (d))))
+
+extern const Phase pedPhase[NUM_DEVICES];
+extern const Phase bayPhase[NUM_LEFT_BAYS];
+extern const Phase trapPhase[NUM_APPROACHES];
+extern const Phase detectorPhase[NUM_DETECTORS];
+
+/* ============================================================================
+ * FUNCTION PROTOTYPES
+ * ========================================================================= */
+
+/* Setup - ctlStart() once the board is running */
+void ctlInit(IntersectionContext *ctx, const CtlBindings *hw, void *board,
+             TimerWheel *wheel, DetLog *detLog);
+void ctlStart(IntersectionContext *ctx);
+
+/* Inputs */
+void ctlLeftArrival(IntersectionContext *ctx, LeftBay bay);
+void ctlSyncPulse(IntersectionContext *ctx, uint32_t tick);
+void ctlRtcSecond(IntersectionContext *ctx, uint32_t msOfDay, uint32_t tick);
+void ctlFyaFlash(IntersectionContext *ctx, bool on);
+void ctlTrapEdge(IntersectionContext *ctx, Approach approach,
+                 uint8_t detector, uint16_t capture);
+void ctlDetectorScan(IntersectionContext *ctx, const uint8_t *scan);
+void ctlTransitCall(IntersectionContext *ctx, Approach approach);
+void ctlCommand(IntersectionContext *ctx, CtlCommand cmd, Approach from);
+void ctlPedButton(IntersectionContext *ctx, uint8_t device);
+
+/* One main-loop pass, after wheelAdvance() */
+void ctlStep(IntersectionContext *ctx);
+
+/* Queries */
+bool anyPedestrianActive(const IntersectionContext *ctx);
+bool pedPhaseGreen(const IntersectionContext *ctx, uint8_t device);
+
+#endif /* CONTROLLER_H */
@@ -0,0 +1,136 @@
+#include "coordination.h"
+#include "ring_engine.h"
+
+/* ============================================================================
+ * HELPERS
+ * ========================================================================= */
+
+static void clearAdjust(CoordState *coord) {
+    uint8_t r;
+    for (r = 0; r < NUM_RINGS; r++) {
+        coord->cycleAdjust[r] = 0;
+        coord->greenLeft[r]   = 0;
+    }
+}
+
+/* ============================================================================
+ * PUBLIC API
+ * ========================================================================= */
+
+void coordInit(CoordState *coord, uint32_t offset) {
+    coord->enabled       = false;
+    coord->timeValid     = false;
+    coord->pulseSeen     = false;
+    coord->offset        = offset;
+    coord->masterRefMs   = 0;
+    coord->masterRefTick = 0;
+    coord->lastPulseTick = 0;
+    clearAdjust(coord);
+}
+
+void coordEnable(CoordState *coord, bool on) {
+    coord->enabled = on;
+    clearAdjust(coord);
+}
+
+/* RTC time, latched at the start of an RTC second */
+void coordSetMasterTime(CoordState *coord, uint32_t msOfDay, uint32_t tick) {
+    if (coord->pulseSeen &&
+        (tick - coord->lastPulseTick) < COORD_PULSE_TIMEOUT_MS) {
+        return;     /* sync pulse is the better reference */
+    }
+    coord->pulseSeen     = false;
+    coord->masterRefMs   = msOfDay;
+    coord->masterRefTick = tick;
+    coord->timeValid     = true;
+}
+
+/* Sync pulse: this instant is master cycle zero */
+void coordSyncPulse(CoordState *coord, uint32_t tick) {
+    coord->masterRefMs   = 0;
+    coord->masterRefTick = tick;
+    coord->lastPulseTick = tick;
+    coord->pulseSeen     = true;
+    coord->timeValid     = true;
+}
+
+/* Signed error of a cycle starting now: > 0 means the cycle should be
+ * shortened by that many ms, < 0 lengthened. Smooth-transition limits are
+ * already applied. */
+int32_t coordCycleError(const CoordState *coord, uint32_t cycle,
+                        uint32_t tick) {
+    uint32_t master, pos, late, early, maxShort, maxLong;
+    uint32_t shortCycles, longCycles;
+
+    if (cycle == 0) return 0;
+
+    master = (coord->masterRefMs + (tick - coord->masterRefTick))
+             % COORD_MS_PER_DAY;
+    pos    = (master % cycle + cycle - coord->offset % cycle) % cycle;
+
+    late  = pos;            /* started this far after the target point */
+    early = cycle - pos;    /* or this far before the next one */
+
+    if (late <= COORD_SYNC_TOLERANCE_MS || early <= COORD_SYNC_TOLERANCE_MS) {
+        return 0;
+    }
+
+    maxShort = (cycle * COORD_MAX_SHORTEN_PCT) / 100;
+    maxLong  = (cycle * COORD_MAX_LENGTHEN_PCT) / 100;
+
+    shortCycles = (late  + maxShort - 1) / maxShort;
+    longCycles  = (early + maxLong  - 1) / maxLong;
+
+    if (shortCycles <= longCycles) {
+        return (int32_t)((late < maxShort) ? late : maxShort);
+    }
+    return -(int32_t)((early < maxLong) ? early : maxLong);
+}
+
+/* Called on the engine's cycleStarted event: measures the error and loads
+ * the correction for both rings */
+void coordCycleStart(CoordState *coord, const PhasePlan *plan,
+                     uint32_t tick) {
+    int32_t adjust;
+    uint8_t r;
+
+    if (!coord->enabled || !coord->timeValid) return;
+
+    adjust = coordCycleError(coord, ringPlanCycleLength(plan), tick);
+    for (r = 0; r < NUM_RINGS; r++) {
+        coord->cycleAdjust[r] = adjust;
+        coord->greenLeft[r]   = ringPlanThroughGreen(plan, r);
+    }
+}
+
+/* Adjusts a green as it starts; through greens absorb their ring's share
+ * of the correction */
+uint32_t coordGreenTime(CoordState *coord, Phase phase, uint32_t duration) {
+    uint8_t ring = phaseDefs[phase].ring;
+    int32_t share;
+    uint32_t room;
+    uint32_t base = duration;
+
+    if (!coord->enabled || !coord->timeValid) return duration;
+    if (phaseDefs[phase].approaches == 0 || coord->greenLeft[ring] == 0) {
+        return duration;
+    }
+
+    /* This green's proportional share of the remaining correction */
+    share = (int32_t)(((int64_t)coord->cycleAdjust[ring] * (int64_t)base) /
+                      (int64_t)coord->greenLeft[ring]);
+
+    if (share > 0) {
+        /* shorten, but never below the coordinated minimum green */
+        room = (duration > COORD_MIN_GREEN) ? duration - COORD_MIN_GREEN : 0;
+        if ((uint32_t)share > room) share = (int32_t)room;
+        duration -= (uint32_t)share;
+    } else {
+        duration += (uint32_t)(-share);
+    }
+
+    coord->cycleAdjust[ring] -= share;
+    coord->greenLeft[ring]    = (coord->greenLeft[ring] > base)
+                                ? coord->greenLeft[ring] - base : 0;
+    return duration;
+}
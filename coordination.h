@@ -0,0 +1,69 @@
+#ifndef COORDINATION_H
+#define COORDINATION_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "traffic_states.h"
+
+/* ============================================================================
+ * COORDINATED OPERATION
+ *
+ * Locks the DAYTIME / HIGH_TRAFFIC phase-engine cycle to a master clock so
+ * that the cycle's reference point (the crossing into barrier 0, i.e. the
+ * start of the N/S phases) lands at
+ *
+ *     master time == COORD_OFFSET_MS   (mod cycle length)
+ *
+ * Master time comes from the RTC (ms of day, latched on the RTC second
+ * interrupt) or, when an upstream controller provides one, from the sync
+ * pulse input, which marks master cycle zero. A pulse seen within the last
+ * COORD_PULSE_TIMEOUT_MS takes precedence over the RTC.
+ *
+ * The RTC has no backup supply. It keeps its time across a watchdog or
+ * software reset, but after a power loss it restarts at 00:00:00 until it
+ * is set from the IR clock keys (main.c). Until then, without a sync
+ * pulse, master time is only time since power-up, and the offsets of
+ * controllers along a corridor line up with nothing. The time-of-day
+ * schedules (fya.h) are wrong for the same reason.
+ *
+ * At each cycle start the cycle position error is measured and corrected
+ * smoothly: the error is closed either by shortening (at most
+ * COORD_MAX_SHORTEN_PCT of the cycle per cycle) or by lengthening (at most
+ * COORD_MAX_LENGTHEN_PCT), whichever needs fewer cycles. Both rings carry
+ * the full per-cycle correction, each spreading it across its own through
+ * greens in proportion to their length, never below COORD_MIN_GREEN.
+ * Clearances are untouched.
+ * ========================================================================= */
+
+#define COORD_OFFSET_MS            0
+#define COORD_SYNC_TOLERANCE_MS    250
+#define COORD_MAX_SHORTEN_PCT      20
+#define COORD_MAX_LENGTHEN_PCT     17
+#define COORD_MIN_GREEN            7000
+#define COORD_PULSE_TIMEOUT_MS     600000UL
+#define COORD_MS_PER_DAY           86400000UL
+
+typedef struct {
+    bool     enabled;
+    bool     timeValid;         /* master reference has been set */
+    bool     pulseSeen;
+    uint32_t offset;            /* ms after master cycle zero */
+    uint32_t masterRefMs;       /* master time at masterRefTick */
+    uint32_t masterRefTick;     /* ms tick when masterRefMs was valid */
+    uint32_t lastPulseTick;
+    int32_t  cycleAdjust[NUM_RINGS];  /* correction still to spread */
+    uint32_t greenLeft[NUM_RINGS];    /* through-green ms left this cycle */
+} CoordState;
+
+void     coordInit(CoordState *coord, uint32_t offset);
+void     coordEnable(CoordState *coord, bool on);
+void     coordSetMasterTime(CoordState *coord, uint32_t msOfDay,
+                            uint32_t tick);
+void     coordSyncPulse(CoordState *coord, uint32_t tick);
+int32_t  coordCycleError(const CoordState *coord, uint32_t cycle,
+                         uint32_t tick);
+void     coordCycleStart(CoordState *coord, const PhasePlan *plan,
+                         uint32_t tick);
+uint32_t coordGreenTime(CoordState *coord, Phase phase, uint32_t duration);
+
+#endif /* COORDINATION_H */
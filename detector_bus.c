@@ -0,0 +1,46 @@
+#include "detector_bus.h"
+
+void detInit(DetectorBus *bus) {
+    uint8_t i;
+    for (i = 0; i < DET_CHAIN_DEVICES; i++) {
+        bus->occupied[i] = 0;
+        bus->rose[i]     = 0;
+        bus->fell[i]     = 0;
+    }
+    bus->scanned = false;
+}
+
+/* Called from the main loop with the raw chain bytes of a finished scan */
+void detLatch(DetectorBus *bus, const uint8_t *scan) {
+    uint8_t now, changed;
+    uint8_t i;
+
+    for (i = 0; i < DET_CHAIN_DEVICES; i++) {
+        now     = (uint8_t)~scan[i];
+        changed = bus->scanned ? (uint8_t)(now ^ bus->occupied[i]) : 0;
+
+        bus->rose[i]    |= (uint8_t)(changed & now);
+        bus->fell[i]    |= (uint8_t)(changed & ~now);
+        bus->occupied[i] = now;
+    }
+    bus->scanned = true;
+}
+
+/* Copies out and clears the edges accumulated since the last call */
+void detTakeEdges(DetectorBus *bus, uint8_t *rose, uint8_t *fell) {
+    uint8_t i;
+    for (i = 0; i < DET_CHAIN_DEVICES; i++) {
+        rose[i] = bus->rose[i];
+        fell[i] = bus->fell[i];
+        bus->rose[i] = 0;
+        bus->fell[i] = 0;
+    }
+}
+
+bool detOccupied(const DetectorBus *bus, Detector det) {
+    return (bus->occupied[DET_BYTE(det)] & DET_MASK(det)) != 0;
+}
+
+bool detEdge(const uint8_t *edges, Detector det) {
+    return (edges[DET_BYTE(det)] & DET_MASK(det)) != 0;
+}
@@ -0,0 +1,60 @@
+#ifndef DETECTOR_BUS_H
+#define DETECTOR_BUS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* ============================================================================
+ * DETECTOR INPUT CHAIN (74HC165)
+ *
+ * Up to DET_NUM_INPUTS vehicle detectors are read through a chain of
+ * parallel-in / serial-out 74HC165s. main.c pulses SH/LD and clocks the
+ * chain out over eUSCI_A1 SPI every DET_SCAN_PERIOD_MS, with DMA moving the
+ * bytes into a RAM scan buffer; the CPU only sees the end-of-scan DMA
+ * interrupt, after which the main loop hands the buffer to detLatch().
+ *
+ * Inputs are active LOW (pull-ups, detector output pulls the line down)
+ * and are inverted on latch, so a set bit always means "occupied". Edges
+ * are found by XORing each scan against the previous one and accumulate
+ * until the main loop takes them.
+ *
+ * Byte 0 of the scan is the 74HC165 nearest the MCU (first out of the
+ * chain); bit 7 of each byte is its H input.
+ * ========================================================================= */
+
+#define DET_CHAIN_DEVICES       4
+#define DET_NUM_INPUTS          (DET_CHAIN_DEVICES * 8)
+#define DET_SCAN_PERIOD_MS      4
+
+typedef enum {
+    DET_N_THRU = 0,         /* chip 0 */
+    DET_N_THRU_ADVANCE,
+    DET_S_THRU,
+    DET_S_THRU_ADVANCE,
+    DET_S_RIGHT,
+    DET_E_THRU,
+    DET_E_THRU_ADVANCE,
+    DET_E_LEFT,
+    DET_W_THRU,             /* chip 1 */
+    DET_W_THRU_ADVANCE,
+    DET_W_RIGHT,
+    NUM_DETECTORS           /* chips 1 (rest) to 3: spare */
+} Detector;
+
+#define DET_BYTE(d)     ((d) / 8)
+#define DET_MASK(d)     ((uint8_t)(1u << ((d) % 8)))
+
+typedef struct {
+    uint8_t occupied[DET_CHAIN_DEVICES];
+    uint8_t rose[DET_CHAIN_DEVICES];    /* since the last detTakeEdges() */
+    uint8_t fell[DET_CHAIN_DEVICES];
+    bool    scanned;                    /* at least one scan latched */
+} DetectorBus;
+
+void detInit(DetectorBus *bus);
+void detLatch(DetectorBus *bus, const uint8_t *scan);
+void detTakeEdges(DetectorBus *bus, uint8_t *rose, uint8_t *fell);
+bool detOccupied(const DetectorBus *bus, Detector det);
+bool detEdge(const uint8_t *edges, Detector det);
+
+#endif /* DETECTOR_BUS_H */
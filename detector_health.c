@@ -0,0 +1,80 @@
+#include "detector_health.h"
+
+void healthInit(DetHealth *h) {
+    h->status     = DET_OK;
+    h->presenceMs = 0;
+    h->quietMs    = 0;
+    h->retryMs    = 0;
+}
+
+/* Called once per DET_HEALTH_PERIOD_MS with the edges seen in that period
+ * and the input's current level. Returns the (possibly new) status. */
+DetStatus healthUpdate(DetHealth *h, uint16_t edges, bool occupied,
+                       uint32_t elapsedMs) {
+    /* Masked - nothing to judge until the retry */
+    if (h->status == DET_FAIL_CHATTER) {
+        if (h->retryMs > elapsedMs) {
+            h->retryMs -= elapsedMs;
+            return h->status;
+        }
+        healthInit(h);
+        return h->status;
+    }
+
+    if (edges >= DET_CHATTER_EDGES) {
+        h->status  = DET_FAIL_CHATTER;
+        h->retryMs = DET_CHATTER_RETRY_MS;
+        return h->status;
+    }
+
+    if (edges > 0) {
+        h->quietMs = 0;
+        if (h->status == DET_FAIL_NO_ACTIVITY) h->status = DET_OK;
+    } else {
+        h->quietMs += elapsedMs;
+    }
+
+    if (occupied) {
+        h->presenceMs += elapsedMs;
+    } else {
+        h->presenceMs = 0;
+        if (h->status == DET_FAIL_MAX_PRESENCE) h->status = DET_OK;
+    }
+
+    if (h->presenceMs >= DET_MAX_PRESENCE_MS) {
+        h->status = DET_FAIL_MAX_PRESENCE;
+    }
+    else if (h->quietMs >= DET_NO_ACTIVITY_MS && h->status == DET_OK) {
+        h->status = DET_FAIL_NO_ACTIVITY;
+    }
+    return h->status;
+}
+
+/* The input's ISR masked it: fail as chattering, or restart the retry, in
+ * place of the period's healthUpdate() */
+void healthChatter(DetHealth *h) {
+    h->status     = DET_FAIL_CHATTER;
+    h->retryMs    = DET_CHATTER_RETRY_MS;
+    h->presenceMs = 0;
+    h->quietMs    = 0;
+}
+
+bool healthFailed(const DetHealth *h) {
+    return h->status != DET_OK;
+}
+
+bool healthMasked(const DetHealth *h) {
+    return h->status == DET_FAIL_CHATTER;
+}
+
+void healthLog(DetLog *log, uint8_t detector, DetStatus status,
+               uint16_t minuteOfDay) {
+    DetLogEntry *e = &log->entry[log->next];
+
+    e->detector    = detector;
+    e->status      = (uint8_t)status;
+    e->minuteOfDay = minuteOfDay;
+
+    log->next = (uint8_t)((log->next + 1) % DET_LOG_SIZE);
+    if (log->count < UINT16_MAX) log->count++;
+}
@@ -0,0 +1,70 @@
+#ifndef DETECTOR_HEALTH_H
+#define DETECTOR_HEALTH_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* ============================================================================
+ * DETECTOR DIAGNOSTICS
+ *
+ * Every detector (left-bay Hall sensors and the 74HC165 chain) is checked
+ * once per DET_HEALTH_PERIOD_MS against three faults:
+ *
+ *   MAX PRESENCE  occupied without a break for DET_MAX_PRESENCE_MS
+ *                 (stuck on / shorted); clears when the input releases
+ *   NO ACTIVITY   no edge for DET_NO_ACTIVITY_MS (dead / open); clears on
+ *                 the next edge
+ *   CHATTER       DET_CHATTER_EDGES or more edges in one period (noise,
+ *                 bouncing contact), or the input's ISR masked itself on
+ *                 its own count (healthChatter). The input's interrupt is
+ *                 masked and retried after DET_CHATTER_RETRY_MS
+ *
+ * While a detector is failed its phase falls back to max recall: it is
+ * called every cycle and runs its full split, and the failed input is
+ * ignored. Each failure and recovery is appended to a DetLog, which main.c
+ * keeps in FRAM so it survives a reset.
+ * ========================================================================= */
+
+#define DET_HEALTH_PERIOD_MS        1000
+#define DET_MAX_PRESENCE_MS       180000UL      /* 3 min */
+#define DET_NO_ACTIVITY_MS       1800000UL      /* 30 min */
+#define DET_CHATTER_EDGES             20
+#define DET_CHATTER_RETRY_MS       60000UL
+#define DET_LOG_SIZE                  16
+
+typedef enum {
+    DET_OK = 0,
+    DET_FAIL_MAX_PRESENCE,
+    DET_FAIL_NO_ACTIVITY,
+    DET_FAIL_CHATTER
+} DetStatus;
+
+typedef struct {
+    DetStatus status;
+    uint32_t  presenceMs;       /* continuous occupancy */
+    uint32_t  quietMs;          /* since the last edge */
+    uint32_t  retryMs;          /* until a chattering input is unmasked */
+} DetHealth;
+
+typedef struct {
+    uint8_t  detector;
+    uint8_t  status;            /* DetStatus, DET_OK = recovered */
+    uint16_t minuteOfDay;
+} DetLogEntry;
+
+typedef struct {
+    DetLogEntry entry[DET_LOG_SIZE];
+    uint8_t     next;           /* oldest entry once the log has wrapped */
+    uint16_t    count;          /* entries ever written */
+} DetLog;
+
+void      healthInit(DetHealth *h);
+DetStatus healthUpdate(DetHealth *h, uint16_t edges, bool occupied,
+                       uint32_t elapsedMs);
+void      healthChatter(DetHealth *h);
+bool      healthFailed(const DetHealth *h);
+bool      healthMasked(const DetHealth *h);
+void      healthLog(DetLog *log, uint8_t detector, DetStatus status,
+                    uint16_t minuteOfDay);
+
+#endif /* DETECTOR_HEALTH_H */
@@ -0,0 +1,94 @@
+#include "dilemma_zone.h"
+
+/* ============================================================================
+ * HELPERS
+ * ========================================================================= */
+
+/* True if tick `a` is later than tick `b` (wrap-safe) */
+static bool tickAfter(uint32_t a, uint32_t b) {
+    return (int32_t)(a - b) > 0;
+}
+
+/* ============================================================================
+ * PUBLIC API
+ * ========================================================================= */
+
+void dzInit(SpeedTrap *trap) {
+    trap->upCapture     = 0;
+    trap->armed         = false;
+    trap->speedMmS      = 0;
+    trap->arrivalTick   = 0;
+    trap->zoneClearTick = 0;
+    trap->holding       = false;
+    trap->holdStartTick = 0;
+}
+
+void dzUpstream(SpeedTrap *trap, uint16_t capture) {
+    trap->upCapture = capture;
+    trap->armed     = true;
+}
+
+/* Pairs the downstream edge with the last upstream one. Returns true if a
+ * speed was measured; `now` is the ms tick of the downstream edge. */
+bool dzDownstream(SpeedTrap *trap, uint16_t capture, uint32_t now) {
+    uint16_t ticks;
+    uint32_t speed, travelMs;
+
+    if (!trap->armed) return false;
+    trap->armed = false;
+
+    ticks = (uint16_t)(capture - trap->upCapture);
+    if (ticks == 0) return false;
+
+    speed = (DZ_TRAP_SPACING_MM * DZ_TRAP_TIMER_HZ) / ticks;
+    if (speed < DZ_MIN_SPEED_MM_S) return false;
+    if (speed > UINT16_MAX) speed = UINT16_MAX;
+
+    trap->speedMmS    = (uint16_t)speed;
+    travelMs          = (DZ_TRAP_SETBACK_MM * 1000UL) / speed;
+    trap->arrivalTick = now + travelMs;
+
+    /* Already closer than the near edge - it clears on the yellow */
+    if (travelMs > DZ_ZONE_NEAR_MS &&
+        tickAfter(now + travelMs - DZ_ZONE_NEAR_MS, trap->zoneClearTick)) {
+        trap->zoneClearTick = now + travelMs - DZ_ZONE_NEAR_MS;
+    }
+    return true;
+}
+
+/* A measured vehicle has yet to pass the near edge of the zone */
+bool dzOccupied(const SpeedTrap *trap, uint32_t now) {
+    return tickAfter(trap->zoneClearTick, now);
+}
+
+/* Called each pass while the approach is green; `due` once the green would
+ * otherwise end. Returns true while termination should wait. */
+bool dzHoldGreen(SpeedTrap *trap, bool due, uint32_t now) {
+    if (!due) {
+        trap->holding = false;
+        return false;
+    }
+    if (!trap->holding) {
+        trap->holding       = true;
+        trap->holdStartTick = now;
+    }
+    if (now - trap->holdStartTick >= DZ_MAX_HOLD_MS) return false;
+    return dzOccupied(trap, now);
+}
+
+/* The last measured vehicle could not stop before the line */
+bool dzCannotStop(const SpeedTrap *trap) {
+    uint32_t v = trap->speedMmS;
+    uint32_t stopping = (v * DZ_REACTION_MS) / 1000 +
+                        (v * v) / (2UL * DZ_DECEL_MM_S2);
+    return stopping > DZ_TRAP_SETBACK_MM;
+}
+
+/* Red clearance still needed for the last vehicle to cross the box */
+uint32_t dzRunnerClearance(const SpeedTrap *trap, uint32_t now) {
+    uint32_t clear = DZ_RUNNER_CLEAR_MS;
+
+    if (tickAfter(trap->arrivalTick, now)) clear += trap->arrivalTick - now;
+    if (clear > DZ_MAX_RED_EXTENSION_MS) clear = DZ_MAX_RED_EXTENSION_MS;
+    return clear;
+}
@@ -0,0 +1,62 @@
+#ifndef DILEMMA_ZONE_H
+#define DILEMMA_ZONE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* ============================================================================
+ * DILEMMA-ZONE PROTECTION (two-detector speed traps)
+ *
+ * Each approach has an upstream and a downstream detector DZ_TRAP_SPACING_MM
+ * apart, DZ_TRAP_SETBACK_MM ahead of the stop line. Both edges are
+ * timestamped on the trap timer (DZ_TRAP_TIMER_HZ, see main.c), and the
+ * time between them gives the vehicle's speed and hence when it reaches
+ * the stop line.
+ *
+ * A vehicle is in the dilemma zone while it is between DZ_ZONE_FAR_MS and
+ * DZ_ZONE_NEAR_MS from the stop line: too close to stop comfortably, too
+ * far to clear on the yellow. When the approach's green is due to end the
+ * controller holds it until every measured vehicle has left the zone, but
+ * never for more than DZ_MAX_HOLD_MS (max-out).
+ *
+ * A vehicle crossing the downstream detector after the green has ended,
+ * too fast to stop before the line (reaction + DZ_DECEL_MM_S2 braking), is
+ * taken as a red-light runner: the red clearance is extended until it has
+ * crossed, by at most DZ_MAX_RED_EXTENSION_MS.
+ *
+ * Only one vehicle per trap is tracked between detectors; an upstream edge
+ * with no downstream edge within the DZ_MIN_SPEED_MM_S travel time is
+ * dropped.
+ * ========================================================================= */
+
+#define DZ_TRAP_SPACING_MM          4000
+#define DZ_TRAP_SETBACK_MM         60000
+#define DZ_TRAP_TIMER_HZ           15625UL      /* SMCLK / 64 */
+#define DZ_MIN_SPEED_MM_S           4000
+#define DZ_ZONE_FAR_MS              5500
+#define DZ_ZONE_NEAR_MS             2500
+#define DZ_MAX_HOLD_MS             10000
+#define DZ_REACTION_MS              1000
+#define DZ_DECEL_MM_S2              3000
+#define DZ_RUNNER_CLEAR_MS          2000        /* stop line to clear of the box */
+#define DZ_MAX_RED_EXTENSION_MS     4000
+
+typedef struct {
+    uint16_t upCapture;         /* trap timer at the upstream edge */
+    bool     armed;             /* waiting for the downstream edge */
+    uint16_t speedMmS;          /* last measured vehicle */
+    uint32_t arrivalTick;       /* ms tick it reaches the stop line */
+    uint32_t zoneClearTick;     /* ms tick the last vehicle leaves the zone */
+    bool     holding;           /* green due and being held */
+    uint32_t holdStartTick;
+} SpeedTrap;
+
+void     dzInit(SpeedTrap *trap);
+void     dzUpstream(SpeedTrap *trap, uint16_t capture);
+bool     dzDownstream(SpeedTrap *trap, uint16_t capture, uint32_t now);
+bool     dzOccupied(const SpeedTrap *trap, uint32_t now);
+bool     dzHoldGreen(SpeedTrap *trap, bool due, uint32_t now);
+bool     dzCannotStop(const SpeedTrap *trap);
+uint32_t dzRunnerClearance(const SpeedTrap *trap, uint32_t now);
+
+#endif /* DILEMMA_ZONE_H */
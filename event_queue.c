@@ -0,0 +1,47 @@
+#include "event_queue.h"
+
+/* Called before interrupts are enabled */
+void evqInit(EventQueue *q) {
+    q->head    = 0;
+    q->tail    = 0;
+    q->dropped = 0;
+}
+
+/* Interrupt context only. Returns false if the queue was full. */
+bool evqPush(EventQueue *q, EventType type, uint8_t arg, uint16_t data,
+             uint32_t tick) {
+    uint8_t head = q->head;
+    uint8_t next = (uint8_t)((head + 1) & EVQ_MASK);
+    volatile Event *e;
+
+    if (next == q->tail) {
+        if (q->dropped < UINT16_MAX) q->dropped++;
+        return false;
+    }
+
+    e = &q->slot[head];
+    e->type = (uint8_t)type;
+    e->arg  = arg;
+    e->data = data;
+    e->tick = tick;
+
+    q->head = next;                 /* publish */
+    return true;
+}
+
+/* Main loop only. Returns false once the queue is empty. */
+bool evqPop(EventQueue *q, Event *ev) {
+    uint8_t tail = q->tail;
+    volatile Event *e;
+
+    if (tail == q->head) return false;
+
+    e = &q->slot[tail];
+    ev->type = e->type;
+    ev->arg  = e->arg;
+    ev->data = e->data;
+    ev->tick = e->tick;
+
+    q->tail = (uint8_t)((tail + 1) & EVQ_MASK);    /* release */
+    return true;
+}
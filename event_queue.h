@@ -0,0 +1,67 @@
+#ifndef EVENT_QUEUE_H
+#define EVENT_QUEUE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* ============================================================================
+ * ISR-TO-MAIN EVENT QUEUE
+ *
+ * The channel from the interrupt handlers to the controller. An ISR
+ * records what happened (an edge, a pulse, a completed scan) with
+ * evqPush() and returns; the main loop drains the queue with evqPop() and
+ * owns every piece of controller state, so none of it needs to be volatile
+ * or guarded by disabling interrupts.
+ *
+ * Single producer, single consumer, no locks:
+ *
+ *   producer  interrupt context. MSP430 ISRs run with GIE clear and do not
+ *             nest, so all ISRs together are one producer - only `head` is
+ *             written there
+ *   consumer  the main loop - only `tail` is written there
+ *
+ * Both indices are single bytes, so every load and store is atomic. The
+ * producer fills a slot before publishing it by advancing `head`; the
+ * consumer copies a slot out before releasing it by advancing `tail`. The
+ * slots and indices are volatile so the compiler keeps that order.
+ *
+ * IR capture edges, which come too fast for one queue shared by every
+ * source, have a queue of the same kind per receiver (ir_decode.h).
+ *
+ * EVQ_SIZE must be a power of two; one slot is kept empty to tell full from
+ * empty. A push into a full queue is dropped and counted in `dropped`.
+ * ========================================================================= */
+
+#define EVQ_SIZE        32
+#define EVQ_MASK        (EVQ_SIZE - 1)
+
+typedef enum {
+    EV_NONE = 0,
+    EV_LEFT_ARRIVAL,    /* arg = LeftBay */
+    EV_SYNC_PULSE,      /* tick = tbMillis() at the pulse */
+    EV_RTC_SECOND,      /* tick = tbMillis() at the RTC update */
+    EV_FYA_FLASH,       /* arg = flash now on */
+    EV_TRAP_EDGE,       /* arg = TRAP_EDGE bit index, data = Timer_A3 count */
+    EV_DET_SCAN         /* detector chain scan buffer filled */
+} EventType;
+
+typedef struct {
+    uint8_t  type;      /* EventType */
+    uint8_t  arg;
+    uint16_t data;
+    uint32_t tick;
+} Event;
+
+typedef struct {
+    volatile Event    slot[EVQ_SIZE];
+    volatile uint8_t  head;         /* next slot to fill - producer */
+    volatile uint8_t  tail;         /* next slot to read - consumer */
+    volatile uint16_t dropped;      /* pushes lost to a full queue */
+} EventQueue;
+
+void evqInit(EventQueue *q);
+bool evqPush(EventQueue *q, EventType type, uint8_t arg, uint16_t data,
+             uint32_t tick);
+bool evqPop(EventQueue *q, Event *ev);
+
+#endif /* EVENT_QUEUE_H */
@@ -0,0 +1,97 @@
+#include "fya.h"
+
+/* ============================================================================
+ * TIME-OF-DAY SCHEDULE
+ * Entries in ascending startMinute; the first must start at minute 0.
+ * Lefts are protected only through the AM and PM peaks, when opposing
+ * through volumes leave few usable gaps.
+ * ========================================================================= */
+
+#define FYA_BOTH    (APPROACH_BIT(APPROACH_NORTH) | APPROACH_BIT(APPROACH_SOUTH))
+
+static const FyaScheduleEntry fyaSchedule[] = {
+    {    0,          FYA_BOTH },
+    {  7 * 60,       0        },    /* AM peak */
+    {  9 * 60,       FYA_BOTH },
+    { 16 * 60,       0        },    /* PM peak */
+    { 18 * 60 + 30,  FYA_BOTH }
+};
+
+#define FYA_SCHEDULE_LEN  (sizeof(fyaSchedule) / sizeof(fyaSchedule[0]))
+
+/* ============================================================================
+ * HEADS
+ * ========================================================================= */
+
+typedef struct {
+    Approach approach;
+    Phase    left;          /* protected left */
+    Phase    through;       /* adjacent through - the permissive window */
+    uint8_t  red;
+    uint8_t  yellow;
+    uint8_t  ball;
+} FyaHead;
+
+static const FyaHead fyaHeads[] = {
+    { APPROACH_NORTH, PHASE_1, PHASE_2,
+      N_COMBO_RED, N_COMBO_YELLOW, N_COMBO_GREEN },
+    { APPROACH_SOUTH, PHASE_5, PHASE_6,
+      S_COMBO_RED, S_COMBO_YELLOW, S_COMBO_GREEN }
+};
+
+#define FYA_NUM_HEADS  (sizeof(fyaHeads) / sizeof(fyaHeads[0]))
+
+/* ============================================================================
+ * PUBLIC API
+ * ========================================================================= */
+
+uint8_t fyaPermissiveAt(uint16_t minuteOfDay) {
+    uint8_t permissive = fyaSchedule[0].permissive;
+    uint8_t i;
+
+    for (i = 1; i < FYA_SCHEDULE_LEN; i++) {
+        if (minuteOfDay < fyaSchedule[i].startMinute) break;
+        permissive = fyaSchedule[i].permissive;
+    }
+    return permissive;
+}
+
+/* Mode to show: `scheduled` for every left whose through is not in
+ * `greens`, otherwise the mode `shown` now */
+uint8_t fyaLatch(uint8_t shown, uint8_t scheduled, uint16_t greens) {
+    uint8_t mask;
+    uint8_t i;
+
+    for (i = 0; i < FYA_NUM_HEADS; i++) {
+        if (greens & PHASE_BIT(fyaHeads[i].through)) continue;
+
+        mask  = APPROACH_BIT(fyaHeads[i].approach);
+        shown = (uint8_t)((shown & ~mask) | (scheduled & mask));
+    }
+    return shown;
+}
+
+/* Rewrites the combo heads of a phase-engine frame during the permissive
+ * window. `greens` is the engine's green phase mask. */
+void fyaApply(LEDState *state, uint16_t greens, uint8_t permissive,
+              bool flashOn) {
+    const FyaHead *h;
+    uint8_t i;
+
+    for (i = 0; i < FYA_NUM_HEADS; i++) {
+        h = &fyaHeads[i];
+
+        if (!(greens & PHASE_BIT(h->through))) continue;
+        if (greens & PHASE_BIT(h->left)) continue;
+
+        setLED(state, h->ball, false);
+
+        if (permissive & APPROACH_BIT(h->approach)) {
+            setLED(state, h->red, false);
+            setLED(state, h->yellow, flashOn);
+        } else {
+            setLED(state, h->yellow, false);
+            setLED(state, h->red, true);
+        }
+    }
+}
@@ -0,0 +1,47 @@
+#ifndef FYA_H
+#define FYA_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "traffic_states.h"
+
+/* ============================================================================
+ * FLASHING YELLOW ARROW (permissive left)
+ *
+ * The N and S left-turn lanes have their own combo heads (red / yellow /
+ * green ball) next to the protected N_/S_LEFT_GREEN_ARROW. Each left runs
+ * in one of two modes, chosen by time of day from fyaSchedule[]:
+ *
+ *   PROTECTED ONLY        the combo head stays red while the adjacent
+ *                         through (phase 2 / 6) is green; lefts go only on
+ *                         the protected arrow
+ *   PROTECTED/PERMISSIVE  while the adjacent through is green and the
+ *                         protected arrow is not, the combo yellow flashes:
+ *                         turn after yielding to opposing traffic
+ *
+ * The heads have no separate yellow-arrow section, so the combo yellow is
+ * the flashing indication. Its steady yellow and red clearances are the
+ * through phase's own.
+ *
+ * A left's mode only changes while its through is not green (fyaLatch), so
+ * a schedule boundary never cuts a flashing arrow straight to red nor
+ * starts one part way through a green.
+ *
+ * The flash cadence comes from Timer_A2 on ACLK (see main.c); fyaApply()
+ * only overlays the current flash state on a rendered frame.
+ * ========================================================================= */
+
+#define FYA_FLASH_HALF_PERIOD_MS    500     /* 60 flashes per minute */
+#define FYA_ACLK_HZ                 32768UL
+
+typedef struct {
+    uint16_t startMinute;       /* minute of day the entry takes effect */
+    uint8_t  permissive;        /* APPROACH_BIT of lefts running FYA */
+} FyaScheduleEntry;
+
+uint8_t fyaPermissiveAt(uint16_t minuteOfDay);
+uint8_t fyaLatch(uint8_t shown, uint8_t scheduled, uint16_t greens);
+void    fyaApply(LEDState *state, uint16_t greens, uint8_t permissive,
+                 bool flashOn);
+
+#endif /* FYA_H */
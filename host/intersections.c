@@ -0,0 +1,249 @@
+/* ============================================================================
+ * HOST HARNESS - MANY INTERSECTIONS
+ *
+ * Steps any number of IntersectionContexts (controller.c) in one process,
+ * split into contiguous partitions, one thread per partition. Each thread
+ * owns a TimerWheel shared by its contexts and drives them on a common 1 ms
+ * clock with random detector, bay, push-button and RTC inputs, in place of
+ * the board and its ISRs. Nothing is shared between threads but the const
+ * phase and plan tables.
+ *
+ * Build from the repository root:
+ *
+ *   cc -std=c99 -O2 -Wall -I. -o intersections host/intersections.c \
+ *      controller.c traffic_states.c ring_engine.c transit_priority.c \
+ *      preemption.c coordination.c queue_model.c fya.c dilemma_zone.c \
+ *      detector_bus.c detector_health.c timer_wheel.c -lpthread
+ *
+ * Run:  ./intersections [intersections] [minutes] [threads]
+ * ========================================================================= */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+#include "controller.h"
+#include "sim_random.h"
+
+#define DEFAULT_INTERSECTIONS   256
+#define DEFAULT_MINUTES         10
+#define DEFAULT_THREADS         4
+
+#define START_MS_OF_DAY         (7UL * 3600000UL)   /* 07:00 */
+#define OCCUPANCY_MS            300     /* one vehicle over a detector */
+#define VEH_PER_HOUR_THRU       400     /* per through detector */
+#define VEH_PER_HOUR_LEFT       120     /* per left bay */
+#define PED_PER_HOUR            30      /* per crosswalk */
+
+/* ============================================================================
+ * SIMULATED BOARD
+ * ========================================================================= */
+
+typedef struct {
+    uint16_t detBusy[NUM_DETECTORS];    /* ms left occupied */
+    uint16_t bayBusy[NUM_LEFT_BAYS];
+    bool     bayMasked[NUM_LEFT_BAYS];
+    bool     faultLamp;
+    uint32_t frames;                    /* signal updates shown */
+    DetLog   log;
+} HostBoard;
+
+static void hostShowSignals(void *board, const LEDState *leds) {
+    (void)leds;
+    ((HostBoard *)board)->frames++;
+}
+
+static void hostShowPeds(void *board, const uint8_t image[NUM_DEVICES]) {
+    (void)board;
+    (void)image;
+}
+
+static void hostSetBuzzer(void *board, uint8_t device, bool on) {
+    (void)board;
+    (void)device;
+    (void)on;
+}
+
+static bool hostBayOccupied(void *board, LeftBay bay) {
+    return ((HostBoard *)board)->bayBusy[bay] != 0;
+}
+
+static void hostMaskBay(void *board, LeftBay bay, bool masked) {
+    ((HostBoard *)board)->bayMasked[bay] = masked;
+}
+
+static bool hostBayChattered(void *board, LeftBay bay) {
+    (void)board;
+    (void)bay;
+    return false;
+}
+
+static void hostSetFaultLamp(void *board, bool on) {
+    ((HostBoard *)board)->faultLamp = on;
+}
+
+static const CtlBindings hostBindings = {
+    hostShowSignals,
+    hostShowPeds,
+    hostSetBuzzer,
+    hostBayOccupied,
+    hostMaskBay,
+    hostBayChattered,
+    hostSetFaultLamp
+};
+
+/* ============================================================================
+ * PARTITIONS
+ * ========================================================================= */
+
+typedef struct {
+    IntersectionContext *ctx;
+    HostBoard           *board;
+    uint32_t             count;
+    uint32_t             durationMs;
+    uint64_t             rng;
+    TimerWheel           wheel;
+} Partition;
+
+static void scanDetectors(IntersectionContext *ctx, HostBoard *board) {
+    uint8_t scan[DET_CHAIN_DEVICES];
+    uint8_t d;
+
+    memset(scan, 0xFF, sizeof scan);            /* active LOW */
+    for (d = 0; d < NUM_DETECTORS; d++) {
+        if (board->detBusy[d] != 0) scan[DET_BYTE(d)] &= ~DET_MASK(d);
+    }
+    ctlDetectorScan(ctx, scan);
+}
+
+static void stepInputs(Partition *part, uint32_t i, uint32_t now) {
+    IntersectionContext *ctx = &part->ctx[i];
+    HostBoard *board = &part->board[i];
+    uint8_t d;
+
+    for (d = 0; d < NUM_DETECTORS; d++) {
+        if (board->detBusy[d] != 0) board->detBusy[d]--;
+        else if (arrives(&part->rng, VEH_PER_HOUR_THRU)) {
+            board->detBusy[d] = OCCUPANCY_MS;
+        }
+    }
+    for (d = 0; d < NUM_LEFT_BAYS; d++) {
+        if (board->bayBusy[d] != 0) board->bayBusy[d]--;
+        if (!board->bayMasked[d] &&
+            arrives(&part->rng, VEH_PER_HOUR_LEFT)) {
+            board->bayBusy[d] = OCCUPANCY_MS;
+            ctlLeftArrival(ctx, (LeftBay)d);
+        }
+    }
+    for (d = 0; d < NUM_DEVICES; d++) {
+        if (arrives(&part->rng, PED_PER_HOUR)) ctlPedButton(ctx, d);
+    }
+
+    if (now % DET_SCAN_PERIOD_MS == 0) scanDetectors(ctx, board);
+    if (now % FYA_FLASH_HALF_PERIOD_MS == 0) {
+        ctlFyaFlash(ctx, (now / FYA_FLASH_HALF_PERIOD_MS) & 1);
+    }
+    if (now % 1000 == 0) {
+        ctlRtcSecond(ctx, (START_MS_OF_DAY + now) % COORD_MS_PER_DAY, now);
+    }
+}
+
+static void *runPartition(void *arg) {
+    Partition *part = arg;
+    uint32_t now, i;
+
+    wheelInit(&part->wheel, 0);
+    for (i = 0; i < part->count; i++) {
+        memset(&part->board[i], 0, sizeof part->board[i]);
+        ctlInit(&part->ctx[i], &hostBindings, &part->board[i], &part->wheel,
+                &part->board[i].log);
+        ctlRtcSecond(&part->ctx[i], START_MS_OF_DAY, 0);
+        ctlStart(&part->ctx[i]);
+    }
+
+    for (now = 1; now <= part->durationMs; now++) {
+        wheelAdvance(&part->wheel, now);
+        for (i = 0; i < part->count; i++) {
+            stepInputs(part, i, now);
+            ctlStep(&part->ctx[i]);
+        }
+    }
+    return NULL;
+}
+
+static double seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+int main(int argc, char **argv) {
+    uint32_t total   = argc > 1 ? (uint32_t)atoi(argv[1])
+                                : DEFAULT_INTERSECTIONS;
+    uint32_t minutes = argc > 2 ? (uint32_t)atoi(argv[2]) : DEFAULT_MINUTES;
+    uint32_t threads = argc > 3 ? (uint32_t)atoi(argv[3]) : DEFAULT_THREADS;
+    IntersectionContext *ctx;
+    HostBoard *board;
+    Partition *part;
+    pthread_t *tid;
+    uint64_t frames = 0;
+    uint32_t faults = 0;
+    uint32_t t, i, first;
+    double start, elapsed;
+
+    if (total == 0 || minutes == 0 || threads == 0) {
+        fprintf(stderr, "usage: %s [intersections] [minutes] [threads]\n",
+                argv[0]);
+        return 1;
+    }
+    if (threads > total) threads = total;
+
+    ctx   = calloc(total, sizeof *ctx);
+    board = calloc(total, sizeof *board);
+    part  = calloc(threads, sizeof *part);
+    tid   = calloc(threads, sizeof *tid);
+    if (!ctx || !board || !part || !tid) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+
+    first = 0;
+    for (t = 0; t < threads; t++) {
+        part[t].count      = total / threads + (t < total % threads);
+        part[t].ctx        = &ctx[first];
+        part[t].board      = &board[first];
+        part[t].durationMs = minutes * 60000UL;
+        part[t].rng        = 0x9E3779B97F4A7C15ULL * (t + 1);
+        first += part[t].count;
+    }
+
+    start = seconds();
+    for (t = 0; t < threads; t++) {
+        pthread_create(&tid[t], NULL, runPartition, &part[t]);
+    }
+    for (t = 0; t < threads; t++) pthread_join(tid[t], NULL);
+    elapsed = seconds() - start;
+
+    for (i = 0; i < total; i++) {
+        frames += board[i].frames;
+        if (board[i].faultLamp) faults++;
+    }
+
+    printf("%u intersections x %u min on %u threads: %.2f s "
+           "(%.0fx real time per intersection)\n",
+           total, minutes, threads, elapsed,
+           (double)total * minutes * 60.0 / elapsed);
+    printf("signal updates %llu (%.1f per intersection-minute), "
+           "fault lamps lit %u\n",
+           (unsigned long long)frames,
+           (double)frames / ((double)total * minutes), faults);
+
+    free(tid);
+    free(part);
+    free(board);
+    free(ctx);
+    return 0;
+}
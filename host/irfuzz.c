@@ -0,0 +1,644 @@
+/* ============================================================================
+ * IR CAPTURE / MULTI-PROTOCOL DECODE FUZZ HARNESS
+ *
+ * Feeds arbitrary edge streams into all four IrChannels (ir_decode.c) at
+ * once, as the four capture ISRs would, with the main loop's irTakeFrame()
+ * interleaved wherever the input says. An input is a sequence of 3-byte
+ * edges:
+ *
+ *   byte 0     bits 0-1 channel, bit 2 main loop takes its frames first,
+ *              bit 3 the channel is aborted first (edges lost to masking),
+ *              bit 4 it reports a capture overflow first
+ *   bytes 1-2  microseconds since that channel's previous edge (LE)
+ *
+ * and after every edge the harness checks
+ *
+ *   bounds     guard words either side of each channel untouched, decoder
+ *              state in range, irCapture() returning true exactly when it
+ *              published a frame, and the channel's frame and overflow
+ *              counters matching the harness's own
+ *   spurious   every published frame re-encodes, in its own protocol, to
+ *              as many durations as were captured since the last gap, each
+ *              within FUZZ_TOLERANCE_PCT - so noise, or one protocol's
+ *              frame, cannot turn into another's command or a preemption
+ *              call
+ *
+ * and after the whole input, that no channel is stuck: once its frame is
+ * taken, each one must decode a clean frame of every protocol sent to it,
+ * without counting any of them as aborted.
+ *
+ * libFuzzer (coverage-guided, with AddressSanitizer):
+ *
+ *   clang -std=c99 -g -O1 -fsanitize=fuzzer,address -DIR_FUZZ_LIBFUZZER \
+ *      -I. -o irfuzz host/irfuzz.c ir_decode.c
+ *   ./irfuzz [corpus dir]
+ *
+ * Standalone - random, frame-shaped and mutated inputs, kept when they
+ * reach a decoder state not seen before; then the decode throughput of
+ * each protocol:
+ *
+ *   cc -std=c99 -O2 -Wall -I. -o irfuzz host/irfuzz.c ir_decode.c
+ *   ./irfuzz [iterations] [seed]
+ * ========================================================================= */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "ir_decode.h"
+
+#define FUZZ_CHANNELS           4
+#define FUZZ_GUARD              0xA5C3
+#define FUZZ_GUARD_WORDS        8
+#define FUZZ_TOLERANCE_PCT      65
+#define FUZZ_MAX_TIMINGS        96      /* longest frame is NEC's 67 */
+#define FUZZ_MAX_STEP           80
+#define FUZZ_MAX_INPUT          (3 * 1024)
+#define FUZZ_CORPUS_MAX         512
+#define FUZZ_DEFAULT_ITERATIONS 200000
+#define FUZZ_BENCH_FRAMES       100000
+
+#define NEC_LEADER_US           9000
+#define NEC_LEADER_SPACE_US     4500
+#define NEC_REPEAT_SPACE_US     2250
+#define NEC_MARK_US             560
+#define NEC_SPACE_0_US          560
+#define NEC_SPACE_1_US          1690
+#define SIRC_LEADER_US          2400
+#define SIRC_UNIT_US            600
+#define IDLE_US                 20000
+
+typedef struct {
+    uint16_t  before[FUZZ_GUARD_WORDS];
+    IrChannel ch;
+    uint16_t  after[FUZZ_GUARD_WORDS];
+} GuardedChannel;
+
+/* Durations captured since the channel's last gap, and a copy of them
+ * taken when a frame is published */
+typedef struct {
+    uint16_t t[FUZZ_MAX_TIMINGS];
+    uint8_t  n;
+    bool     overflow;
+} Shadow;
+
+typedef struct {
+    GuardedChannel g[FUZZ_CHANNELS];
+    Shadow         live[FUZZ_CHANNELS];
+    Shadow         held[FUZZ_CHANNELS];
+    uint32_t       now[FUZZ_CHANNELS];  /* extended capture timer */
+    uint16_t       published[FUZZ_CHANNELS];
+    uint16_t       overflows[FUZZ_CHANNELS];
+    uint32_t       edges;
+    uint32_t       frames;              /* published by irCapture() */
+    uint32_t       taken[NUM_IR_PROTOCOLS];
+} Bench;
+
+static const char *const protocolName[NUM_IR_PROTOCOLS] = {
+    "NEC", "NEC repeat", "RC5", "RC6", "SIRC"
+};
+
+static void fatal(const char *what, uint8_t channel) {
+    fprintf(stderr, "irfuzz: channel %u: %s\n", channel, what);
+    abort();
+}
+
+static void benchInit(Bench *b) {
+    uint8_t c, i;
+
+    memset(b, 0, sizeof *b);
+    for (c = 0; c < FUZZ_CHANNELS; c++) {
+        for (i = 0; i < FUZZ_GUARD_WORDS; i++) {
+            b->g[c].before[i] = FUZZ_GUARD;
+            b->g[c].after[i]  = FUZZ_GUARD;
+        }
+        irInit(&b->g[c].ch);
+    }
+}
+
+/* ============================================================================
+ * ORACLE
+ * The ideal waveform of a frame, as durations in capture order from the
+ * first mark, without the idle space after it.
+ * ========================================================================= */
+
+typedef struct {
+    uint16_t t[FUZZ_MAX_TIMINGS];
+    uint8_t  n;
+    bool     lastMark;
+} Wave;
+
+/* Appends time at one level, merging it with a run at the same level */
+static void put(Wave *w, bool mark, uint16_t us) {
+    if (w->n != 0 && w->lastMark == mark) {
+        w->t[w->n - 1] = (uint16_t)(w->t[w->n - 1] + us);
+        return;
+    }
+    w->t[w->n++] = us;
+    w->lastMark  = mark;
+}
+
+static void putManchester(Wave *w, bool oneMarkFirst, bool bit,
+                          uint16_t halfUs) {
+    bool first = bit == oneMarkFirst;
+
+    put(w, first, halfUs);
+    put(w, !first, halfUs);
+}
+
+/* Returns false for a code outside its protocol's layout */
+static bool encode(const IrFrame *f, Wave *w) {
+    int8_t i;
+
+    w->n = 0;
+    switch (f->protocol) {
+        case IR_NEC:
+            put(w, true, NEC_LEADER_US);
+            put(w, false, NEC_LEADER_SPACE_US);
+            for (i = 0; i < 32; i++) {
+                put(w, true, NEC_MARK_US);
+                put(w, false, (f->code >> i) & 1 ? NEC_SPACE_1_US
+                                                 : NEC_SPACE_0_US);
+            }
+            put(w, true, NEC_MARK_US);
+            break;
+
+        case IR_NEC_REPEAT:
+            if (f->code != 0) return false;
+            put(w, true, NEC_LEADER_US);
+            put(w, false, NEC_REPEAT_SPACE_US);
+            put(w, true, NEC_MARK_US);
+            break;
+
+        case IR_RC5:
+            if (f->code & ~0x1F7FUL || f->toggle > 1) return false;
+            put(w, true, IR_RC5_UNIT_US);                   /* S1 */
+            putManchester(w, false, !(f->code & 0x40), IR_RC5_UNIT_US);
+            putManchester(w, false, f->toggle, IR_RC5_UNIT_US);
+            for (i = 12; i >= 8; i--) {
+                putManchester(w, false, (f->code >> i) & 1, IR_RC5_UNIT_US);
+            }
+            for (i = 5; i >= 0; i--) {
+                putManchester(w, false, (f->code >> i) & 1, IR_RC5_UNIT_US);
+            }
+            break;
+
+        case IR_RC6:
+            if (f->code & ~0xFFFFUL || f->toggle > 1) return false;
+            put(w, true, 6 * IR_RC6_UNIT_US);
+            put(w, false, 2 * IR_RC6_UNIT_US);
+            putManchester(w, true, true, IR_RC6_UNIT_US);   /* start */
+            for (i = 0; i < 3; i++) {
+                putManchester(w, true, false, IR_RC6_UNIT_US);
+            }
+            putManchester(w, true, f->toggle, 2 * IR_RC6_UNIT_US);
+            for (i = 15; i >= 0; i--) {
+                putManchester(w, true, (f->code >> i) & 1, IR_RC6_UNIT_US);
+            }
+            break;
+
+        case IR_SIRC:
+            if (f->bits != 12 && f->bits != 15 && f->bits != 20) return false;
+            if (f->code >> f->bits) return false;
+            put(w, true, SIRC_LEADER_US);
+            for (i = 0; i < (int8_t)f->bits; i++) {
+                put(w, false, SIRC_UNIT_US);
+                put(w, true, (f->code >> i) & 1 ? 2 * SIRC_UNIT_US
+                                                : SIRC_UNIT_US);
+            }
+            break;
+
+        default:
+            return false;
+    }
+    if (!w->lastMark) w->n--;
+    return true;
+}
+
+static bool withinTolerance(uint16_t got, uint16_t ideal) {
+    uint32_t slack = (uint32_t)ideal * FUZZ_TOLERANCE_PCT / 100;
+    return got + slack >= ideal && got <= ideal + slack;
+}
+
+static void checkFrame(const IrFrame *f, const Shadow *s, uint8_t c) {
+    Wave w;
+    uint8_t i;
+
+    if (!encode(f, &w)) fatal("frame outside its protocol's layout", c);
+    if (s->overflow || s->n != w.n) {
+        fatal("frame published from the wrong number of edges", c);
+    }
+    for (i = 0; i < w.n; i++) {
+        if (!withinTolerance(s->t[i], w.t[i])) {
+            fatal("published a frame its edges do not encode", c);
+        }
+    }
+}
+
+/* ============================================================================
+ * CHANNEL DRIVER
+ * ========================================================================= */
+
+static void checkChannel(const Bench *b, uint8_t c) {
+    const GuardedChannel *g = &b->g[c];
+    uint8_t i, nextMark;
+
+    for (i = 0; i < FUZZ_GUARD_WORDS; i++) {
+        if (g->before[i] != FUZZ_GUARD || g->after[i] != FUZZ_GUARD) {
+            fatal("write outside the channel", c);
+        }
+    }
+    memcpy(&nextMark, &g->ch.nextMark, 1);
+    if (g->ch.active >> IR_NUM_DECODERS || nextMark > 1 ||
+        g->ch.frameReady > 1) {
+        fatal("channel flags out of range", c);
+    }
+    for (i = 0; i < IR_NUM_DECODERS; i++) {
+        const IrDecodeState *s = &g->ch.dec[i];
+
+        if (s->step > FUZZ_MAX_STEP || s->bits > 32 || s->half > 4 ||
+            s->level > 1) {
+            fatal("decoder state out of range", c);
+        }
+    }
+    if (g->ch.frameReady && g->ch.frame.protocol >= NUM_IR_PROTOCOLS) {
+        fatal("published protocol out of range", c);
+    }
+    if (g->ch.stats.frames != b->published[c] ||
+        g->ch.stats.overflows != b->overflows[c]) {
+        fatal("counters disagree with the harness", c);
+    }
+}
+
+/* The main loop's handleIrFrame() for every channel holding a frame.
+ * Returns the number of frames taken; the last is left in *last. */
+static uint8_t service(Bench *b, IrFrame *last) {
+    uint8_t c, taken = 0;
+    IrFrame f;
+
+    for (c = 0; c < FUZZ_CHANNELS; c++) {
+        if (!irTakeFrame(&b->g[c].ch, &f)) continue;
+
+        checkFrame(&f, &b->held[c], c);
+        b->taken[f.protocol]++;
+        taken++;
+        if (last) *last = f;
+    }
+    return taken;
+}
+
+static void edge(Bench *b, uint8_t c, uint16_t us) {
+    IrChannel *ch = &b->g[c].ch;
+    Shadow *live = &b->live[c];
+    uint8_t wasReady = ch->frameReady;
+    bool done;
+
+    b->now[c] += us;
+    done = irCapture(ch, b->now[c]);
+    b->edges++;
+
+    if (done != (!wasReady && ch->frameReady)) {
+        fatal("irCapture() result disagrees with frameReady", c);
+    }
+    if (us < IR_GAP_US) {
+        if (live->n < FUZZ_MAX_TIMINGS) live->t[live->n++] = us;
+        else live->overflow = true;
+    }
+    if (done) {
+        b->held[c] = *live;
+        b->published[c]++;
+        b->frames++;
+    }
+    if (us >= IR_GAP_US) {
+        live->n = 0;
+        live->overflow = false;
+    }
+    checkChannel(b, c);
+}
+
+/* Gap, frame, gap - the last gap completes a frame without a stop mark */
+static void sendFrame(Bench *b, uint8_t c, const IrFrame *f) {
+    Wave w;
+    uint8_t i;
+
+    encode(f, &w);
+    edge(b, c, IDLE_US);
+    for (i = 0; i < w.n; i++) edge(b, c, w.t[i]);
+    edge(b, c, IDLE_US);
+}
+
+static const IrFrame probes[] = {
+    { IR_NEC,        0,  0, 0xBB44FF00 },
+    { IR_NEC_REPEAT, 0,  0, 0          },
+    { IR_RC5,        0,  1, 0x1E7B     },   /* RC5X command */
+    { IR_RC6,        0,  1, 0x3A0C     },
+    { IR_SIRC,       12, 0, 0x0A95     },
+    { IR_SIRC,       20, 0, 0xB5A3C    }
+};
+
+#define NUM_PROBES  (sizeof probes / sizeof probes[0])
+
+/* The flags in an input edge's first byte */
+static void control(Bench *b, uint8_t flags) {
+    uint8_t c = flags & 0x03;
+
+    if (flags & 0x04) service(b, NULL);
+    if (flags & 0x08) irAbort(&b->g[c].ch);
+    if (flags & 0x10) {
+        irOverflow(&b->g[c].ch);
+        b->overflows[c]++;
+    }
+}
+
+/* Runs one input; aborts on any violation */
+static void runInput(Bench *b, const uint8_t *data, size_t size) {
+    IrFrame got;
+    uint16_t aborted;
+    uint8_t c, p;
+    size_t i;
+
+    benchInit(b);
+    for (i = 0; i + 3 <= size; i += 3) {
+        control(b, data[i]);
+        edge(b, data[i] & 0x03, (uint16_t)(data[i + 1] | data[i + 2] << 8));
+    }
+
+    for (c = 0; c < FUZZ_CHANNELS; c++) edge(b, c, IDLE_US);
+    service(b, NULL);                   /* whatever those gaps completed */
+    for (c = 0; c < FUZZ_CHANNELS; c++) {
+        aborted = b->g[c].ch.stats.aborted;
+        for (p = 0; p < NUM_PROBES; p++) {
+            sendFrame(b, c, &probes[p]);
+            if (service(b, &got) != 1 ||
+                got.protocol != probes[p].protocol ||
+                got.code != probes[p].code ||
+                got.toggle != probes[p].toggle) {
+                fatal("stuck: a clean frame did not decode", c);
+            }
+        }
+        if (b->g[c].ch.stats.aborted != aborted) {
+            fatal("a clean frame counted as aborted", c);
+        }
+    }
+}
+
+#ifdef IR_FUZZ_LIBFUZZER
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    static Bench b;
+
+    runInput(&b, data, size);
+    return 0;
+}
+
+#else
+
+/* ============================================================================
+ * STANDALONE DRIVER
+ * Inputs that reach a new (decoder, step, edge class) are kept in a small
+ * corpus and mutated further - a coarse stand-in for libFuzzer's coverage
+ * feedback, enough to walk each decoder to its last step.
+ * ========================================================================= */
+
+typedef struct {
+    uint8_t data[FUZZ_MAX_INPUT];
+    size_t  size;
+} Input;
+
+static uint64_t rng;
+
+static uint32_t rnd(void) {
+    rng ^= rng << 13;
+    rng ^= rng >> 7;
+    rng ^= rng << 17;
+    return (uint32_t)(rng >> 16);
+}
+
+static void putEdge(Input *in, uint8_t channel, uint16_t us) {
+    if (in->size + 3 > FUZZ_MAX_INPUT) return;
+    in->data[in->size++] = (uint8_t)(channel | ((rnd() & 7) == 0 ? 4 : 0) |
+                                     ((rnd() & 63) == 0 ? 8 : 0) |
+                                     ((rnd() & 63) == 0 ? 0x10 : 0));
+    in->data[in->size++] = (uint8_t)us;
+    in->data[in->size++] = (uint8_t)(us >> 8);
+}
+
+/* A well-formed frame of a random protocol, mostly */
+static void randomFrame(IrFrame *f) {
+    static const uint8_t sircBits[3] = { 12, 15, 20 };
+    uint32_t code = rnd() << 16 | (rnd() & 0xFFFF);
+
+    f->protocol = (uint8_t)(rnd() % NUM_IR_PROTOCOLS);
+    f->bits     = 0;
+    f->toggle   = (uint8_t)(rnd() & 1);
+    switch (f->protocol) {
+        case IR_NEC:
+            if (rnd() & 1) {
+                code = (code & 0x00FFFFFF) | (~code << 8 & 0xFF000000);
+            }
+            f->toggle = 0;
+            break;
+        case IR_NEC_REPEAT: code = 0; f->toggle = 0;         break;
+        case IR_RC5:        code &= 0x1F7F;                  break;
+        case IR_RC6:        code &= 0xFFFF;                  break;
+        default:
+            f->bits   = sircBits[rnd() % 3];
+            f->toggle = 0;
+            code &= (1UL << f->bits) - 1;
+            break;
+    }
+    f->code = code;
+}
+
+/* A frame, jittered, possibly truncated, on one channel; interleaved with
+ * noise on the others */
+static void putFrame(Input *in) {
+    uint8_t c = rnd() & 3, i, len;
+    IrFrame f;
+    Wave w;
+
+    randomFrame(&f);
+    encode(&f, &w);
+    len = (rnd() & 3) == 0 ? (uint8_t)(rnd() % (w.n + 1)) : w.n;
+
+    putEdge(in, c, (uint16_t)(IR_GAP_US + rnd() % 40000));
+    for (i = 0; i < len; i++) {
+        int32_t jitter = (int32_t)(rnd() % 41) - 20;    /* +/- 20 % */
+        putEdge(in, c, (uint16_t)(w.t[i] + w.t[i] * jitter / 100));
+        if ((rnd() & 15) == 0) {
+            putEdge(in, (uint8_t)((c + 1 + rnd() % 3) & 3),
+                    (uint16_t)rnd());
+        }
+    }
+    if (rnd() & 1) putEdge(in, c, (uint16_t)(IR_GAP_US + rnd() % 40000));
+}
+
+static void generate(Input *in) {
+    in->size = 0;
+    while (in->size + 3 <= FUZZ_MAX_INPUT && (rnd() & 31) != 0) {
+        switch (rnd() % 4) {
+            case 0:  putEdge(in, rnd() & 3, (uint16_t)rnd());          break;
+            case 1:  putEdge(in, rnd() & 3, (uint16_t)(rnd() % 3000)); break;
+            default: putFrame(in);                                     break;
+        }
+    }
+}
+
+static void mutate(Input *in) {
+    uint32_t n = 1 + rnd() % 8, k;
+
+    for (k = 0; k < n && in->size >= 3; k++) {
+        size_t at = rnd() % in->size;
+
+        switch (rnd() % 4) {
+            case 0:  in->data[at] = (uint8_t)rnd();                break;
+            case 1:  in->data[at] ^= (uint8_t)(1u << (rnd() & 7)); break;
+            case 2:                                     /* drop an edge */
+                at -= at % 3;
+                memmove(&in->data[at], &in->data[at + 3],
+                        in->size - at - 3);
+                in->size -= 3;
+                break;
+            default:                                    /* stretch one */
+                at -= at % 3;
+                in->data[at + 2] = (uint8_t)(in->data[at + 2] +
+                                             (rnd() & 3) - 1);
+                break;
+        }
+    }
+}
+
+/* Decoder states an input reached: step of each decoder still active,
+ * with the duration class of the edge that got there and whether the
+ * channel held a frame */
+#define NUM_CLASSES     8
+
+static uint8_t seen[IR_NUM_DECODERS][FUZZ_MAX_STEP + 1][2][NUM_CLASSES];
+
+static uint8_t classOf(uint16_t us) {
+    static const uint16_t upper[NUM_CLASSES - 1] = {
+        300, 900, 1500, 2100, 2750, 5000, IR_GAP_US
+    };
+    uint8_t k;
+
+    for (k = 0; k < NUM_CLASSES - 1 && us >= upper[k]; k++) {
+    }
+    return k;
+}
+
+static bool novel(const Input *in) {
+    Bench b;
+    bool found = false;
+    size_t i;
+
+    benchInit(&b);
+    for (i = 0; i + 3 <= in->size; i += 3) {
+        uint8_t c = in->data[i] & 3, d;
+        uint16_t us = (uint16_t)(in->data[i + 1] | in->data[i + 2] << 8);
+        IrChannel *ch = &b.g[c].ch;
+
+        control(&b, in->data[i]);
+        edge(&b, c, us);
+        for (d = 0; d < IR_NUM_DECODERS; d++) {
+            uint8_t *s;
+
+            if (!(ch->active & (1u << d))) continue;
+            s = &seen[d][ch->dec[d].step][ch->frameReady][classOf(us)];
+            if (!*s) found = true;
+            *s = 1;
+        }
+    }
+    return found;
+}
+
+static double seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+/* Edges per second through irCapture() for each protocol, with every
+ * frame taken and checked */
+static void throughput(void) {
+    static Bench b;
+    bool lost = false;
+    uint8_t p;
+
+    for (p = 0; p < NUM_PROBES; p++) {
+        const IrFrame *f = &probes[p];
+        double start, elapsed;
+        uint32_t n;
+
+        benchInit(&b);
+        start = seconds();
+        for (n = 0; n < FUZZ_BENCH_FRAMES; n++) {
+            sendFrame(&b, (uint8_t)(n & 3), f);
+            service(&b, NULL);
+        }
+        elapsed = seconds() - start;
+
+        printf("throughput %-10s %2u bits: %5.1f M edges/s, "
+               "%4.0f k frames/s (%u of %u decoded)\n",
+               protocolName[f->protocol], f->bits,
+               b.edges / elapsed / 1e6, b.frames / elapsed / 1e3,
+               b.taken[f->protocol], FUZZ_BENCH_FRAMES);
+        if (b.taken[f->protocol] != FUZZ_BENCH_FRAMES) lost = true;
+    }
+    if (lost) {
+        fprintf(stderr, "irfuzz: clean frames lost\n");
+        exit(1);
+    }
+}
+
+int main(int argc, char **argv) {
+    static Input corpus[FUZZ_CORPUS_MAX];
+    static Bench b;
+    uint32_t iterations = FUZZ_DEFAULT_ITERATIONS, it, kept = 0;
+    uint64_t edges = 0, taken[NUM_IR_PROTOCOLS] = { 0 };
+    uint64_t dropped = 0, aborted = 0;
+    double start = seconds();
+    uint8_t p;
+
+    if (argc > 1) iterations = (uint32_t)strtoul(argv[1], NULL, 0);
+    rng = argc > 2 ? strtoull(argv[2], NULL, 0) : 0x2545F4914F6CDD1DULL;
+    if (rng == 0) rng = 1;
+
+    for (it = 0; it < iterations; it++) {
+        Input in;
+
+        if (kept != 0 && (rnd() & 1)) {
+            in = corpus[rnd() % kept];
+            mutate(&in);
+        } else {
+            generate(&in);
+        }
+
+        runInput(&b, in.data, in.size);
+        edges += b.edges;
+        for (p = 0; p < NUM_IR_PROTOCOLS; p++) taken[p] += b.taken[p];
+        for (p = 0; p < FUZZ_CHANNELS; p++) {
+            dropped += b.g[p].ch.stats.dropped;
+            aborted += b.g[p].ch.stats.aborted;
+        }
+
+        if (novel(&in)) {
+            corpus[kept < FUZZ_CORPUS_MAX ? kept++ : rnd() % kept] = in;
+        }
+    }
+
+    printf("fuzz: %u inputs, %llu edges, %u corpus entries, %.1f s - "
+           "no violations\nframes taken and checked:",
+           iterations, (unsigned long long)edges, kept, seconds() - start);
+    for (p = 0; p < NUM_IR_PROTOCOLS; p++) {
+        printf(" %s %llu%s", protocolName[p], (unsigned long long)taken[p],
+               p + 1 < NUM_IR_PROTOCOLS ? "," : "\n");
+    }
+    printf("frames dropped while one was held: %llu, aborted: %llu\n",
+           (unsigned long long)dropped, (unsigned long long)aborted);
+    throughput();
+    return 0;
+}
+
+#endif /* IR_FUZZ_LIBFUZZER */
@@ -0,0 +1,540 @@
+/* ============================================================================
+ * INTERRUPT LATENCY HARNESS
+ *
+ * Cycle-level model of the board's interrupt sources on the MSP430 CPU at
+ * MCLK_HZ, to measure how long each source can wait for its handler under
+ * combined load. The latency of a
+ * request is the time from its flag being set to the first instruction of
+ * its handler: the time spent behind other handlers, plus interrupt entry.
+ * For the speed traps that is the error in their Timer_A3 timestamp.
+ *
+ * The interrupt controller as the hardware has it:
+ *
+ *   priority   with GIE set, the highest pending source in vector order is
+ *              taken; a shared vector's IV serves its lowest IV first
+ *   no nesting a handler runs with GIE clear; requests raised meanwhile
+ *              wait. A second request from a source whose flag is still
+ *              set is lost (a capture's COV) - except a port, whose pins
+ *              each have their own flag and are served in one pass
+ *   nesting    a handler that sets GIE can be preempted by any pending
+ *              source, lower priority ones included
+ *
+ * and the IR edge budget of main.c: a receiver is masked once it has taken
+ * IR_EDGE_BUDGET captures in an IR_SERVICE_PERIOD_MS, and its edges until
+ * the period ends are not requests at all.
+ *
+ * Three policies for the IR capture handlers - everything else is the same
+ * in all of them:
+ *
+ *   isr-decode  the capture ISR decodes the edge itself (before the edge
+ *               queues in ir_decode.h)
+ *   deferred    the ISR only queues the count; the main loop decodes it.
+ *               This is what main.c does
+ *   nested      the ISR queues the count, masks its own capture, sets GIE
+ *               and decodes - preemptible, but still ahead of the main loop
+ *
+ * Three loads, each on top of the 1 ms tick, both capture timer overflows,
+ * a detector scan every DET_SCAN_PERIOD_MS, the FYA cadence, RTC seconds,
+ * a sync pulse, Hall edges and speed-trap edges at a busy-junction rate:
+ *
+ *   quiet      no IR
+ *   remotes    an RC6 frame - the fastest edges a real remote sends - on
+ *              every receiver, every 40 to 110 ms
+ *   sunlight   10 edges per ms of noise on every receiver, so every budget
+ *              runs out every period. A channel waiting for a gap decodes
+ *              an edge in a few dozen cycles
+ *
+ * Handler costs (srcDefs[]) are estimates from each handler's code path at
+ * -O2 with CPUX instruction timings, drawn uniformly from a range per
+ * request - not measurements. After changing a handler, time it on the
+ * target and update its range here.
+ *
+ * For each load and policy the harness prints, per source, the requests
+ * taken, those lost, and the 99th percentile and worst latency seen, in
+ * microseconds; then the share of CPU time in handlers, and - deferred -
+ * in decoding in the main loop. At MCLK = 1 MHz, four receivers in
+ * sunlight take more than the whole CPU even as top halves; hence the
+ * 8 MHz MCLK of System_init().
+ *
+ * Build from the repository root:
+ *
+ *   cc -std=c99 -O2 -Wall -I. -o isrlatency host/isrlatency.c -lm
+ *
+ * Run:  ./isrlatency [seconds per run] [seed]
+ * ========================================================================= */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+#include "detector_bus.h"
+#include "fya.h"
+#include "ir_decode.h"
+
+#define MCLK_HZ                 8000000UL
+#define ENTRY_CYCLES            6       /* push PC and SR, fetch vector */
+#define RETI_CYCLES             5
+#define HIST_CYCLES             32768
+#define MAX_DEPTH               32
+
+/* As in main.c */
+#define IR_SERVICE_PERIOD_MS    5
+#define IR_EDGE_BUDGET          24
+#define NUM_RECEIVERS           4
+
+#define CYCLES_PER_US           (MCLK_HZ / 1000000)
+#define CYCLES_PER_MS           (MCLK_HZ / 1000)
+#define TIMER_PERIOD_MS         65.536  /* Timer_A on SMCLK, 1 MHz */
+#define IR_NOISE_MEAN_CYCLES    (100.0 * CYCLES_PER_US)    /* 10 per ms */
+#define IR_WAIT_DECODE_MIN      25      /* an edge before the gap */
+#define IR_WAIT_DECODE_MAX      50
+#define IR_FRAME_MIN_MS         40
+#define IR_FRAME_MAX_MS         110
+#define TRAP_PORT_MEAN_MS       250.0   /* 4 detectors, ~1 s apart each */
+#define BAY_MEAN_MS             2000.0
+#define SYNC_PERIOD_MS          90000UL
+#define DEFAULT_SECONDS         60
+
+typedef enum {
+    POLICY_ISR_DECODE = 0,
+    POLICY_DEFERRED,
+    POLICY_NESTED,
+    NUM_POLICIES
+} Policy;
+
+typedef enum {
+    LOAD_QUIET = 0,
+    LOAD_REMOTES,
+    LOAD_SUNLIGHT,
+    NUM_LOADS
+} Load;
+
+static const char *const policyName[NUM_POLICIES] = {
+    "isr-decode", "deferred", "nested"
+};
+
+static const char *const loadName[NUM_LOADS] = {
+    "quiet", "remotes", "sunlight"
+};
+
+typedef enum {
+    ARRIVE_PERIODIC = 0,
+    ARRIVE_POISSON,
+    ARRIVE_IR
+} Arrival;
+
+/* What the hardware knows about a source, and what its handler costs */
+typedef struct {
+    const char *name;
+    uint16_t    priority;       /* vector order, then IV order: higher first */
+    Arrival     arrival;
+    double      interval;       /* ms - period, or mean for Poisson */
+    uint16_t    top[2];         /* handler body, cycles: min, max */
+    uint16_t    decode[2];      /* IR decode of one edge, cycles */
+    uint16_t    merged;         /* each further pin served in the same pass */
+    int8_t      receiver;       /* ir[] index, or -1 */
+} SourceDef;
+
+/* Fixed vector order of the MSP430FR6989, highest first:
+ * TB0 CCR0 > TA0 CCR0 > TA0 IV > DMA > TA1 IV > TA2 CCR0 > P2 > P3 > P4 >
+ * RTC. The priorities below keep that order with room for IV order. */
+static const SourceDef srcDefs[] = {
+    { "Timer_B0 tick",  100, ARRIVE_PERIODIC, 1.0,
+      { 14, 18 },   { 0, 0 },     0, -1 },
+    { "ir[0] TA0.0",     90, ARRIVE_IR,       0.0,
+      { 95, 125 },  { 120, 600 }, 0,  0 },
+    { "ir[1] TA0.1",     82, ARRIVE_IR,       0.0,
+      { 100, 130 }, { 120, 600 }, 0,  1 },
+    { "ir[2] TA0.2",     81, ARRIVE_IR,       0.0,
+      { 100, 130 }, { 120, 600 }, 0,  2 },
+    { "TA0 overflow",    80, ARRIVE_PERIODIC, TIMER_PERIOD_MS,
+      { 16, 20 },   { 0, 0 },     0, -1 },
+    { "DMA scan done",   70, ARRIVE_PERIODIC, DET_SCAN_PERIOD_MS,
+      { 75, 95 },   { 0, 0 },     0, -1 },
+    { "ir[3] TA1.1",     62, ARRIVE_IR,       0.0,
+      { 100, 130 }, { 120, 600 }, 0,  3 },
+    { "TA1 overflow",    60, ARRIVE_PERIODIC, TIMER_PERIOD_MS,
+      { 16, 20 },   { 0, 0 },     0, -1 },
+    { "TA2 FYA flash",   50, ARRIVE_PERIODIC,
+      FYA_FLASH_HALF_PERIOD_MS,
+      { 85, 105 },  { 0, 0 },     0, -1 },
+    { "P2 bay north",    42, ARRIVE_POISSON,  BAY_MEAN_MS,
+      { 130, 170 }, { 0, 0 },     0, -1 },
+    { "P2 bay south",    41, ARRIVE_POISSON,  BAY_MEAN_MS,
+      { 130, 170 }, { 0, 0 },     0, -1 },
+    { "P2 sync pulse",   40, ARRIVE_PERIODIC, SYNC_PERIOD_MS,
+      { 90, 110 },  { 0, 0 },     0, -1 },
+    { "P3 traps E/W",    30, ARRIVE_POISSON,  TRAP_PORT_MEAN_MS,
+      { 100, 130 }, { 0, 0 },    70, -1 },
+    { "P4 traps N/S",    20, ARRIVE_POISSON,  TRAP_PORT_MEAN_MS,
+      { 100, 130 }, { 0, 0 },    70, -1 },
+    { "RTC second",      10, ARRIVE_PERIODIC, 1000.0,
+      { 80, 100 },  { 0, 0 },     0, -1 }
+};
+
+#define NUM_SOURCES     (sizeof srcDefs / sizeof srcDefs[0])
+
+/* Longest RC6 mode 0 frame, as durations in half-bit units */
+#define RC6_MAX_DURATIONS   48
+
+typedef struct {
+    const SourceDef *def;
+    uint64_t next;              /* cycle of the next request */
+    bool     pending;           /* flag set, handler not yet entered */
+    uint64_t requested;         /* cycle the oldest pending request was set */
+    uint8_t  pins;              /* merged requests pending */
+    bool     running;           /* own source masked while it decodes */
+    uint8_t  budget;            /* IR captures this period */
+    /* ARRIVE_IR, remotes: the frame being sent */
+    uint8_t  units[RC6_MAX_DURATIONS];
+    uint8_t  numUnits, unit;
+    /* results */
+    uint32_t taken, lost, masked;
+    uint64_t latencySum;
+    uint32_t latencyMax;
+    uint32_t hist[HIST_CYCLES + 1];
+} Source;
+
+typedef struct {
+    int      src;
+    uint8_t  phase;             /* PHASE_... */
+    uint32_t left;              /* cycles left in this phase */
+    uint32_t open;              /* preemptible cycles after PHASE_SHUT */
+} Frame;
+
+enum { PHASE_SHUT = 0, PHASE_OPEN, PHASE_RETI };
+
+typedef struct {
+    Policy   policy;
+    Load     load;
+    Source   src[NUM_SOURCES];
+    Frame    stack[MAX_DEPTH];
+    uint8_t  depth;
+    uint64_t now;
+    uint64_t nextPeriod;        /* IR budgets restart */
+    uint64_t busy;              /* cycles in handlers */
+    uint64_t deferred;          /* decode cycles left to the main loop */
+} Sim;
+
+static uint64_t rng;
+
+static uint32_t rnd(void) {
+    rng ^= rng << 13;
+    rng ^= rng >> 7;
+    rng ^= rng << 17;
+    return (uint32_t)(rng >> 32);
+}
+
+static uint32_t uniform(uint32_t min, uint32_t max) {
+    return min + rnd() % (max - min + 1);
+}
+
+static uint64_t exponential(double mean) {
+    double u = (rnd() + 1.0) / 4294967297.0;
+    return (uint64_t)(-mean * log(u)) + 1;
+}
+
+/* ============================================================================
+ * ARRIVALS
+ * ========================================================================= */
+
+/* RC6 mode 0 with a random address and command, as runs of half-bit units
+ * alternating mark, space, mark... */
+static void rc6Frame(Source *s) {
+    uint8_t level[2 * 24 + 8];
+    uint8_t n = 0, i, run;
+    uint16_t data = (uint16_t)rnd();
+    int bit;
+
+    for (i = 0; i < 6; i++) level[n++] = 1;         /* leader */
+    for (i = 0; i < 2; i++) level[n++] = 0;
+    level[n++] = 1; level[n++] = 0;                 /* start bit, a 1 */
+    for (i = 0; i < 3; i++) {                       /* mode 0 */
+        level[n++] = 0; level[n++] = 1;
+    }
+    run = (uint8_t)(rnd() & 1);                     /* trailer, double */
+    level[n++] = run; level[n++] = run;
+    level[n++] = (uint8_t)!run; level[n++] = (uint8_t)!run;
+    for (bit = 15; bit >= 0; bit--) {
+        uint8_t one = (uint8_t)((data >> bit) & 1);
+        level[n++] = one; level[n++] = (uint8_t)!one;
+    }
+
+    s->numUnits = 0;
+    for (i = 0; i < n; i += run) {
+        for (run = 1; i + run < n && level[i + run] == level[i]; run++) {
+        }
+        if (level[i] || i + run < n) s->units[s->numUnits++] = run;
+    }
+    s->unit = 0;
+}
+
+/* Cycles from one request of `s` to its next */
+static uint64_t interval(Sim *sim, Source *s) {
+    const SourceDef *d = s->def;
+
+    switch (d->arrival) {
+        case ARRIVE_PERIODIC:
+            return (uint64_t)(d->interval * CYCLES_PER_MS);
+        case ARRIVE_POISSON:
+            return exponential(d->interval * CYCLES_PER_MS);
+        default:
+            break;
+    }
+
+    if (sim->load == LOAD_SUNLIGHT) return exponential(IR_NOISE_MEAN_CYCLES);
+
+    /* Remotes: the edge that ends each duration, then the next frame */
+    if (s->unit < s->numUnits) {
+        return (uint64_t)s->units[s->unit++] * IR_RC6_UNIT_US * CYCLES_PER_US;
+    }
+    rc6Frame(s);
+    return (uint64_t)uniform(IR_FRAME_MIN_MS, IR_FRAME_MAX_MS) *
+           CYCLES_PER_MS;
+}
+
+static void arrive(Sim *sim, Source *s) {
+    const SourceDef *d = s->def;
+    uint64_t at = s->next;
+
+    s->next = at + interval(sim, s);
+
+    if (d->receiver >= 0 && s->budget >= IR_EDGE_BUDGET) {
+        s->masked++;
+        return;
+    }
+    if (s->pending) {
+        if (d->merged) s->pins++;
+        else           s->lost++;
+        return;
+    }
+    s->pending   = true;
+    s->requested = at;
+    s->pins      = 0;
+}
+
+/* ============================================================================
+ * CPU
+ * ========================================================================= */
+
+static void record(Source *s, uint64_t latency) {
+    uint32_t cycles = latency > HIST_CYCLES ? HIST_CYCLES : (uint32_t)latency;
+
+    s->taken++;
+    s->latencySum += latency;
+    if (cycles > s->latencyMax) s->latencyMax = cycles;
+    s->hist[cycles]++;
+}
+
+/* Highest-priority source that may be taken now, or -1 */
+static int highestPending(const Sim *sim) {
+    int i, best = -1;
+
+    for (i = 0; i < (int)NUM_SOURCES; i++) {
+        const Source *s = &sim->src[i];
+
+        if (!s->pending || s->running) continue;
+        if (best < 0 || s->def->priority > sim->src[best].def->priority) {
+            best = i;
+        }
+    }
+    return best;
+}
+
+static void enter(Sim *sim, int i) {
+    Source *s = &sim->src[i];
+    const SourceDef *d = s->def;
+    Frame *f = &sim->stack[sim->depth++];
+    uint32_t body = uniform(d->top[0], d->top[1]) + (uint32_t)s->pins * d->merged;
+    uint32_t decode = 0;
+
+    record(s, sim->now - s->requested + ENTRY_CYCLES);
+    s->pending = false;
+
+    if (d->receiver >= 0) {
+        s->budget++;
+        decode = sim->load == LOAD_SUNLIGHT
+               ? uniform(IR_WAIT_DECODE_MIN, IR_WAIT_DECODE_MAX)
+               : uniform(d->decode[0], d->decode[1]);
+    }
+
+    f->src   = i;
+    f->phase = PHASE_SHUT;
+    f->open  = 0;
+    switch (sim->policy) {
+        case POLICY_ISR_DECODE:
+            body += decode;
+            break;
+        case POLICY_DEFERRED:
+            sim->deferred += decode;
+            break;
+        default:
+            f->open    = decode;
+            s->running = decode != 0;
+            break;
+    }
+    f->left = ENTRY_CYCLES + body;
+}
+
+/* The top frame has finished its phase */
+static void nextPhase(Sim *sim) {
+    Frame *f = &sim->stack[sim->depth - 1];
+
+    if (f->phase == PHASE_SHUT && f->open) {
+        f->phase = PHASE_OPEN;
+        f->left  = f->open;
+    } else if (f->phase != PHASE_RETI) {
+        f->phase = PHASE_RETI;
+        f->left  = RETI_CYCLES;
+    } else {
+        sim->src[f->src].running = false;
+        sim->depth--;
+    }
+}
+
+static void run(Sim *sim, uint64_t end) {
+    uint64_t periodCycles = IR_SERVICE_PERIOD_MS * CYCLES_PER_MS;
+    uint8_t i;
+
+    while (sim->now < end) {
+        uint64_t next = end;
+        bool open = sim->depth == 0 ||
+                    sim->stack[sim->depth - 1].phase == PHASE_OPEN;
+        int take;
+
+        for (i = 0; i < NUM_SOURCES; i++) {
+            while (sim->src[i].next <= sim->now) arrive(sim, &sim->src[i]);
+        }
+        if (sim->now >= sim->nextPeriod) {
+            for (i = 0; i < NUM_SOURCES; i++) sim->src[i].budget = 0;
+            sim->nextPeriod += periodCycles;
+        }
+
+        if (open && sim->depth < MAX_DEPTH &&
+            (take = highestPending(sim)) >= 0) {
+            enter(sim, take);
+            continue;
+        }
+
+        for (i = 0; i < NUM_SOURCES; i++) {
+            if (sim->src[i].next < next) next = sim->src[i].next;
+        }
+        if (sim->nextPeriod < next) next = sim->nextPeriod;
+
+        if (sim->depth) {
+            Frame *f = &sim->stack[sim->depth - 1];
+            uint64_t step = next - sim->now;
+
+            if (f->left < step) step = f->left;
+            f->left   -= (uint32_t)step;
+            sim->busy += step;
+            sim->now  += step;
+            if (!f->left) nextPhase(sim);
+        } else {
+            sim->now = next;
+        }
+    }
+}
+
+static void simInit(Sim *sim, Policy policy, Load load) {
+    uint8_t i;
+
+    memset(sim, 0, sizeof *sim);
+    sim->policy     = policy;
+    sim->load       = load;
+    sim->nextPeriod = IR_SERVICE_PERIOD_MS * CYCLES_PER_MS;
+
+    for (i = 0; i < NUM_SOURCES; i++) {
+        Source *s = &sim->src[i];
+
+        s->def = &srcDefs[i];
+        if (s->def->arrival == ARRIVE_IR && load == LOAD_QUIET) {
+            s->next = UINT64_MAX;
+        } else {
+            /* A random phase, so periodic sources meet at every offset */
+            s->next = rnd() % (uint64_t)((s->def->interval > 0 ?
+                                          s->def->interval : 100.0) *
+                                         CYCLES_PER_MS);
+        }
+    }
+}
+
+/* ============================================================================
+ * REPORT
+ * ========================================================================= */
+
+static uint32_t percentile(const Source *s, double p) {
+    uint64_t want = (uint64_t)ceil(s->taken * p), seen = 0;
+    uint32_t c;
+
+    for (c = 0; c <= HIST_CYCLES; c++) {
+        seen += s->hist[c];
+        if (seen >= want && seen) return c;
+    }
+    return 0;
+}
+
+static void report(Load load, Sim sims[NUM_POLICIES], double seconds) {
+    uint8_t i, p;
+
+    printf("\nload: %s\n%-16s", loadName[load], "source");
+    for (p = 0; p < NUM_POLICIES; p++) printf(" | %-25s", policyName[p]);
+    printf("\n%-16s", "");
+    for (p = 0; p < NUM_POLICIES; p++) {
+        printf(" | %8s %5s %5s %5s", "taken", "lost", "p99", "max");
+    }
+    printf("\n");
+
+    for (i = 0; i < NUM_SOURCES; i++) {
+        printf("%-16s", srcDefs[i].name);
+        for (p = 0; p < NUM_POLICIES; p++) {
+            const Source *s = &sims[p].src[i];
+
+            if (!s->taken) {
+                printf(" | %8s %5s %5s %5s", "-", "-", "-", "-");
+                continue;
+            }
+            printf(" | %8u %5u %5.0f %5.0f%s", s->taken, s->lost,
+                   (double)percentile(s, 0.99) / CYCLES_PER_US,
+                   (double)s->latencyMax / CYCLES_PER_US,
+                   s->latencyMax >= HIST_CYCLES ? "+" : "");
+        }
+        printf("\n");
+    }
+
+    printf("%-16s", "cpu in handlers");
+    for (p = 0; p < NUM_POLICIES; p++) {
+        printf(" | %24.1f%%", 100.0 * sims[p].busy / (seconds * MCLK_HZ));
+    }
+    printf("\n%-16s", "main loop decode");
+    for (p = 0; p < NUM_POLICIES; p++) {
+        printf(" | %24.1f%%", 100.0 * sims[p].deferred / (seconds * MCLK_HZ));
+    }
+    printf("\n");
+}
+
+int main(int argc, char **argv) {
+    static Sim sims[NUM_POLICIES];
+    unsigned seconds = argc > 1 ? (unsigned)atoi(argv[1]) : DEFAULT_SECONDS;
+    uint64_t seed = argc > 2 ? strtoull(argv[2], 0, 0) : 1;
+    uint8_t load, p;
+
+    if (!seconds) seconds = DEFAULT_SECONDS;
+
+    printf("%u s per run at %lu Hz MCLK, seed %llu; latency in us, "
+           "request to handler\n", seconds, MCLK_HZ,
+           (unsigned long long)seed);
+
+    for (load = 0; load < NUM_LOADS; load++) {
+        for (p = 0; p < NUM_POLICIES; p++) {
+            /* The same seed for every policy of a load */
+            rng = seed * 0x9E3779B97F4A7C15ULL + load + 1;
+            simInit(&sims[p], (Policy)p, (Load)load);
+            run(&sims[p], (uint64_t)seconds * MCLK_HZ);
+        }
+        report((Load)load, sims, seconds);
+    }
+    return 0;
+}
@@ -0,0 +1,371 @@
+#include <string.h>
+#include "microsim.h"
+#include "sim_random.h"
+
+const char *const movementName[NUM_MOVEMENTS] = {
+    "NL", "NT", "NR", "SL", "ST", "SR", "EL", "ET", "ER", "WL", "WT", "WR"
+};
+
+/* Weekday peak-hour volumes, veh/h */
+const Demand defaultDemand = {{
+    150, 600, 100,      /* north */
+    150, 600, 100,      /* south */
+     80, 400,  80,      /* east */
+     80, 400,  80       /* west */
+}};
+
+/* ============================================================================
+ * GEOMETRY
+ * Lanes and saturation headway per movement, and which chain detector sits
+ * at its stop bar and upstream of it (-1: none). North and south lefts are
+ * counted by the bay Hall sensors instead.
+ * ========================================================================= */
+
+typedef struct {
+    uint8_t  lanes;
+    uint16_t headwayMs;
+    int8_t   stopBar;
+    int8_t   advance;
+} MovementGeometry;
+
+static const MovementGeometry geometry[NUM_MOVEMENTS] = {
+    { 1, SIM_TURN_HEADWAY_MS, -1,           -1                 },   /* NL */
+    { 2, SIM_HEADWAY_MS,      DET_N_THRU,   DET_N_THRU_ADVANCE },   /* NT */
+    { 1, SIM_TURN_HEADWAY_MS, -1,           -1                 },   /* NR */
+    { 1, SIM_TURN_HEADWAY_MS, -1,           -1                 },   /* SL */
+    { 2, SIM_HEADWAY_MS,      DET_S_THRU,   DET_S_THRU_ADVANCE },   /* ST */
+    { 1, SIM_TURN_HEADWAY_MS, DET_S_RIGHT,  -1                 },   /* SR */
+    { 1, SIM_TURN_HEADWAY_MS, DET_E_LEFT,   -1                 },   /* EL */
+    { 2, SIM_HEADWAY_MS,      DET_E_THRU,   DET_E_THRU_ADVANCE },   /* ET */
+    { 1, SIM_TURN_HEADWAY_MS, -1,           -1                 },   /* ER */
+    { 1, SIM_TURN_HEADWAY_MS, -1,           -1                 },   /* WL */
+    { 2, SIM_HEADWAY_MS,      DET_W_THRU,   DET_W_THRU_ADVANCE },   /* WT */
+    { 1, SIM_TURN_HEADWAY_MS, DET_W_RIGHT,  -1                 }    /* WR */
+};
+
+/* ============================================================================
+ * SIMULATED BOARD
+ * ========================================================================= */
+
+typedef enum {
+    GO_STOP = 0,
+    GO_YELLOW,
+    GO_PERMISSIVE,
+    GO_PROTECTED
+} Indication;
+
+typedef struct {
+    uint32_t arrival[SIM_LANE_CAPACITY];
+    uint16_t head;
+    uint16_t count;
+    uint32_t nextDepartMs;      /* saturation headway / start-up lost time */
+    uint32_t yellowSinceMs;
+    Indication shown;
+} Lane;
+
+typedef struct {
+    LEDState leds;
+    uint16_t detBusy[NUM_DETECTORS];    /* ms left occupied */
+    uint16_t bayBusy[NUM_LEFT_BAYS];
+    bool     bayMasked[NUM_LEFT_BAYS];
+    DetLog   log;
+    Lane     lane[NUM_MOVEMENTS][SIM_MAX_LANES];
+    uint64_t rng;
+} SimBoard;
+
+static void simShowSignals(void *board, const LEDState *leds) {
+    ((SimBoard *)board)->leds = *leds;
+}
+
+static void simShowPeds(void *board, const uint8_t image[NUM_DEVICES]) {
+    (void)board;
+    (void)image;
+}
+
+static void simSetBuzzer(void *board, uint8_t device, bool on) {
+    (void)board;
+    (void)device;
+    (void)on;
+}
+
+static bool simBayOccupied(void *board, LeftBay bay) {
+    return ((SimBoard *)board)->bayBusy[bay] != 0;
+}
+
+static void simMaskBay(void *board, LeftBay bay, bool masked) {
+    ((SimBoard *)board)->bayMasked[bay] = masked;
+}
+
+static bool simBayChattered(void *board, LeftBay bay) {
+    (void)board;
+    (void)bay;
+    return false;
+}
+
+static void simSetFaultLamp(void *board, bool on) {
+    (void)board;
+    (void)on;
+}
+
+static const CtlBindings simBindings = {
+    simShowSignals,
+    simShowPeds,
+    simSetBuzzer,
+    simBayOccupied,
+    simMaskBay,
+    simBayChattered,
+    simSetFaultLamp
+};
+
+/* ============================================================================
+ * INDICATIONS
+ * What the heads let each movement do. A left whose combo head shows
+ * neither red nor green while its through is green is in its flashing
+ * yellow arrow window, whichever half of the flash is lit.
+ * ========================================================================= */
+
+static Indication comboLeft(LEDState *leds, uint8_t arrow, uint8_t red,
+                            uint8_t yellow, uint8_t green, uint8_t thruGreen) {
+    if (getLED(leds, arrow)) return GO_PROTECTED;
+    if (getLED(leds, thruGreen) &&
+        !getLED(leds, red) && !getLED(leds, green)) {
+        return GO_PERMISSIVE;
+    }
+    if (getLED(leds, yellow)) return GO_YELLOW;
+    return GO_STOP;
+}
+
+static Indication head(LEDState *leds, uint8_t green, uint8_t yellow,
+                       Indication onGreen) {
+    if (getLED(leds, green)) return onGreen;
+    if (getLED(leds, yellow)) return GO_YELLOW;
+    return GO_STOP;
+}
+
+static Indication indication(LEDState *leds, Movement mv) {
+    switch (mv) {
+        case MV_N_LEFT:
+            return comboLeft(leds, N_LEFT_GREEN_ARROW, N_COMBO_RED,
+                             N_COMBO_YELLOW, N_COMBO_GREEN, N_THRU_GREEN);
+        case MV_N_THRU:
+        case MV_N_RIGHT:
+            return head(leds, N_THRU_GREEN, N_THRU_YELLOW, GO_PROTECTED);
+        case MV_S_LEFT:
+            return comboLeft(leds, S_LEFT_GREEN_ARROW, S_COMBO_RED,
+                             S_COMBO_YELLOW, S_COMBO_GREEN, S_THRU_GREEN);
+        case MV_S_THRU:
+            return head(leds, S_THRU_GREEN, S_THRU_YELLOW, GO_PROTECTED);
+        case MV_S_RIGHT:
+            if (getLED(leds, S_RIGHT_GREEN_ARROW)) return GO_PROTECTED;
+            return head(leds, S_RIGHT_GREEN_BALL, S_RIGHT_YELLOW,
+                        GO_PROTECTED);
+        case MV_E_LEFT:
+            return head(leds, E_THRU_LEFT_GREEN, E_THRU_LEFT_YELLOW,
+                        GO_PERMISSIVE);
+        case MV_E_THRU:
+        case MV_E_RIGHT:
+            return head(leds, E_THRU_RIGHT_GREEN, E_THRU_RIGHT_YELLOW,
+                        GO_PROTECTED);
+        case MV_W_LEFT:
+            return head(leds, W_THRU_GREEN, W_THRU_YELLOW, GO_PERMISSIVE);
+        case MV_W_THRU:
+            return head(leds, W_THRU_GREEN, W_THRU_YELLOW, GO_PROTECTED);
+        case MV_W_RIGHT:
+            if (getLED(leds, W_RIGHT_GREEN_ARROW)) return GO_PROTECTED;
+            return head(leds, W_RIGHT_GREEN_BALL, W_RIGHT_YELLOW,
+                        GO_PROTECTED);
+        default:
+            return GO_STOP;
+    }
+}
+
+/* ============================================================================
+ * ARRIVALS
+ * ========================================================================= */
+
+static Lane *shortestLane(SimBoard *board, Movement mv) {
+    Lane *best = &board->lane[mv][0];
+    uint8_t l;
+
+    for (l = 1; l < geometry[mv].lanes; l++) {
+        if (board->lane[mv][l].count < best->count) best = &board->lane[mv][l];
+    }
+    return best;
+}
+
+static void arrive(IntersectionContext *ctx, SimBoard *board, SimStats *stats,
+                   Movement mv, uint32_t now, bool measuring) {
+    Lane *lane = shortestLane(board, mv);
+
+    if (lane->count == SIM_LANE_CAPACITY) {
+        if (measuring) stats->mv[mv].dropped++;
+        return;
+    }
+    lane->arrival[(lane->head + lane->count) % SIM_LANE_CAPACITY] = now;
+    lane->count++;
+
+    if (geometry[mv].advance >= 0) {
+        board->detBusy[geometry[mv].advance] = SIM_OCCUPANCY_MS;
+    }
+    if (mv == MV_N_LEFT || mv == MV_S_LEFT) {
+        LeftBay bay = (mv == MV_N_LEFT) ? BAY_NORTH_LEFT : BAY_SOUTH_LEFT;
+
+        board->bayBusy[bay] = SIM_OCCUPANCY_MS;
+        if (!board->bayMasked[bay]) ctlLeftArrival(ctx, bay);
+    }
+}
+
+/* ============================================================================
+ * DISCHARGE
+ * ========================================================================= */
+
+static void discharge(SimBoard *board, SimStats *stats, Movement mv,
+                      uint32_t now, bool measuring) {
+    Indication go = indication(&board->leds, mv);
+    uint16_t headway = (go == GO_PERMISSIVE) ? SIM_PERMISSIVE_HEADWAY_MS
+                                              : geometry[mv].headwayMs;
+    MovementStats *ms = &stats->mv[mv];
+    uint16_t queued = 0;
+    uint8_t l;
+
+    for (l = 0; l < geometry[mv].lanes; l++) {
+        Lane *lane = &board->lane[mv][l];
+        bool moving;
+
+        if (go != lane->shown) {
+            if (lane->shown == GO_STOP) {
+                lane->nextDepartMs = now + SIM_STARTUP_LOST_MS;
+            }
+            if (go == GO_YELLOW) lane->yellowSinceMs = now;
+            lane->shown = go;
+        }
+
+        moving = go == GO_PROTECTED || go == GO_PERMISSIVE ||
+                 (go == GO_YELLOW && now - lane->yellowSinceMs <
+                                     SIM_YELLOW_USED_MS);
+
+        if (moving && lane->count != 0 && now >= lane->nextDepartMs) {
+            uint32_t waited = now - lane->arrival[lane->head];
+
+            lane->head = (uint16_t)((lane->head + 1) % SIM_LANE_CAPACITY);
+            lane->count--;
+            lane->nextDepartMs = now + headway;
+            if (measuring) {
+                ms->departures++;
+                ms->delayMs += waited;
+                if (waited != 0) ms->stops++;
+            }
+            if (geometry[mv].stopBar >= 0) {
+                board->detBusy[geometry[mv].stopBar] = SIM_OCCUPANCY_MS;
+            }
+        }
+        queued += lane->count;
+    }
+
+    if (geometry[mv].stopBar >= 0 && queued != 0) {
+        board->detBusy[geometry[mv].stopBar] = SIM_OCCUPANCY_MS;
+    }
+    if (measuring) {
+        ms->queueMs += queued;
+        if (queued > ms->maxQueue) ms->maxQueue = queued;
+    }
+}
+
+static void scanDetectors(IntersectionContext *ctx, SimBoard *board) {
+    uint8_t scan[DET_CHAIN_DEVICES];
+    uint8_t d;
+
+    memset(scan, 0xFF, sizeof scan);            /* active LOW */
+    for (d = 0; d < NUM_DETECTORS; d++) {
+        if (board->detBusy[d] != 0) scan[DET_BYTE(d)] &= ~DET_MASK(d);
+    }
+    ctlDetectorScan(ctx, scan);
+}
+
+/* ============================================================================
+ * RUN
+ * ========================================================================= */
+
+void simRun(const SimConfig *cfg, SimStats *stats) {
+    IntersectionContext ctx;
+    TimerWheel wheel;
+    SimBoard board;
+    uint32_t next = 0;          /* trace cursor */
+    uint32_t now, d;
+
+    memset(&board, 0, sizeof board);
+    memset(stats, 0, sizeof *stats);
+    board.rng = cfg->seed ? cfg->seed : 0x9E3779B97F4A7C15ULL;
+    stats->measuredMs = cfg->durationMs > cfg->warmupMs
+                      ? cfg->durationMs - cfg->warmupMs : 0;
+
+    wheelInit(&wheel, 0);
+    ctlInit(&ctx, &simBindings, &board, &wheel, &board.log);
+    ctx.planOverride = cfg->plan;
+    ctlRtcSecond(&ctx, cfg->startMsOfDay % COORD_MS_PER_DAY, 0);
+    ctlStart(&ctx);
+    if (cfg->mode == MODE_HIGH_TRAFFIC) {
+        ctlCommand(&ctx, CMD_MODE_HIGH_TRAFFIC, APPROACH_NORTH);
+    }
+
+    for (now = 1; now <= cfg->durationMs; now++) {
+        bool measuring = now > cfg->warmupMs;
+
+        wheelAdvance(&wheel, now);
+
+        for (d = 0; d < NUM_DETECTORS; d++) {
+            if (board.detBusy[d] != 0) board.detBusy[d]--;
+        }
+        for (d = 0; d < NUM_LEFT_BAYS; d++) {
+            if (board.bayBusy[d] != 0) board.bayBusy[d]--;
+        }
+
+        if (cfg->trace) {
+            while (next < cfg->traceLen && cfg->trace[next].timeMs <= now) {
+                if (cfg->trace[next].movement < NUM_MOVEMENTS) {
+                    arrive(&ctx, &board, stats,
+                           (Movement)cfg->trace[next].movement, now,
+                           measuring);
+                }
+                next++;
+            }
+        } else {
+            for (d = 0; d < NUM_MOVEMENTS; d++) {
+                if (arrives(&board.rng, cfg->demand->vph[d])) {
+                    arrive(&ctx, &board, stats, (Movement)d, now,
+                           measuring);
+                }
+            }
+        }
+        for (d = 0; d < NUM_DEVICES; d++) {
+            if (arrives(&board.rng, cfg->pedPerHour)) ctlPedButton(&ctx, d);
+        }
+
+        for (d = 0; d < NUM_MOVEMENTS; d++) {
+            discharge(&board, stats, (Movement)d, now, measuring);
+        }
+
+        if (now % DET_SCAN_PERIOD_MS == 0) scanDetectors(&ctx, &board);
+        if (now % FYA_FLASH_HALF_PERIOD_MS == 0) {
+            ctlFyaFlash(&ctx, (now / FYA_FLASH_HALF_PERIOD_MS) & 1);
+        }
+        if (now % 1000 == 0) {
+            ctlRtcSecond(&ctx, (cfg->startMsOfDay + now) % COORD_MS_PER_DAY,
+                         now);
+        }
+
+        ctlStep(&ctx);
+    }
+}
+
+bool simParseMovement(const char *name, Movement *mv) {
+    uint8_t m;
+
+    for (m = 0; m < NUM_MOVEMENTS; m++) {
+        if (strcmp(name, movementName[m]) == 0) {
+            *mv = (Movement)m;
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,104 @@
+#ifndef MICROSIM_H
+#define MICROSIM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "controller.h"
+
+/* ============================================================================
+ * VEHICLE MICROSIMULATOR
+ *
+ * Runs one IntersectionContext (controller.c) against simulated traffic on
+ * a 1 ms clock:
+ *
+ *   arrivals    Poisson per movement (SimConfig.demand, veh/h) or replayed
+ *               from a trace of (ms, movement) records
+ *   queues      each movement has one or more lanes; an arrival joins the
+ *               shortest. Queued vehicles sit at the stop line.
+ *   discharge   one vehicle per lane every saturation headway while the
+ *               movement may go, after a start-up lost time; permissive
+ *               movements use a longer headway, and the first
+ *               SIM_YELLOW_USED_MS of a yellow are still used
+ *   detectors   arrivals pulse the advance detectors and the left-bay Hall
+ *               sensors (ctlLeftArrival, as Port_2_ISR would); stop-bar
+ *               detectors are occupied while their movement is queued. The
+ *               chain is scanned into ctlDetectorScan() every
+ *               DET_SCAN_PERIOD_MS, as the DMA interrupt would
+ *
+ * What each movement may do is read back from the LEDState the controller
+ * shows, so any plan compiled from traffic_states.c is simulated exactly
+ * as it would drive the heads. Statistics cover vehicles that leave after
+ * the warm-up.
+ *
+ * simRun() touches nothing but its arguments, so runs may execute on any
+ * number of threads at once.
+ * ========================================================================= */
+
+#define SIM_MAX_LANES           2
+#define SIM_LANE_CAPACITY       256     /* vehicles queued per lane */
+#define SIM_STARTUP_LOST_MS     2000
+#define SIM_YELLOW_USED_MS      2000
+#define SIM_HEADWAY_MS          2000    /* 1800 veh/h/lane */
+#define SIM_TURN_HEADWAY_MS     2400
+#define SIM_PERMISSIVE_HEADWAY_MS 5000  /* filtering through opposing flow */
+#define SIM_OCCUPANCY_MS        300     /* one vehicle over a detector */
+
+typedef enum {
+    MV_N_LEFT = 0,
+    MV_N_THRU,
+    MV_N_RIGHT,
+    MV_S_LEFT,
+    MV_S_THRU,
+    MV_S_RIGHT,
+    MV_E_LEFT,
+    MV_E_THRU,
+    MV_E_RIGHT,
+    MV_W_LEFT,
+    MV_W_THRU,
+    MV_W_RIGHT,
+    NUM_MOVEMENTS
+} Movement;
+
+typedef struct {
+    uint16_t vph[NUM_MOVEMENTS];
+} Demand;
+
+typedef struct {
+    uint32_t timeMs;
+    uint8_t  movement;
+} TraceArrival;
+
+typedef struct {
+    OperatingMode       mode;           /* MODE_DAYTIME or MODE_HIGH_TRAFFIC */
+    const PhasePlan    *plan;           /* in place of the mode's, if set */
+    const Demand       *demand;         /* Poisson arrivals, or */
+    const TraceArrival *trace;          /* ascending timeMs, if non-null */
+    uint32_t            traceLen;
+    uint16_t            pedPerHour;     /* push-button calls per crosswalk */
+    uint32_t            startMsOfDay;   /* RTC time at the start */
+    uint32_t            warmupMs;
+    uint32_t            durationMs;     /* including the warm-up */
+    uint64_t            seed;
+} SimConfig;
+
+typedef struct {
+    uint32_t departures;
+    uint32_t stops;             /* had to wait at the stop line */
+    uint64_t delayMs;           /* summed stop-line delay */
+    uint64_t queueMs;           /* queue length integrated over time */
+    uint16_t maxQueue;
+    uint32_t dropped;           /* arrivals lost to a full lane */
+} MovementStats;
+
+typedef struct {
+    MovementStats mv[NUM_MOVEMENTS];
+    uint32_t      measuredMs;   /* durationMs - warmupMs */
+} SimStats;
+
+extern const char  *const movementName[NUM_MOVEMENTS];
+extern const Demand defaultDemand;
+
+void simRun(const SimConfig *cfg, SimStats *stats);
+bool simParseMovement(const char *name, Movement *mv);
+
+#endif /* MICROSIM_H */
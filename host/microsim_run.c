@@ -0,0 +1,261 @@
+/* ============================================================================
+ * MICROSIMULATOR RUNNER
+ *
+ * Runs the vehicle microsimulator (microsim.c) for every seed of every
+ * intersection, spread over a pool of threads, and reports per movement:
+ * throughput, delay (mean and spread across runs), stops, mean and maximum
+ * queue. Arrivals are Poisson at the default peak-hour demand scaled by -x,
+ * or replayed from a trace file of "<ms> <movement>" lines (NL NT NR SL ST
+ * SR EL ET ER WL WT WR), in which case seeds only vary the push buttons.
+ *
+ * Build from the repository root:
+ *
+ *   cc -std=c99 -O2 -Wall -I. -Ihost -o microsim host/microsim_run.c \
+ *      host/microsim.c controller.c traffic_states.c ring_engine.c \
+ *      transit_priority.c preemption.c coordination.c queue_model.c fya.c \
+ *      dilemma_zone.c detector_bus.c detector_health.c timer_wheel.c \
+ *      -lpthread -lm
+ *
+ * Run:  ./microsim [-p day|high] [-n intersections] [-s seeds]
+ *                  [-j threads] [-m minutes] [-w warm-up minutes]
+ *                  [-x demand scale] [-t trace file]
+ * ========================================================================= */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "microsim.h"
+
+#define DEFAULT_INTERSECTIONS   4
+#define DEFAULT_SEEDS           8
+#define DEFAULT_THREADS         4
+#define DEFAULT_MINUTES         60
+#define DEFAULT_WARMUP_MINUTES  5
+#define PED_PER_HOUR            30      /* per crosswalk */
+#define START_MS_OF_DAY         (7UL * 3600000UL)   /* 07:00 */
+
+typedef struct {
+    const SimConfig *base;
+    SimStats        *stats;
+    uint32_t         runs;
+    uint32_t         first;     /* this worker takes first, first + stride.. */
+    uint32_t         stride;
+} Worker;
+
+static void *runWorker(void *arg) {
+    Worker *w = arg;
+    uint32_t r;
+
+    for (r = w->first; r < w->runs; r += w->stride) {
+        SimConfig cfg = *w->base;
+
+        cfg.seed = 0x9E3779B97F4A7C15ULL * (r + 1);
+        simRun(&cfg, &w->stats[r]);
+    }
+    return NULL;
+}
+
+/* ============================================================================
+ * TRACE FILES
+ * ========================================================================= */
+
+static TraceArrival *loadTrace(const char *path, uint32_t *len) {
+    FILE *f = fopen(path, "r");
+    TraceArrival *trace = NULL;
+    uint32_t cap = 0, n = 0;
+    unsigned long ms;
+    char name[8];
+
+    if (!f) return NULL;
+    while (fscanf(f, "%lu %7s", &ms, name) == 2) {
+        Movement mv;
+
+        if (!simParseMovement(name, &mv)) continue;
+        if (n == cap) {
+            TraceArrival *grown;
+
+            cap = cap ? cap * 2 : 1024;
+            grown = realloc(trace, cap * sizeof *trace);
+            if (!grown) break;
+            trace = grown;
+        }
+        if (n != 0 && ms < trace[n - 1].timeMs) break;  /* must ascend */
+        trace[n].timeMs   = (uint32_t)ms;
+        trace[n].movement = (uint8_t)mv;
+        n++;
+    }
+    fclose(f);
+    *len = n;
+    return trace;
+}
+
+/* ============================================================================
+ * REPORT
+ * ========================================================================= */
+
+static void report(const SimConfig *cfg, const SimStats *stats, uint32_t runs) {
+    double hours = (double)stats[0].measuredMs / 3600000.0;
+    double totalVeh = 0.0, totalDelay = 0.0;
+    uint8_t m;
+
+    printf("%-3s %8s %8s %8s %8s %6s %8s %6s %6s\n",
+           "mv", "demand", "veh/h", "delay s", "+/- s", "stop%",
+           "queue", "max", "lost");
+
+    for (m = 0; m < NUM_MOVEMENTS; m++) {
+        double veh = 0.0, delay = 0.0, stops = 0.0, queue = 0.0;
+        double mean = 0.0, m2 = 0.0;
+        uint32_t maxQueue = 0, lost = 0, r, counted = 0;
+
+        for (r = 0; r < runs; r++) {
+            const MovementStats *ms = &stats[r].mv[m];
+
+            veh   += ms->departures;
+            delay += (double)ms->delayMs / 1000.0;
+            stops += ms->stops;
+            queue += (double)ms->queueMs / stats[r].measuredMs;
+            lost  += ms->dropped;
+            if (ms->maxQueue > maxQueue) maxQueue = ms->maxQueue;
+
+            if (ms->departures != 0) {          /* Welford, per-run delay */
+                double d = (double)ms->delayMs / 1000.0 / ms->departures;
+                double step = d - mean;
+
+                counted++;
+                mean += step / counted;
+                m2   += step * (d - mean);
+            }
+        }
+        totalVeh   += veh;
+        totalDelay += delay;
+
+        printf("%-3s %8.0f %8.0f %8.1f %8.1f %6.1f %8.2f %6u %6u\n",
+               movementName[m],
+               cfg->trace ? 0.0 : (double)cfg->demand->vph[m],
+               veh / runs / hours,
+               veh != 0.0 ? delay / veh : 0.0,
+               counted > 1 ? sqrt(m2 / (counted - 1)) : 0.0,
+               veh != 0.0 ? 100.0 * stops / veh : 0.0,
+               queue / runs, maxQueue, lost);
+    }
+
+    printf("all %8s %8.0f %8.1f\n", "",
+           totalVeh / runs / hours,
+           totalVeh != 0.0 ? totalDelay / totalVeh : 0.0);
+}
+
+static void usage(const char *self) {
+    fprintf(stderr,
+            "usage: %s [-p day|high] [-n intersections] [-s seeds] "
+            "[-j threads]\n"
+            "       [-m minutes] [-w warm-up minutes] [-x demand scale] "
+            "[-t trace]\n", self);
+}
+
+int main(int argc, char **argv) {
+    uint32_t intersections = DEFAULT_INTERSECTIONS;
+    uint32_t seeds   = DEFAULT_SEEDS;
+    uint32_t threads = DEFAULT_THREADS;
+    uint32_t minutes = DEFAULT_MINUTES;
+    uint32_t warmup  = DEFAULT_WARMUP_MINUTES;
+    double scale = 1.0;
+    const char *tracePath = NULL;
+    TraceArrival *trace = NULL;
+    Demand demand;
+    SimConfig cfg;
+    SimStats *stats;
+    Worker *worker;
+    pthread_t *tid;
+    uint32_t runs, t, m;
+    int opt;
+
+    memset(&cfg, 0, sizeof cfg);
+    cfg.mode = MODE_DAYTIME;
+
+    while ((opt = getopt(argc, argv, "p:n:s:j:m:w:x:t:")) != -1) {
+        switch (opt) {
+            case 'p':
+                if (strcmp(optarg, "day") == 0) cfg.mode = MODE_DAYTIME;
+                else if (strcmp(optarg, "high") == 0) {
+                    cfg.mode = MODE_HIGH_TRAFFIC;
+                } else {
+                    usage(argv[0]);
+                    return 1;
+                }
+                break;
+            case 'n': intersections = (uint32_t)atoi(optarg); break;
+            case 's': seeds   = (uint32_t)atoi(optarg);       break;
+            case 'j': threads = (uint32_t)atoi(optarg);       break;
+            case 'm': minutes = (uint32_t)atoi(optarg);       break;
+            case 'w': warmup  = (uint32_t)atoi(optarg);       break;
+            case 'x': scale   = atof(optarg);                 break;
+            case 't': tracePath = optarg;                     break;
+            default:
+                usage(argv[0]);
+                return 1;
+        }
+    }
+
+    runs = intersections * seeds;
+    if (runs == 0 || threads == 0 || minutes == 0 || scale < 0.0) {
+        usage(argv[0]);
+        return 1;
+    }
+    if (threads > runs) threads = runs;
+
+    for (m = 0; m < NUM_MOVEMENTS; m++) {
+        double vph = defaultDemand.vph[m] * scale;
+        demand.vph[m] = (uint16_t)(vph > UINT16_MAX ? UINT16_MAX : vph);
+    }
+
+    if (tracePath) {
+        trace = loadTrace(tracePath, &cfg.traceLen);
+        if (!trace || cfg.traceLen == 0) {
+            fprintf(stderr, "%s: no arrivals read\n", tracePath);
+            return 1;
+        }
+    }
+
+    cfg.demand       = &demand;
+    cfg.trace        = trace;
+    cfg.pedPerHour   = PED_PER_HOUR;
+    cfg.startMsOfDay = START_MS_OF_DAY;
+    cfg.warmupMs     = warmup * 60000UL;
+    cfg.durationMs   = (minutes + warmup) * 60000UL;
+
+    stats  = calloc(runs, sizeof *stats);
+    worker = calloc(threads, sizeof *worker);
+    tid    = calloc(threads, sizeof *tid);
+    if (!stats || !worker || !tid) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+
+    for (t = 0; t < threads; t++) {
+        worker[t].base   = &cfg;
+        worker[t].stats  = stats;
+        worker[t].runs   = runs;
+        worker[t].first  = t;
+        worker[t].stride = threads;
+        pthread_create(&tid[t], NULL, runWorker, &worker[t]);
+    }
+    for (t = 0; t < threads; t++) pthread_join(tid[t], NULL);
+
+    printf("%s plan, %u intersections x %u seeds, %u min after %u min "
+           "warm-up, %s arrivals\n",
+           cfg.mode == MODE_HIGH_TRAFFIC ? "high traffic" : "daytime",
+           intersections, seeds, minutes, warmup,
+           trace ? "trace" : "Poisson");
+    report(&cfg, stats, runs);
+
+    free(tid);
+    free(worker);
+    free(stats);
+    free(trace);
+    return 0;
+}
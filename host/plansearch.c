@@ -0,0 +1,461 @@
+/* ============================================================================
+ * OFFLINE PLAN SEARCH
+ *
+ * Retimes the green times of the daytime or high-traffic plan against
+ * recorded demand. Every candidate timing is compiled into a PhasePlan the
+ * way traffic_states.c composes it from the TIME_* constants, handed to the
+ * controller through IntersectionContext.planOverride, and scored by the
+ * microsimulator (microsim.c) over the same seeds, so candidates differ
+ * only in their timing. The score is the queue integrated over the run -
+ * the total stop-line delay, vehicles still waiting at the end included.
+ *
+ * The search is a pattern search: each round tries every tuned constant
+ * one step up and one step down, moves to the best candidate if it beats
+ * the incumbent and halves the step otherwise, from PS_STEP_START_MS down
+ * to PS_STEP_END_MS. Splits change individually, so the cycle length
+ * moves with them. Candidate x seed simulations run on a pool of threads,
+ * one per core by default.
+ *
+ * Demand is either a trace of "<ms> <movement>" arrivals, as read by the
+ * microsimulator runner, or a volume file of "<movement> <veh/h>" counts
+ * replayed as Poisson arrivals (movements NL NT NR SL ST SR EL ET ER WL WT
+ * WR; unlisted movements keep the default demand).
+ *
+ * The search's own scores are in-sample: the winner is the candidate that
+ * did best on those seeds, noise included. The compiled and the tuned
+ * timing are therefore re-scored on as many fresh seeds before the
+ * prediction is printed, and that is the prediction the header records.
+ *
+ * The result is written as a timing header defining all eleven green
+ * times; build the firmware with -DTIMING_HEADER='"timing.h"' to use it.
+ *
+ * Build from the repository root:
+ *
+ *   cc -std=c99 -O2 -Wall -I. -Ihost -o plansearch host/plansearch.c \
+ *      host/microsim.c controller.c traffic_states.c ring_engine.c \
+ *      transit_priority.c preemption.c coordination.c queue_model.c fya.c \
+ *      dilemma_zone.c detector_bus.c detector_health.c timer_wheel.c \
+ *      -lpthread
+ *
+ * Run:  ./plansearch [-p day|high] [-t trace | -v volumes] [-s seeds]
+ *                    [-m minutes] [-j threads] [-o timing.h]
+ * ========================================================================= */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "microsim.h"
+
+#define DEFAULT_SEEDS           4
+#define DEFAULT_MINUTES         30
+#define WARMUP_MINUTES          5
+#define PED_PER_HOUR            30
+#define START_MS_OF_DAY         (7UL * 3600000UL)   /* 07:00 */
+
+#define PS_STEP_START_MS        4000
+#define PS_STEP_END_MS          500
+#define PS_MAX_GREEN_MS         40000
+#define PS_MAX_ROUNDS           64
+
+/* ============================================================================
+ * TUNABLE CONSTANTS
+ * ========================================================================= */
+
+typedef enum {
+    P_NS_GREEN = 0,
+    P_N_LEFT_GREEN,
+    P_S_LEFT_GREEN,
+    P_W_THRU_GREEN,
+    P_E_THRU_GREEN,
+    P_N_SOLO_GREEN,
+    P_S_LEFT_DURING_N,
+    P_NS_BOTH_GREEN,
+    P_N_LEFT_DURING_S,
+    P_W_THRU_GREEN_HT,
+    P_E_THRU_GREEN_HT,
+    NUM_PARAMS
+} Param;
+
+typedef struct {
+    const char *name;
+    uint16_t    compiled;
+    uint16_t    min;
+    bool        highTraffic;    /* belongs to the high-traffic plan */
+} ParamDef;
+
+#define PARAM(name, min, ht)    { #name, name, min, ht }
+
+static const ParamDef paramDefs[NUM_PARAMS] = {
+    PARAM(TIME_NS_GREEN,        TIME_MIN_GREEN,      false),
+    PARAM(TIME_N_LEFT_GREEN,    TIME_MIN_LEFT_GREEN, false),
+    PARAM(TIME_S_LEFT_GREEN,    TIME_MIN_LEFT_GREEN, false),
+    PARAM(TIME_W_THRU_GREEN,    TIME_MIN_GREEN,      false),
+    PARAM(TIME_E_THRU_GREEN,    TIME_MIN_GREEN,      false),
+    PARAM(TIME_N_SOLO_GREEN,    TIME_MIN_GREEN,      true),
+    PARAM(TIME_S_LEFT_DURING_N, TIME_MIN_LEFT_GREEN, true),
+    PARAM(TIME_NS_BOTH_GREEN,   TIME_MIN_GREEN,      true),
+    PARAM(TIME_N_LEFT_DURING_S, TIME_MIN_LEFT_GREEN, true),
+    PARAM(TIME_W_THRU_GREEN_HT, TIME_MIN_GREEN,      true),
+    PARAM(TIME_E_THRU_GREEN_HT, TIME_MIN_GREEN,      true)
+};
+
+typedef struct {
+    uint16_t value[NUM_PARAMS];
+} Timing;
+
+/* The high-traffic N through split is the sum of three constants */
+static bool splitsFit(const Timing *t) {
+    const uint16_t *v = t->value;
+
+    return (uint32_t)v[P_N_SOLO_GREEN] + v[P_S_LEFT_DURING_N] +
+           v[P_NS_BOTH_GREEN] <= UINT16_MAX;
+}
+
+/* The splits traffic_states.c builds from the same constants */
+static void buildPlan(OperatingMode mode, const Timing *t, PhasePlan *plan) {
+    const uint16_t *v = t->value;
+
+    *plan = *getPlanForMode(mode);
+    if (mode == MODE_HIGH_TRAFFIC) {
+        plan->split[PHASE_1] = v[P_N_LEFT_DURING_S];
+        plan->split[PHASE_2] = (uint16_t)(v[P_N_SOLO_GREEN] +
+                                          v[P_S_LEFT_DURING_N] +
+                                          v[P_NS_BOTH_GREEN]);
+        plan->split[PHASE_4] = v[P_W_THRU_GREEN_HT];
+        plan->split[PHASE_5] = v[P_S_LEFT_DURING_N];
+        plan->split[PHASE_6] = (uint16_t)(v[P_NS_BOTH_GREEN] +
+                                          v[P_N_LEFT_DURING_S]);
+        plan->split[PHASE_8] = v[P_E_THRU_GREEN_HT];
+    } else {
+        plan->split[PHASE_1] = v[P_N_LEFT_GREEN];
+        plan->split[PHASE_2] = v[P_NS_GREEN];
+        plan->split[PHASE_4] = v[P_W_THRU_GREEN];
+        plan->split[PHASE_5] = v[P_S_LEFT_GREEN];
+        plan->split[PHASE_6] = v[P_NS_GREEN];
+        plan->split[PHASE_8] = v[P_E_THRU_GREEN];
+    }
+}
+
+/* ============================================================================
+ * PARALLEL EVALUATION
+ * A batch is every candidate x every seed; workers take the next job off a
+ * shared counter and add the run's delay into its candidate's cost.
+ * ========================================================================= */
+
+typedef struct {
+    Timing    timing;
+    PhasePlan plan;
+    uint64_t  delayMs;          /* summed over seeds */
+    uint64_t  departures;
+} Candidate;
+
+typedef struct {
+    const SimConfig *base;
+    Candidate       *cand;
+    uint32_t         count;
+    uint32_t         seeds;
+    uint32_t         firstSeed;
+    uint32_t         nextJob;
+    pthread_mutex_t  lock;
+} Batch;
+
+static void *runJobs(void *arg) {
+    Batch *b = arg;
+
+    for (;;) {
+        SimConfig cfg = *b->base;
+        SimStats stats;
+        uint64_t delay = 0, departures = 0;
+        uint32_t job;
+        Candidate *c;
+        uint8_t m;
+
+        pthread_mutex_lock(&b->lock);
+        job = b->nextJob++;
+        pthread_mutex_unlock(&b->lock);
+        if (job >= b->count * b->seeds) break;
+
+        c = &b->cand[job / b->seeds];
+        cfg.plan = &c->plan;
+        cfg.seed = 0x9E3779B97F4A7C15ULL *
+                   (b->firstSeed + job % b->seeds + 1);
+        simRun(&cfg, &stats);
+
+        for (m = 0; m < NUM_MOVEMENTS; m++) {
+            delay      += stats.mv[m].queueMs;
+            departures += stats.mv[m].departures;
+        }
+
+        pthread_mutex_lock(&b->lock);
+        c->delayMs    += delay;
+        c->departures += departures;
+        pthread_mutex_unlock(&b->lock);
+    }
+    return NULL;
+}
+
+/* Scores each candidate over seeds firstSeed .. firstSeed + seeds - 1 */
+static void evaluate(const SimConfig *base, Candidate *cand, uint32_t count,
+                     uint32_t firstSeed, uint32_t seeds, uint32_t threads) {
+    pthread_t tid[threads];
+    Batch b;
+    uint32_t t;
+
+    b.base      = base;
+    b.cand      = cand;
+    b.count     = count;
+    b.seeds     = seeds;
+    b.firstSeed = firstSeed;
+    b.nextJob   = 0;
+    pthread_mutex_init(&b.lock, NULL);
+
+    for (t = 0; t < count; t++) {
+        buildPlan(base->mode, &cand[t].timing, &cand[t].plan);
+        cand[t].delayMs    = 0;
+        cand[t].departures = 0;
+    }
+    for (t = 0; t < threads; t++) pthread_create(&tid[t], NULL, runJobs, &b);
+    for (t = 0; t < threads; t++) pthread_join(tid[t], NULL);
+
+    pthread_mutex_destroy(&b.lock);
+}
+
+/* Mean delay, seconds per vehicle served */
+static double meanDelay(const Candidate *c) {
+    return c->departures ? (double)c->delayMs / 1000.0 / c->departures : 0.0;
+}
+
+/* ============================================================================
+ * DEMAND FILES
+ * ========================================================================= */
+
+static TraceArrival *loadTrace(const char *path, uint32_t *len) {
+    FILE *f = fopen(path, "r");
+    TraceArrival *trace = NULL;
+    uint32_t cap = 0, n = 0;
+    unsigned long ms;
+    char name[8];
+
+    if (!f) return NULL;
+    while (fscanf(f, "%lu %7s", &ms, name) == 2) {
+        Movement mv;
+
+        if (!simParseMovement(name, &mv)) continue;
+        if (n == cap) {
+            TraceArrival *grown;
+
+            cap = cap ? cap * 2 : 1024;
+            grown = realloc(trace, cap * sizeof *trace);
+            if (!grown) break;
+            trace = grown;
+        }
+        if (n != 0 && ms < trace[n - 1].timeMs) break;  /* must ascend */
+        trace[n].timeMs   = (uint32_t)ms;
+        trace[n].movement = (uint8_t)mv;
+        n++;
+    }
+    fclose(f);
+    *len = n;
+    return trace;
+}
+
+static bool loadVolumes(const char *path, Demand *demand) {
+    FILE *f = fopen(path, "r");
+    unsigned vph;
+    char name[8];
+
+    if (!f) return false;
+    while (fscanf(f, "%7s %u", name, &vph) == 2) {
+        Movement mv;
+
+        if (simParseMovement(name, &mv)) {
+            demand->vph[mv] = (uint16_t)(vph > UINT16_MAX ? UINT16_MAX : vph);
+        }
+    }
+    fclose(f);
+    return true;
+}
+
+/* ============================================================================
+ * OUTPUT
+ * ========================================================================= */
+
+static bool writeHeader(const char *path, const SimConfig *cfg,
+                        const Candidate *before, const Candidate *after,
+                        uint32_t seeds, uint32_t minutes) {
+    FILE *f = fopen(path, "w");
+    double d0 = meanDelay(before), d1 = meanDelay(after);
+    uint8_t p;
+
+    if (!f) return false;
+    fprintf(f,
+            "#ifndef PLAN_TIMING_H\n"
+            "#define PLAN_TIMING_H\n\n"
+            "/* Written by host/plansearch.c: %s plan, %s demand, "
+            "%u seeds x %u min\n"
+            " * predicted mean delay %.1f s/veh -> %.1f s/veh (%.1f%% less),\n"
+            " * re-scored on %u seeds the search did not see\n"
+            " * Build with -DTIMING_HEADER='\"%s\"' */\n\n",
+            cfg->mode == MODE_HIGH_TRAFFIC ? "high-traffic" : "daytime",
+            cfg->trace ? "traced" : "volume",
+            seeds, minutes, d0, d1,
+            d0 > 0.0 ? 100.0 * (d0 - d1) / d0 : 0.0, seeds, path);
+    for (p = 0; p < NUM_PARAMS; p++) {
+        fprintf(f, "#define %-24s%6u\n", paramDefs[p].name,
+                after->timing.value[p]);
+    }
+    fprintf(f, "\n#endif /* PLAN_TIMING_H */\n");
+    return fclose(f) == 0;
+}
+
+static void usage(const char *self) {
+    fprintf(stderr,
+            "usage: %s [-p day|high] [-t trace | -v volumes] [-s seeds]\n"
+            "       [-m minutes] [-j threads] [-o timing.h]\n", self);
+}
+
+int main(int argc, char **argv) {
+    OperatingMode mode = MODE_DAYTIME;
+    uint32_t seeds   = DEFAULT_SEEDS;
+    uint32_t minutes = DEFAULT_MINUTES;
+    long     cores   = sysconf(_SC_NPROCESSORS_ONLN);
+    uint32_t threads = cores > 0 ? (uint32_t)cores : 1;
+    const char *tracePath = NULL, *volumePath = NULL;
+    const char *outPath = "timing.h";
+    Demand demand = defaultDemand;
+    TraceArrival *trace = NULL;
+    Candidate baseline, best, cand[2 * NUM_PARAMS], check[2];
+    SimConfig cfg;
+    uint32_t step = PS_STEP_START_MS, round, count;
+    uint8_t p;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "p:t:v:s:m:j:o:")) != -1) {
+        switch (opt) {
+            case 'p':
+                if (strcmp(optarg, "day") == 0) mode = MODE_DAYTIME;
+                else if (strcmp(optarg, "high") == 0) {
+                    mode = MODE_HIGH_TRAFFIC;
+                } else {
+                    usage(argv[0]);
+                    return 1;
+                }
+                break;
+            case 't': tracePath  = optarg;                  break;
+            case 'v': volumePath = optarg;                  break;
+            case 's': seeds   = (uint32_t)atoi(optarg);     break;
+            case 'm': minutes = (uint32_t)atoi(optarg);     break;
+            case 'j': threads = (uint32_t)atoi(optarg);     break;
+            case 'o': outPath = optarg;                     break;
+            default:
+                usage(argv[0]);
+                return 1;
+        }
+    }
+    if (seeds == 0 || minutes == 0 || threads == 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    memset(&cfg, 0, sizeof cfg);
+    cfg.mode         = mode;
+    cfg.demand       = &demand;
+    cfg.pedPerHour   = PED_PER_HOUR;
+    cfg.startMsOfDay = START_MS_OF_DAY;
+    cfg.warmupMs     = WARMUP_MINUTES * 60000UL;
+    cfg.durationMs   = (minutes + WARMUP_MINUTES) * 60000UL;
+
+    if (volumePath && !loadVolumes(volumePath, &demand)) {
+        fprintf(stderr, "%s: cannot read\n", volumePath);
+        return 1;
+    }
+    if (tracePath) {
+        trace = loadTrace(tracePath, &cfg.traceLen);
+        if (!trace || cfg.traceLen == 0) {
+            fprintf(stderr, "%s: no arrivals read\n", tracePath);
+            return 1;
+        }
+        /* The whole trace is measured, plus time for its queues to clear */
+        cfg.trace      = trace;
+        cfg.warmupMs   = 0;
+        cfg.durationMs = trace[cfg.traceLen - 1].timeMs + 120000UL;
+        minutes        = (cfg.durationMs + 59999UL) / 60000UL;
+    }
+
+    for (p = 0; p < NUM_PARAMS; p++) {
+        baseline.timing.value[p] = paramDefs[p].compiled;
+    }
+    evaluate(&cfg, &baseline, 1, 0, seeds, threads);
+    best = baseline;
+    printf("compiled timing: %.2f s/veh\n", meanDelay(&baseline));
+
+    for (round = 0; round < PS_MAX_ROUNDS && step >= PS_STEP_END_MS;
+         round++) {
+        uint32_t i, pick = 0;
+
+        count = 0;
+        for (p = 0; p < NUM_PARAMS; p++) {
+            uint16_t v = best.timing.value[p];
+
+            if (paramDefs[p].highTraffic != (mode == MODE_HIGH_TRAFFIC)) {
+                continue;
+            }
+            if (v + step <= PS_MAX_GREEN_MS) {
+                cand[count].timing = best.timing;
+                cand[count].timing.value[p] = (uint16_t)(v + step);
+                if (splitsFit(&cand[count].timing)) count++;
+            }
+            if (v >= paramDefs[p].min + step) {
+                cand[count].timing = best.timing;
+                cand[count].timing.value[p] = (uint16_t)(v - step);
+                count++;
+            }
+        }
+        evaluate(&cfg, cand, count, 0, seeds, threads);
+
+        for (i = 1; i < count; i++) {
+            if (meanDelay(&cand[i]) < meanDelay(&cand[pick])) pick = i;
+        }
+        if (count != 0 && meanDelay(&cand[pick]) < meanDelay(&best)) {
+            best = cand[pick];
+            printf("round %2u step %4u ms: %.2f s/veh\n",
+                   round + 1, step, meanDelay(&best));
+        } else {
+            step /= 2;
+        }
+    }
+
+    printf("\n%-24s %8s %8s\n", "constant", "compiled", "tuned");
+    for (p = 0; p < NUM_PARAMS; p++) {
+        if (paramDefs[p].highTraffic != (mode == MODE_HIGH_TRAFFIC)) continue;
+        printf("%-24s %8u %8u\n", paramDefs[p].name,
+               paramDefs[p].compiled, best.timing.value[p]);
+    }
+    printf("search seeds: %.2f -> %.2f s/veh\n",
+           meanDelay(&baseline), meanDelay(&best));
+
+    /* Out of sample: seeds the search never scored */
+    check[0].timing = baseline.timing;
+    check[1].timing = best.timing;
+    evaluate(&cfg, check, 2, seeds, seeds, threads);
+    printf("predicted mean delay %.2f -> %.2f s/veh (%.1f%% less) "
+           "on %u fresh seeds\n",
+           meanDelay(&check[0]), meanDelay(&check[1]),
+           meanDelay(&check[0]) > 0.0
+               ? 100.0 * (meanDelay(&check[0]) - meanDelay(&check[1])) /
+                 meanDelay(&check[0])
+               : 0.0, seeds);
+
+    if (!writeHeader(outPath, &cfg, &check[0], &check[1], seeds, minutes)) {
+        fprintf(stderr, "%s: cannot write\n", outPath);
+        return 1;
+    }
+    printf("wrote %s\n", outPath);
+
+    free(trace);
+    return 0;
+}
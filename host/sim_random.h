@@ -0,0 +1,29 @@
+#ifndef SIM_RANDOM_H
+#define SIM_RANDOM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* ============================================================================
+ * HOST SIMULATION RANDOM NUMBERS
+ *
+ * xorshift64 - each simulated intersection carries its own state, so runs
+ * are repeatable per seed and independent across threads. The state must
+ * not be zero.
+ * ========================================================================= */
+
+static inline uint32_t nextRandom(uint64_t *state) {
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    *state = x;
+    return (uint32_t)(x >> 32);
+}
+
+/* True with probability perHour / 3600000 - one call per ms */
+static inline bool arrives(uint64_t *rng, uint32_t perHour) {
+    return (nextRandom(rng) % 3600000UL) < perHour;
+}
+
+#endif /* SIM_RANDOM_H */
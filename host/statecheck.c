@@ -0,0 +1,1374 @@
+/* ============================================================================
+ * STATE-SPACE SAFETY CHECKER
+ *
+ * Proves, for every display the controller can reach, that
+ *
+ *   CONFLICT    no two movements the intersection design keeps apart are
+ *               released together (green, or inside a flashing yellow
+ *               arrow window)
+ *   CLEARANCE   a head that stops releasing shows its steady yellow next,
+ *               and a steady yellow never goes straight back to a release
+ *   ALL-RED     a movement is only released once every movement it
+ *               conflicts with has finished its yellow
+ *
+ * The conflict specification is written out below from the design in
+ * traffic_states.h (the two barriers and the two right-turn overlaps),
+ * independently of phaseDefs[].conflicts, which it is checked against.
+ *
+ * Three passes:
+ *
+ *   tables      phase and overlap definitions against the specification,
+ *               every compatible set of greens rendered and decoded, and
+ *               the clearance times of both plans
+ *   next state  getNextState() for every flash / emergency state in every
+ *               mode, with every engine start it can lead to
+ *   reachable   breadth-first search from power-up over the model below,
+ *               checking every transition
+ *
+ * The model is the sequencing of controller.c - serviceStates(), mode
+ * changes, preemption entry and exit, the FYA latch - around the real
+ * ring_engine.c, preemption.c, getNextState(), executeState() and fya.c,
+ * on a clock of one quantum (the gcd of every clearance and minimum
+ * green). Everything the controller decides from traffic is an input,
+ * chosen every quantum in every combination:
+ *
+ *   calls        any subset of the plan's non-recall phases
+ *   each green   ends now, runs on, or is held (pedestrians, dilemma zone)
+ *   end barrier  spillback or a coordination force-off
+ *   one event    a mode command, a preemption call from any approach, or a
+ *                new FYA schedule
+ *   otherwise    a timed state expires or not, a pedestrian still walking,
+ *                a preemption call still present
+ *
+ * Green lengths are therefore unconstrained; clearances run on their real
+ * timers. Dilemma-zone clearance extensions only lengthen a red and are
+ * not modelled.
+ *
+ * A state is packed into two 64-bit words. Each BFS level is expanded on
+ * every thread against the visited set of the levels before it, each
+ * thread deduplicating its own successors; the level is merged on one
+ * thread. A violation prints the input sequence that reaches it and exits
+ * non-zero.
+ *
+ * Build from the repository root:
+ *
+ *   cc -std=c99 -O2 -Wall -I. -o statecheck host/statecheck.c \
+ *      traffic_states.c ring_engine.c preemption.c fya.c -lpthread
+ *
+ * Run:  ./statecheck [threads]
+ * ========================================================================= */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <time.h>
+#include "traffic_states.h"
+#include "ring_engine.h"
+#include "preemption.h"
+#include "fya.h"
+
+#define SC_MIN_YELLOW_MS        3000
+#define SC_MIN_RED_CLEAR_MS     1000
+#define SC_TIMER_BITS           5       /* clearance timers, in quanta */
+#define SC_ELAPSED_BITS         3       /* green elapsed, capped */
+
+/* ============================================================================
+ * SPECIFICATION
+ * Movements as the heads release them, and which may run together.
+ * ========================================================================= */
+
+typedef enum {
+    G_N_LEFT = 0,
+    G_N_THRU,
+    G_S_LEFT,
+    G_S_THRU,
+    G_S_RIGHT_BALL,
+    G_S_RIGHT_ARROW,
+    G_W_THRU,
+    G_W_RIGHT_BALL,
+    G_W_RIGHT_ARROW,
+    G_E_THRU_LEFT,
+    G_E_THRU_RIGHT,
+    NUM_GROUPS
+} Group;
+
+typedef enum {
+    H_N_LEFT = 0,       /* protected arrow + combo head */
+    H_N_THRU,
+    H_S_LEFT,
+    H_S_THRU,
+    H_S_RIGHT,
+    H_W_THRU,
+    H_W_RIGHT,
+    H_E_THRU_LEFT,
+    H_E_THRU_RIGHT,
+    NUM_HEADS
+} Head;
+
+typedef enum {
+    SHOW_DARK = 0,
+    SHOW_RED,
+    SHOW_YELLOW,        /* steady */
+    SHOW_FLASH,         /* night flashing yellow */
+    SHOW_GO
+} Show;
+
+#define GB(g)           ((uint16_t)(1u << (g)))
+
+/* Barrier 0: N/S lefts and throughs, S right on the ball.
+ * Barrier 1: W and E, W right on the ball, E left permissive. */
+#define SPEC_BARRIER_0  (GB(G_N_LEFT) | GB(G_N_THRU) | GB(G_S_LEFT) | \
+                         GB(G_S_THRU) | GB(G_S_RIGHT_BALL))
+#define SPEC_BARRIER_1  (GB(G_W_THRU) | GB(G_W_RIGHT_BALL) | \
+                         GB(G_E_THRU_LEFT) | GB(G_E_THRU_RIGHT))
+
+/* Overlap arrows run with their parent and whatever may run with it */
+#define SPEC_S_RIGHT_ARROW  (SPEC_BARRIER_1 | GB(G_S_RIGHT_ARROW))
+#define SPEC_W_RIGHT_ARROW  (GB(G_N_LEFT) | GB(G_S_LEFT) | GB(G_S_THRU) | \
+                             GB(G_S_RIGHT_BALL) | GB(G_W_RIGHT_ARROW))
+
+static const char *const groupName[NUM_GROUPS] = {
+    "N left", "N thru", "S left", "S thru", "S right ball", "S right arrow",
+    "W thru", "W right ball", "W right arrow", "E thru-left", "E thru-right"
+};
+
+static const char *const headName[NUM_HEADS] = {
+    "N left", "N thru", "S left", "S thru", "S right", "W thru", "W right",
+    "E thru-left", "E thru-right"
+};
+
+static const Head groupHead[NUM_GROUPS] = {
+    H_N_LEFT, H_N_THRU, H_S_LEFT, H_S_THRU, H_S_RIGHT, H_S_RIGHT,
+    H_W_THRU, H_W_RIGHT, H_W_RIGHT, H_E_THRU_LEFT, H_E_THRU_RIGHT
+};
+
+static uint16_t compatible[NUM_GROUPS];
+
+static void buildSpec(void) {
+    uint8_t g, h;
+
+    for (g = 0; g < NUM_GROUPS; g++) {
+        if (SPEC_BARRIER_0 & GB(g)) compatible[g] = SPEC_BARRIER_0;
+        if (SPEC_BARRIER_1 & GB(g)) compatible[g] = SPEC_BARRIER_1;
+    }
+    compatible[G_S_RIGHT_ARROW] = SPEC_S_RIGHT_ARROW;
+    compatible[G_W_RIGHT_ARROW] = SPEC_W_RIGHT_ARROW;
+
+    for (g = 0; g < NUM_GROUPS; g++) {          /* symmetric */
+        for (h = 0; h < NUM_GROUPS; h++) {
+            if (compatible[g] & GB(h)) compatible[h] |= GB(g);
+        }
+    }
+}
+
+/* ============================================================================
+ * FRAMES
+ * ========================================================================= */
+
+/* Groups sharing a head with another; which of them a yellow on that head
+ * is clearing follows from what the head showed before it */
+#define DUAL_GROUPS     (GB(G_S_RIGHT_BALL) | GB(G_S_RIGHT_ARROW) | \
+                         GB(G_W_RIGHT_BALL) | GB(G_W_RIGHT_ARROW))
+
+typedef struct {
+    uint16_t released;          /* GB() of released groups */
+    uint16_t clearing;          /* GB() of groups in their yellow */
+    uint8_t  show[NUM_HEADS];
+} Frame;
+
+static Show headShow(bool go, bool yellow, bool red, bool flashing) {
+    if (go) return SHOW_GO;
+    if (yellow) return flashing ? SHOW_FLASH : SHOW_YELLOW;
+    if (red) return SHOW_RED;
+    return SHOW_DARK;
+}
+
+/* A combo head with its through green and neither its red nor its ball lit
+ * is in the flashing yellow arrow window, in either half of the flash */
+static void decodeLeft(LEDState *leds, Frame *f, bool flashing, Group g,
+                       Head h, uint8_t arrow, uint8_t red, uint8_t yellow,
+                       uint8_t ball, uint8_t thruGreen) {
+    bool go = getLED(leds, arrow) || getLED(leds, ball) ||
+              (getLED(leds, thruGreen) && !getLED(leds, red));
+
+    if (go) f->released |= GB(g);
+    f->show[h] = (uint8_t)headShow(go, getLED(leds, yellow),
+                                   getLED(leds, red), flashing);
+}
+
+static void decodeHead(LEDState *leds, Frame *f, bool flashing, Head h,
+                       Group ballGroup, uint8_t ball, Group arrowGroup,
+                       uint8_t arrow, uint8_t yellow, uint8_t red) {
+    bool go = false;
+
+    if (getLED(leds, ball)) {
+        f->released |= GB(ballGroup);
+        go = true;
+    }
+    if (arrow != 0xFF && getLED(leds, arrow)) {
+        f->released |= GB(arrowGroup);
+        go = true;
+    }
+    f->show[h] = (uint8_t)headShow(go, getLED(leds, yellow),
+                                   getLED(leds, red), flashing);
+}
+
+static void decode(LEDState *leds, bool flashing, Frame *f) {
+    memset(f, 0, sizeof *f);
+
+    decodeLeft(leds, f, flashing, G_N_LEFT, H_N_LEFT, N_LEFT_GREEN_ARROW,
+               N_COMBO_RED, N_COMBO_YELLOW, N_COMBO_GREEN, N_THRU_GREEN);
+    decodeLeft(leds, f, flashing, G_S_LEFT, H_S_LEFT, S_LEFT_GREEN_ARROW,
+               S_COMBO_RED, S_COMBO_YELLOW, S_COMBO_GREEN, S_THRU_GREEN);
+
+    decodeHead(leds, f, flashing, H_N_THRU, G_N_THRU, N_THRU_GREEN,
+               G_N_THRU, 0xFF, N_THRU_YELLOW, N_THRU_RED);
+    decodeHead(leds, f, flashing, H_S_THRU, G_S_THRU, S_THRU_GREEN,
+               G_S_THRU, 0xFF, S_THRU_YELLOW, S_THRU_RED);
+    decodeHead(leds, f, flashing, H_S_RIGHT, G_S_RIGHT_BALL,
+               S_RIGHT_GREEN_BALL, G_S_RIGHT_ARROW, S_RIGHT_GREEN_ARROW,
+               S_RIGHT_YELLOW, S_RIGHT_RED);
+    decodeHead(leds, f, flashing, H_W_THRU, G_W_THRU, W_THRU_GREEN,
+               G_W_THRU, 0xFF, W_THRU_YELLOW, W_THRU_RED);
+    decodeHead(leds, f, flashing, H_W_RIGHT, G_W_RIGHT_BALL,
+               W_RIGHT_GREEN_BALL, G_W_RIGHT_ARROW, W_RIGHT_GREEN_ARROW,
+               W_RIGHT_YELLOW, W_RIGHT_RED);
+    decodeHead(leds, f, flashing, H_E_THRU_LEFT, G_E_THRU_LEFT,
+               E_THRU_LEFT_GREEN, G_E_THRU_LEFT, 0xFF,
+               E_THRU_LEFT_YELLOW, E_THRU_LEFT_RED);
+    decodeHead(leds, f, flashing, H_E_THRU_RIGHT, G_E_THRU_RIGHT,
+               E_THRU_RIGHT_GREEN, G_E_THRU_RIGHT, 0xFF,
+               E_THRU_RIGHT_YELLOW, E_THRU_RIGHT_RED);
+}
+
+static char showChar(uint8_t show) {
+    return "-RYFG"[show];
+}
+
+static void printFrame(const Frame *f) {
+    uint8_t h;
+    for (h = 0; h < NUM_HEADS; h++) {
+        printf(" %s:%c", headName[h], showChar(f->show[h]));
+    }
+    printf("\n");
+}
+
+/* ============================================================================
+ * INVARIANTS
+ * Return NULL, or what was violated (with *what set to the group or head).
+ * ========================================================================= */
+
+static const char *checkFrame(const Frame *f, uint8_t *what) {
+    uint8_t g;
+
+    for (g = 0; g < NUM_GROUPS; g++) {
+        if ((f->released & GB(g)) && (f->released & ~compatible[g])) {
+            *what = g;
+            return "conflicting releases";
+        }
+    }
+    return NULL;
+}
+
+static const char *checkTransition(const Frame *a, const Frame *b,
+                                   uint8_t *what) {
+    uint16_t started = (uint16_t)(b->released & ~a->released);
+    const char *err = checkFrame(b, what);
+    uint16_t busy;
+    uint8_t g, h;
+
+    if (err) return err;
+
+    for (h = 0; h < NUM_HEADS; h++) {
+        if (a->show[h] == SHOW_GO && b->show[h] != SHOW_GO &&
+            b->show[h] != SHOW_YELLOW) {
+            *what = h;
+            return "release ended without a steady yellow";
+        }
+        if (a->show[h] == SHOW_YELLOW && b->show[h] == SHOW_GO) {
+            *what = h;
+            return "steady yellow went back to a release";
+        }
+    }
+
+    if (started == 0) return NULL;
+
+    /* Groups not yet cleared in the frame before */
+    busy = (uint16_t)(a->released | a->clearing);
+    for (g = 0; g < NUM_GROUPS; g++) {
+        if (a->show[groupHead[g]] == SHOW_FLASH) busy |= GB(g);
+    }
+    for (g = 0; g < NUM_GROUPS; g++) {
+        if ((started & GB(g)) && (busy & ~compatible[g])) {
+            *what = g;
+            return "released before a conflicting head cleared";
+        }
+    }
+    return NULL;
+}
+
+/* ============================================================================
+ * TABLE CHECKS
+ * ========================================================================= */
+
+static const PhasePlan *const plans[] = { &daytimePlan, &highTrafficPlan };
+static const char *const planName[] = { "daytime", "high traffic" };
+#define NUM_PLANS   2
+
+static bool phaseUsed(Phase p) {
+    return phaseDefs[p].greenOn != 0;
+}
+
+static uint32_t gcd(uint32_t a, uint32_t b) {
+    while (b != 0) {
+        uint32_t t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+static int failures;
+
+static void fail(const char *fmt, ...) {
+    va_list args;
+
+    va_start(args, fmt);
+    printf("FAIL: ");
+    vprintf(fmt, args);
+    printf("\n");
+    va_end(args);
+    failures++;
+}
+
+static void checkGreens(uint16_t greens) {
+    static const uint8_t fyaModes[] = { 0, APPROACH_BIT(APPROACH_NORTH) |
+                                           APPROACH_BIT(APPROACH_SOUTH) };
+    uint8_t overlaps = 0, o, m, what;
+    const char *err;
+    LEDState leds;
+    Frame f;
+    char set[64];
+    uint8_t p;
+
+    for (o = 0; o < NUM_OVERLAPS; o++) {
+        if (greens & overlapDefs[o].parents) overlaps |= OVERLAP_BIT(o);
+    }
+
+    for (m = 0; m < sizeof fyaModes; m++) {
+        renderPhases(&leds, greens, 0, overlaps, 0);
+        fyaApply(&leds, greens, fyaModes[m], true);
+        decode(&leds, false, &f);
+
+        err = checkFrame(&f, &what);
+        if (!err) continue;
+
+        set[0] = '\0';
+        for (p = PHASE_1; p < NUM_PHASES; p++) {
+            if (greens & PHASE_BIT(p)) {
+                size_t n = strlen(set);
+                snprintf(set + n, sizeof set - n, " %u", p);
+            }
+        }
+        fail("phases%s green together: %s", set, groupName[what]);
+    }
+}
+
+static void checkTables(void) {
+    uint32_t set;
+    uint8_t p, q, k, r, b, s, o;
+
+    for (p = PHASE_1; p < NUM_PHASES; p++) {
+        for (q = PHASE_1; q < NUM_PHASES; q++) {
+            bool conflict = (phaseDefs[p].conflicts & PHASE_BIT(q)) != 0;
+            bool mutual   = (phaseDefs[q].conflicts & PHASE_BIT(p)) != 0;
+            bool apart    = p != q &&
+                            (phaseDefs[p].ring == phaseDefs[q].ring ||
+                             phaseDefs[p].barrier != phaseDefs[q].barrier);
+
+            if (conflict != mutual) {
+                fail("phaseDefs conflicts not symmetric (%u, %u)", p, q);
+            }
+            if (conflict != apart) {
+                fail("phaseDefs conflicts disagree with ring/barrier "
+                     "(%u, %u)", p, q);
+            }
+        }
+    }
+
+    /* Every set of mutually compatible phases, with its overlaps */
+    for (set = 1; set < (1u << NUM_PHASES); set++) {
+        uint16_t greens = (uint16_t)(set & ~1u);
+        bool ok = greens != 0;
+
+        for (p = PHASE_1; p < NUM_PHASES && ok; p++) {
+            if (!(greens & PHASE_BIT(p))) continue;
+            if (!phaseUsed((Phase)p) || (phaseDefs[p].conflicts & greens)) {
+                ok = false;
+            }
+        }
+        if (ok) checkGreens(greens);
+    }
+
+    for (o = 0; o < NUM_OVERLAPS; o++) {
+        if (overlapDefs[o].yellow < SC_MIN_YELLOW_MS ||
+            overlapDefs[o].redClear < SC_MIN_RED_CLEAR_MS) {
+            fail("overlap %u clearance too short", o);
+        }
+    }
+
+    if (getStateDuration(STATE_NIGHT_TRANSITION) < SC_MIN_RED_CLEAR_MS ||
+        getStateDuration(STATE_EMERGENCY_ALL_RED) < SC_MIN_RED_CLEAR_MS) {
+        fail("all-red state shorter than the red clearance");
+    }
+
+    for (k = 0; k < NUM_PLANS; k++) {
+        const PhasePlan *plan = plans[k];
+
+        for (r = 0; r < NUM_RINGS; r++) {
+            for (b = 0; b < NUM_BARRIERS; b++) {
+                for (s = 0; s < PHASES_PER_SLOT; s++) {
+                    p = plan->sequence[r][b][s];
+                    if (p == PHASE_NONE) continue;
+                    if (phaseDefs[p].ring != r ||
+                        phaseDefs[p].barrier != b) {
+                        fail("%s plan: phase %u sequenced outside its ring "
+                             "or barrier", planName[k], p);
+                    }
+                    if (plan->yellow[p] < SC_MIN_YELLOW_MS ||
+                        plan->redClear[p] < SC_MIN_RED_CLEAR_MS) {
+                        fail("%s plan: phase %u clearance below minimum",
+                             planName[k], p);
+                    }
+                    if (plan->minGreen[p] > plan->split[p]) {
+                        fail("%s plan: phase %u minimum green above split",
+                             planName[k], p);
+                    }
+                }
+            }
+        }
+    }
+}
+
+/* ============================================================================
+ * MODEL
+ * ========================================================================= */
+
+typedef struct {
+    TrafficState  state;
+    OperatingMode mode;
+    PreemptState  pre;
+    uint8_t       permissive;
+    uint8_t       scheduled;
+    uint16_t      clearing;     /* DUAL_GROUPS part of Frame.clearing */
+    RingEngine    eng;
+} Model;
+
+typedef struct {
+    uint64_t w[2];
+} Key;
+
+typedef enum {
+    RC_RUN = 0,         /* green runs on */
+    RC_END,             /* green timer runs out now */
+    RC_HOLD
+} RingControl;
+
+typedef enum {
+    EV_NONE = 0,
+    EV_MODE_DAYTIME,
+    EV_MODE_HIGH_TRAFFIC,
+    EV_MODE_NIGHT,
+    EV_PREEMPT_N,       /* .. EV_PREEMPT_N + 3 */
+    EV_SCHEDULE_0 = EV_PREEMPT_N + NUM_APPROACHES,  /* .. + 3 */
+    NUM_EVENTS = EV_SCHEDULE_0 + 4
+} ModelEvent;
+
+typedef struct {
+    uint8_t event;
+    uint8_t calls;          /* bit i: i-th callable phase */
+    uint8_t ring[NUM_RINGS];
+    bool    endBarrier;
+    bool    expire;         /* timed state runs out */
+    bool    pedActive;
+    bool    callPresent;
+} Input;
+
+static uint32_t quantum;            /* ms per model step */
+static uint8_t  elapsedCap;         /* quanta; longest minimum green */
+static Phase    callable[NUM_PLANS][NUM_PHASES];
+static uint8_t  numCallable[NUM_PLANS];
+
+static uint8_t planIndex(const PhasePlan *plan) {
+    return plan == &highTrafficPlan ? 1 : 0;
+}
+
+static void setupModel(void) {
+    uint32_t q = 0, longest = 0;
+    uint8_t k, r, b, s, p, o;
+
+    for (k = 0; k < NUM_PLANS; k++) {
+        uint16_t seen = 0;
+
+        for (r = 0; r < NUM_RINGS; r++) {
+            for (b = 0; b < NUM_BARRIERS; b++) {
+                for (s = 0; s < PHASES_PER_SLOT; s++) {
+                    p = plans[k]->sequence[r][b][s];
+                    if (p == PHASE_NONE) continue;
+                    q = gcd(q, plans[k]->yellow[p]);
+                    q = gcd(q, plans[k]->redClear[p]);
+                    q = gcd(q, plans[k]->minGreen[p]);
+                    if (plans[k]->minGreen[p] > longest) {
+                        longest = plans[k]->minGreen[p];
+                    }
+                    if (!(plans[k]->recall & PHASE_BIT(p)) &&
+                        !(seen & PHASE_BIT(p))) {
+                        callable[k][numCallable[k]++] = (Phase)p;
+                    }
+                    seen |= PHASE_BIT(p);
+                }
+            }
+        }
+    }
+    for (o = 0; o < NUM_OVERLAPS; o++) {
+        q = gcd(q, overlapDefs[o].yellow);
+        q = gcd(q, overlapDefs[o].redClear);
+    }
+    quantum    = q ? q : 1000;
+    elapsedCap = (uint8_t)(longest / quantum);
+}
+
+/* --- Packing ------------------------------------------------------------ */
+
+typedef struct {
+    Key     *key;
+    uint8_t  bit;
+} Packer;
+
+static void put(Packer *pk, uint32_t value, uint8_t bits) {
+    uint8_t word = pk->bit / 64, shift = pk->bit % 64;
+    uint64_t v = value & ((1ULL << bits) - 1);
+
+    pk->key->w[word] |= v << shift;
+    if (shift + bits > 64) pk->key->w[word + 1] |= v >> (64 - shift);
+    pk->bit += bits;
+}
+
+static uint32_t get(Packer *pk, uint8_t bits) {
+    uint8_t word = pk->bit / 64, shift = pk->bit % 64;
+    uint64_t v = pk->key->w[word] >> shift;
+
+    if (shift + bits > 64) v |= pk->key->w[word + 1] << (64 - shift);
+    pk->bit += bits;
+    return (uint32_t)(v & ((1ULL << bits) - 1));
+}
+
+static bool putTimer(Packer *pk, uint32_t ms) {
+    uint32_t q = ms / quantum;
+    if (ms % quantum != 0 || q >= (1u << SC_TIMER_BITS)) return false;
+    put(pk, q, SC_TIMER_BITS);
+    return true;
+}
+
+static bool pack(const Model *m, Key *key) {
+    const RingEngine *e = &m->eng;
+    Packer pk = { key, 0 };
+    bool ok = true;
+    uint8_t r, o;
+
+    key->w[0] = key->w[1] = 0;
+    put(&pk, m->state, 6);
+    put(&pk, m->mode, 2);
+    put(&pk, m->pre.phase, 2);
+    put(&pk, m->pre.approach, 2);
+    put(&pk, m->pre.returnMode, 2);
+    put(&pk, m->permissive, 2);
+    put(&pk, m->scheduled, 2);
+    put(&pk, m->clearing >> G_S_RIGHT_BALL, 5);
+    put(&pk, e->demand >> 1, 8);            /* kept across ringStart() */
+
+    if (m->state != STATE_PHASE_ENGINE) return true;
+
+    put(&pk, planIndex(e->plan), 1);
+    put(&pk, e->barrier, 1);
+    for (r = 0; r < NUM_RINGS; r++) {
+        const RingTimer *t = &e->ring[r];
+        uint32_t elapsed = 0;
+
+        /* Only compared with the minimum green, and only while green */
+        if (t->interval == RING_GREEN) {
+            elapsed = t->elapsed;
+            if (elapsed > e->plan->minGreen[t->phase]) {
+                elapsed = e->plan->minGreen[t->phase];
+            }
+        }
+        put(&pk, t->slot, 1);
+        put(&pk, t->phase, 4);
+        put(&pk, t->interval, 2);
+        /* Green timers are an input, set every step */
+        ok &= putTimer(&pk, t->interval == RING_GREEN ? 0 : t->timer);
+        put(&pk, (elapsed + quantum - 1) / quantum, SC_ELAPSED_BITS);
+        ok &= (t->clearHold == 0);
+    }
+    for (o = 0; o < NUM_OVERLAPS; o++) {
+        put(&pk, e->overlap[o].interval, 2);
+        ok &= putTimer(&pk, e->overlap[o].timer);
+    }
+    put(&pk, e->forceOff, 1);
+    put(&pk, e->endBarrier, 1);
+    put(&pk, e->idle, 1);
+    return ok;
+}
+
+static void unpack(const Key *key, Model *m) {
+    Key copy = *key;
+    Packer pk = { &copy, 0 };
+    RingEngine *e = &m->eng;
+    uint8_t r, o;
+
+    memset(m, 0, sizeof *m);
+    m->state          = (TrafficState)get(&pk, 6);
+    m->mode           = (OperatingMode)get(&pk, 2);
+    m->pre.phase      = (PreemptPhase)get(&pk, 2);
+    m->pre.approach   = (Approach)get(&pk, 2);
+    m->pre.returnMode = (OperatingMode)get(&pk, 2);
+    m->permissive     = (uint8_t)get(&pk, 2);
+    m->scheduled      = (uint8_t)get(&pk, 2);
+    m->clearing       = (uint16_t)(get(&pk, 5) << G_S_RIGHT_BALL);
+    e->demand         = (uint16_t)(get(&pk, 8) << 1);
+    e->plan           = &daytimePlan;
+
+    if (m->state != STATE_PHASE_ENGINE) return;
+
+    e->plan    = plans[get(&pk, 1)];
+    e->barrier = (uint8_t)get(&pk, 1);
+    for (r = 0; r < NUM_RINGS; r++) {
+        RingTimer *t = &e->ring[r];
+
+        t->slot     = (uint8_t)get(&pk, 1);
+        t->phase    = (Phase)get(&pk, 4);
+        t->interval = (RingInterval)get(&pk, 2);
+        t->timer    = get(&pk, SC_TIMER_BITS) * quantum;
+        t->elapsed  = get(&pk, SC_ELAPSED_BITS) * quantum;
+    }
+    for (o = 0; o < NUM_OVERLAPS; o++) {
+        e->overlap[o].interval = (RingInterval)get(&pk, 2);
+        e->overlap[o].timer    = get(&pk, SC_TIMER_BITS) * quantum;
+    }
+    e->forceOff   = get(&pk, 1);
+    e->endBarrier = get(&pk, 1);
+    e->idle       = get(&pk, 1);
+}
+
+/* --- Display ------------------------------------------------------------ */
+
+static void render(const Model *m, Frame *f) {
+    LEDState leds;
+    uint8_t g;
+
+    if (m->state == STATE_PHASE_ENGINE) {
+        ringRender(&m->eng, &leds);
+        fyaApply(&leds, ringGreens(&m->eng), m->permissive, true);
+    } else {
+        executeState(&leds, m->state);
+    }
+    decode(&leds, m->state == STATE_NIGHT_FLASH_ON ||
+                  m->state == STATE_NIGHT_FLASH_OFF, f);
+
+    for (g = 0; g < NUM_GROUPS; g++) {
+        if (!(DUAL_GROUPS & GB(g)) && f->show[groupHead[g]] == SHOW_YELLOW) {
+            f->clearing |= GB(g);
+        }
+    }
+    f->clearing |= m->clearing;
+}
+
+/* Renders `n`, just stepped from the display `a`, and works out which
+ * groups on a shared head its yellows clear: those the head released or
+ * was clearing, or all of them after anything else */
+static void renderNext(Model *n, const Frame *a, Frame *b) {
+    uint8_t g;
+
+    n->clearing = 0;
+    render(n, b);
+
+    for (g = 0; g < NUM_GROUPS; g++) {
+        uint8_t h = groupHead[g];
+
+        if (!(DUAL_GROUPS & GB(g)) || b->show[h] != SHOW_YELLOW) continue;
+        if (a->show[h] == SHOW_GO || a->show[h] == SHOW_YELLOW) {
+            n->clearing |= (uint16_t)((a->released | a->clearing) & GB(g));
+        } else {
+            n->clearing |= GB(g);
+        }
+    }
+    b->clearing |= n->clearing;
+}
+
+/* --- Sequencing, as controller.c --------------------------------------- */
+
+static void clearEvents(RingEngine *e) {
+    e->greenStarted = 0;
+    e->greenEnded   = 0;
+    e->cycleStarted = false;
+    e->changed      = false;
+}
+
+static void startPhaseEngine(Model *m, uint8_t barrier) {
+    m->state      = STATE_PHASE_ENGINE;
+    m->permissive = m->scheduled;
+    ringStart(&m->eng, getPlanForMode(m->mode), barrier);
+    clearEvents(&m->eng);
+}
+
+static void enterMode(Model *m) {
+    switch (m->mode) {
+        case MODE_DAYTIME:
+        case MODE_HIGH_TRAFFIC:
+            if (m->state != STATE_NIGHT_FLASH_ON &&
+                m->state != STATE_NIGHT_FLASH_OFF) {
+                startPhaseEngine(m, 0);
+            } else {
+                m->state = STATE_NIGHT_TRANSITION;
+            }
+            break;
+        case MODE_NIGHT:
+            m->state = STATE_NIGHT_FLASH_ON;
+            break;
+        default:
+            break;
+    }
+}
+
+static void servicePhaseEngine(Model *m, const Input *in, uint32_t elapsed) {
+    RingEngine *e = &m->eng;
+    uint8_t k = planIndex(e->plan), i, r;
+
+    for (i = 0; i < numCallable[k]; i++) {
+        if (in->calls & (1u << i)) ringPlaceCall(e, callable[k][i]);
+    }
+    m->permissive = fyaLatch(m->permissive, m->scheduled, ringGreens(e));
+
+    e->hold = 0;
+    for (r = 0; r < NUM_RINGS; r++) {
+        if (e->ring[r].interval != RING_GREEN) continue;
+        switch (in->ring[r]) {
+            case RC_END:
+                ringSetGreenRemaining(e, r, 0);
+                break;
+            case RC_HOLD:
+                e->hold |= PHASE_BIT(e->ring[r].phase);
+                /* fall through */
+            default:
+                ringSetGreenRemaining(e, r, 2 * quantum);
+                break;
+        }
+    }
+    if (in->endBarrier) ringEndBarrier(e);
+
+    ringStep(e, elapsed);
+    clearEvents(e);
+}
+
+static void step(Model *m, const Input *in) {
+    TrafficState entered = m->state, entry, next;
+    OperatingMode requested;
+
+    /* Events first, as serviceEvents() runs before ctlStep() */
+    if (in->event >= EV_MODE_DAYTIME && in->event <= EV_MODE_NIGHT) {
+        requested = in->event == EV_MODE_DAYTIME      ? MODE_DAYTIME :
+                    in->event == EV_MODE_HIGH_TRAFFIC ? MODE_HIGH_TRAFFIC
+                                                      : MODE_NIGHT;
+        if (requested != m->mode) {
+            if (preemptActive(&m->pre)) {
+                m->pre.returnMode = requested;
+            } else {
+                m->mode = requested;
+                if (m->state == STATE_PHASE_ENGINE && !ringIdle(&m->eng)) {
+                    ringForceOff(&m->eng);
+                } else {
+                    enterMode(m);
+                }
+            }
+        }
+    }
+    else if (in->event >= EV_PREEMPT_N && in->event < EV_SCHEDULE_0) {
+        if (preemptCall(&m->pre, (Approach)(in->event - EV_PREEMPT_N),
+                        m->mode, m->state, &entry)) {
+            m->mode = MODE_EMERGENCY;
+            if (entry == STATE_PHASE_ENGINE) {
+                ringForceOff(&m->eng);
+                servicePhaseEngine(m, &(Input){ 0 }, 0);
+            } else {
+                m->state = entry;
+            }
+        }
+    }
+    else if (in->event >= EV_SCHEDULE_0) {
+        m->scheduled = (uint8_t)(in->event - EV_SCHEDULE_0);
+    }
+
+    if (m->pre.phase == PREEMPT_TRACK_GREEN) {
+        m->pre.callAgeMs = in->callPresent ? 0 : PREEMPT_CALL_DROP_MS;
+    }
+
+    /* serviceStates() */
+    if (m->state == STATE_PHASE_ENGINE) {
+        servicePhaseEngine(m, in, quantum);
+        if (!ringIdle(&m->eng)) return;
+
+        if (preemptActive(&m->pre)) {
+            m->state = preemptNextState(&m->pre, m->state);
+        } else {
+            enterMode(m);
+        }
+        return;
+    }
+
+    /* A state entered by an event has just armed its timer */
+    if (!in->expire || m->state != entered) return;
+    if (!preemptActive(&m->pre) && in->pedActive) return;
+
+    if (preemptActive(&m->pre)) {
+        next = preemptNextState(&m->pre, m->state);
+        if (!preemptActive(&m->pre)) {
+            m->mode = m->pre.returnMode;
+            if (next == STATE_PHASE_ENGINE) {
+                startPhaseEngine(m, preemptExitBarrier(&m->pre));
+            } else {
+                m->state = next;
+            }
+        } else {
+            m->state = next;
+        }
+    } else {
+        next = getNextState(m->state, m->mode);
+        if (next == STATE_PHASE_ENGINE) startPhaseEngine(m, 0);
+        else                            m->state = next;
+    }
+}
+
+/* Every input that can matter in this state, in a fixed order (the radix
+ * of each field depends only on the state). Returns 1, 0 for an input that
+ * can only repeat another one, or -1 past the last. */
+static int nextInput(const Model *m, Input *in, uint32_t index) {
+    const RingEngine *e = &m->eng;
+    uint8_t k = planIndex(e->plan), r, i;
+    bool redundant = false, ending;
+    uint32_t n;
+
+    memset(in, 0, sizeof *in);
+
+    n = index % NUM_EVENTS;
+    index /= NUM_EVENTS;
+    in->event = (uint8_t)n;
+
+    if (in->event == EV_MODE_DAYTIME || in->event == EV_MODE_HIGH_TRAFFIC ||
+        in->event == EV_MODE_NIGHT) {
+        OperatingMode mode = in->event == EV_MODE_DAYTIME ? MODE_DAYTIME :
+                             in->event == EV_MODE_NIGHT   ? MODE_NIGHT
+                                                          : MODE_HIGH_TRAFFIC;
+        redundant = mode == m->mode;
+    }
+    if (in->event >= EV_SCHEDULE_0) {
+        redundant = in->event - EV_SCHEDULE_0 == m->scheduled;
+    }
+
+    if (m->pre.phase == PREEMPT_TRACK_GREEN) {
+        in->callPresent = index & 1;
+        index >>= 1;
+    }
+
+    if (m->state == STATE_PHASE_ENGINE) {
+        in->calls = (uint8_t)(index & ((1u << numCallable[k]) - 1));
+        index >>= numCallable[k];
+        for (i = 0; i < numCallable[k]; i++) {
+            if ((in->calls & (1u << i)) &&
+                (e->demand & PHASE_BIT(callable[k][i]))) {
+                redundant = true;
+            }
+        }
+
+        if (!e->endBarrier) {
+            in->endBarrier = index & 1;
+            index >>= 1;
+        }
+
+        /* A force-off ends every green regardless. Otherwise a held green
+         * only differs from one running on when the barrier is ending, and
+         * then one running out differs from neither. */
+        ending = e->endBarrier || in->endBarrier;
+        for (r = 0; r < NUM_RINGS && !e->forceOff; r++) {
+            if (e->ring[r].interval != RING_GREEN) continue;
+            if (index & 1) in->ring[r] = ending ? RC_HOLD : RC_END;
+            index >>= 1;
+        }
+    } else {
+        in->expire    = index & 1;
+        in->pedActive = (index >> 1) & 1;
+        index >>= 2;
+        if (in->pedActive && (!in->expire || preemptActive(&m->pre))) {
+            redundant = true;
+        }
+    }
+    if (index != 0) return -1;
+    return redundant ? 0 : 1;
+}
+
+static void describeInput(const Input *in) {
+    static const char *const ringCtl[] = { "runs", "ends", "held" };
+
+    switch (in->event) {
+        case EV_NONE:               break;
+        case EV_MODE_DAYTIME:       printf(" mode daytime;");      break;
+        case EV_MODE_HIGH_TRAFFIC:  printf(" mode high traffic;"); break;
+        case EV_MODE_NIGHT:         printf(" mode night;");        break;
+        default:
+            if (in->event < EV_SCHEDULE_0) {
+                printf(" preempt from %c;",
+                       "NSEW"[in->event - EV_PREEMPT_N]);
+            } else {
+                printf(" FYA schedule %u;", in->event - EV_SCHEDULE_0);
+            }
+            break;
+    }
+    if (in->calls) printf(" calls %x;", in->calls);
+    printf(" ring greens %s/%s;", ringCtl[in->ring[0]], ringCtl[in->ring[1]]);
+    if (in->endBarrier) printf(" end barrier;");
+    if (in->expire) printf(" expire;");
+    if (in->pedActive) printf(" ped walking;");
+    if (in->callPresent) printf(" call present;");
+}
+
+/* ============================================================================
+ * NEXT-STATE CHECK
+ * Every flash / emergency state in every mode, as serviceStates() asks
+ * getNextState() for its successor.
+ * ========================================================================= */
+
+static void checkNextStates(void) {
+    static const TrafficState timed[] = {
+        STATE_NIGHT_FLASH_ON, STATE_NIGHT_FLASH_OFF, STATE_NIGHT_TRANSITION,
+        STATE_EMERGENCY_ALL_RED, STATE_EMERGENCY_HOLD
+    };
+    uint32_t combos = 0;
+    uint8_t s, mode, demand, what;
+    const char *err;
+
+    for (s = 0; s < sizeof timed / sizeof timed[0]; s++) {
+        for (mode = MODE_DAYTIME; mode <= MODE_EMERGENCY; mode++) {
+            for (demand = 0; demand < 4; demand++) {
+                Model m;
+                Frame a, b;
+
+                memset(&m, 0, sizeof m);
+                m.state = timed[s];
+                m.mode  = (OperatingMode)mode;
+                m.eng.demand = (uint16_t)(((demand & 1) ? PHASE_BIT(PHASE_1)
+                                                        : 0) |
+                                          ((demand & 2) ? PHASE_BIT(PHASE_5)
+                                                        : 0));
+                render(&m, &a);
+                step(&m, &(Input){ .expire = true });
+                renderNext(&m, &a, &b);
+                combos++;
+
+                if (m.state != STATE_PHASE_ENGINE &&
+                    (m.state < STATE_NIGHT_FLASH_ON ||
+                     m.state >= STATE_COUNT)) {
+                    fail("getNextState: undefined successor of %u",
+                         timed[s]);
+                }
+                err = checkTransition(&a, &b, &what);
+                if (err) {
+                    printf("state %u mode %u:\n", timed[s], mode);
+                    printFrame(&a);
+                    printFrame(&b);
+                    fail("getNextState: %s", err);
+                }
+            }
+        }
+    }
+    printf("next state: %u combinations\n", combos);
+}
+
+/* ============================================================================
+ * REACHABILITY
+ * ========================================================================= */
+
+typedef struct {
+    Key      key;
+    uint32_t parent;
+    uint32_t input;
+} Node;
+
+typedef struct {
+    Key      key;
+    uint32_t index;         /* node index + 1, 0 = empty */
+} Slot;
+
+typedef struct {
+    Slot    *slot;
+    uint32_t mask;
+    uint32_t count;
+} KeySet;
+
+typedef struct {
+    Node    *node;
+    uint32_t count;
+    uint32_t cap;
+} NodeList;
+
+static uint64_t mix(uint64_t h) {
+    h ^= h >> 30;
+    h *= 0xBF58476D1CE4E5B9ULL;
+    h ^= h >> 27;
+    h *= 0x94D049BB133111EBULL;
+    return h ^ (h >> 31);
+}
+
+static uint32_t hashKey(const Key *k) {
+    return (uint32_t)mix(k->w[0] ^ mix(k->w[1]));
+}
+
+static bool keyEqual(const Key *a, const Key *b) {
+    return a->w[0] == b->w[0] && a->w[1] == b->w[1];
+}
+
+static bool listPush(NodeList *list, const Node *n) {
+    if (list->count == list->cap) {
+        uint32_t cap = list->cap ? list->cap * 2 : 4096;
+        Node *grown = realloc(list->node, cap * sizeof *grown);
+        if (!grown) return false;
+        list->node = grown;
+        list->cap  = cap;
+    }
+    list->node[list->count++] = *n;
+    return true;
+}
+
+static bool setInit(KeySet *set, uint32_t bits) {
+    set->slot  = calloc(1u << bits, sizeof *set->slot);
+    set->mask  = (1u << bits) - 1;
+    set->count = 0;
+    return set->slot != NULL;
+}
+
+/* Node index stored with `key`, or -1 */
+static int64_t setFind(const KeySet *set, const Key *key) {
+    uint32_t i = hashKey(key) & set->mask;
+
+    while (set->slot[i].index != 0) {
+        if (keyEqual(&set->slot[i].key, key)) return set->slot[i].index - 1;
+        i = (i + 1) & set->mask;
+    }
+    return -1;
+}
+
+static bool setGrow(KeySet *set);
+
+/* The caller has checked `key` is absent */
+static bool setAdd(KeySet *set, const Key *key, uint32_t index) {
+    uint32_t i;
+
+    if ((set->count + 1) * 2 > set->mask + 1 && !setGrow(set)) return false;
+
+    i = hashKey(key) & set->mask;
+    while (set->slot[i].index != 0) i = (i + 1) & set->mask;
+    set->slot[i].key   = *key;
+    set->slot[i].index = index + 1;
+    set->count++;
+    return true;
+}
+
+static bool setGrow(KeySet *set) {
+    KeySet bigger;
+    uint32_t i, bits = 0;
+
+    while ((1u << bits) <= set->mask) bits++;
+    if (!setInit(&bigger, bits + 1)) return false;
+    for (i = 0; i <= set->mask; i++) {
+        if (set->slot[i].index != 0) {
+            setAdd(&bigger, &set->slot[i].key, set->slot[i].index - 1);
+        }
+    }
+    free(set->slot);
+    *set = bigger;
+    return true;
+}
+
+typedef struct {
+    const NodeList *nodes;      /* visited, read-only while expanding */
+    const KeySet   *visited;
+    uint32_t        first, last;    /* the level */
+    uint32_t        thread, threads;
+    NodeList        out;        /* new successors, deduplicated */
+    KeySet          seen;
+    uint64_t        edges;
+    bool            failed;
+    uint32_t        failNode;
+    uint32_t        failInput;
+    const char     *failWhy;
+    uint8_t         failWhat;
+} Expander;
+
+static volatile bool stopAll;
+
+static void *expandLevel(void *arg) {
+    Expander *x = arg;
+    uint32_t i, index;
+    int valid;
+
+    for (i = x->first + x->thread; i < x->last && !stopAll;
+         i += x->threads) {
+        Model m, n;
+        Frame a, b;
+        Input in;
+
+        unpack(&x->nodes->node[i].key, &m);
+        render(&m, &a);
+
+        for (index = 0; (valid = nextInput(&m, &in, index)) >= 0;
+             index++) {
+            Node succ;
+
+            if (valid == 0) continue;
+
+            n = m;
+            step(&n, &in);
+            renderNext(&n, &a, &b);
+            x->edges++;
+
+            if (!pack(&n, &succ.key)) {
+                x->failWhy = "state outside the packed ranges";
+            } else {
+                x->failWhy = checkTransition(&a, &b, &x->failWhat);
+            }
+            if (x->failWhy) {
+                x->failed    = true;
+                x->failNode  = i;
+                x->failInput = index;
+                stopAll      = true;
+                return NULL;
+            }
+
+            if (setFind(x->visited, &succ.key) >= 0) continue;
+            if (setFind(&x->seen, &succ.key) >= 0) continue;
+            succ.parent = i;
+            succ.input  = index;
+            if (!listPush(&x->out, &succ) ||
+                !setAdd(&x->seen, &succ.key, x->out.count - 1)) {
+                x->failWhy  = "out of memory";
+                x->failNode = UINT32_MAX;
+                x->failed   = true;
+                stopAll    = true;
+                return NULL;
+            }
+        }
+    }
+    return NULL;
+}
+
+static void printTrace(const NodeList *nodes, uint32_t index,
+                       uint32_t lastInput) {
+    uint32_t path[4096];
+    uint32_t depth = 0, i;
+
+    while (depth < 4096) {
+        path[depth++] = index;
+        if (nodes->node[index].parent == index) break;
+        index = nodes->node[index].parent;
+    }
+
+    printf("trace from power-up:\n");
+    for (i = depth; i-- > 0;) {
+        const Node *node = &nodes->node[path[i]];
+        uint32_t input = (i + 1 < depth) ? node->input : UINT32_MAX;
+        Model m;
+        Frame f;
+        Input in;
+
+        unpack(&node->key, &m);
+        if (input != UINT32_MAX) {
+            Model prev;
+            unpack(&nodes->node[path[i + 1]].key, &prev);
+            nextInput(&prev, &in, input);
+            printf("  ->");
+            describeInput(&in);
+            printf("\n");
+        }
+        render(&m, &f);
+        printf("  state %2u mode %u:", m.state, m.mode);
+        printFrame(&f);
+    }
+    {
+        Model m, n;
+        Frame a, f;
+        Input in;
+
+        unpack(&nodes->node[path[0]].key, &m);
+        render(&m, &a);
+        nextInput(&m, &in, lastInput);
+        n = m;
+        step(&n, &in);
+        printf("  ->");
+        describeInput(&in);
+        printf("\n");
+        renderNext(&n, &a, &f);
+        printf("  state %2u mode %u:", n.state, n.mode);
+        printFrame(&f);
+    }
+}
+
+static bool explore(uint32_t threads) {
+    NodeList nodes = { 0 };
+    KeySet visited;
+    Expander *x = calloc(threads, sizeof *x);
+    pthread_t *tid = calloc(threads, sizeof *tid);
+    uint64_t edges = 0;
+    uint32_t first = 0, depth = 0, t, i, sched;
+    bool ok = true;
+
+    if (!x || !tid || !setInit(&visited, 16)) return false;
+
+    /* Power-up: ctlInit() shows all red, ctlStart() starts the engine */
+    for (sched = 0; sched < 4; sched++) {
+        Model m;
+        Node root;
+        Frame a, b;
+        uint8_t what;
+        const char *err;
+
+        memset(&m, 0, sizeof m);
+        m.mode      = MODE_DAYTIME;
+        m.scheduled = (uint8_t)sched;
+        preemptInit(&m.pre);
+        startPhaseEngine(&m, 0);
+
+        memset(&a, 0, sizeof a);
+        {
+            LEDState leds;
+            setAllRed(&leds);
+            decode(&leds, false, &a);
+        }
+        render(&m, &b);
+        err = checkTransition(&a, &b, &what);
+        if (err) {
+            fail("power-up: %s", err);
+            return false;
+        }
+
+        if (!pack(&m, &root.key)) return false;
+        if (setFind(&visited, &root.key) >= 0) continue;
+        root.parent = nodes.count;
+        root.input  = 0;
+        listPush(&nodes, &root);
+        setAdd(&visited, &root.key, nodes.count - 1);
+    }
+
+    while (first < nodes.count && ok) {
+        uint32_t last = nodes.count;
+
+        for (t = 0; t < threads; t++) {
+            memset(&x[t], 0, sizeof x[t]);
+            x[t].nodes   = &nodes;
+            x[t].visited = &visited;
+            x[t].first   = first;
+            x[t].last    = last;
+            x[t].thread  = t;
+            x[t].threads = threads;
+            if (!setInit(&x[t].seen, 12)) return false;
+            pthread_create(&tid[t], NULL, expandLevel, &x[t]);
+        }
+        for (t = 0; t < threads; t++) pthread_join(tid[t], NULL);
+
+        for (t = 0; t < threads && ok; t++) {
+            edges += x[t].edges;
+            if (!x[t].failed) continue;
+
+            ok = false;
+            if (x[t].failNode < nodes.count) {
+                printTrace(&nodes, x[t].failNode, x[t].failInput);
+            }
+            fail("reachable: %s", x[t].failWhy);
+            if (strstr(x[t].failWhy, "yellow") != NULL) {
+                printf("      head %s\n", headName[x[t].failWhat]);
+            } else if (strstr(x[t].failWhy, "release") != NULL) {
+                printf("      movement %s\n", groupName[x[t].failWhat]);
+            }
+        }
+
+        /* Merge: the same successor may come from several threads */
+        for (t = 0; t < threads && ok; t++) {
+            for (i = 0; i < x[t].out.count; i++) {
+                if (setFind(&visited, &x[t].out.node[i].key) >= 0) {
+                    continue;
+                }
+                if (!listPush(&nodes, &x[t].out.node[i]) ||
+                    !setAdd(&visited, &x[t].out.node[i].key,
+                            nodes.count - 1)) {
+                    fail("reachable: out of memory");
+                    ok = false;
+                    break;
+                }
+            }
+        }
+        for (t = 0; t < threads; t++) {
+            free(x[t].out.node);
+            free(x[t].seen.slot);
+        }
+
+        first = last;
+        if (first < nodes.count) depth++;
+    }
+
+    printf("reachable: %u states, %llu transitions, depth %u, "
+           "%u ms quantum\n",
+           nodes.count, (unsigned long long)edges, depth, quantum);
+
+    free(nodes.node);
+    free(visited.slot);
+    free(tid);
+    free(x);
+    return ok;
+}
+
+static double seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+int main(int argc, char **argv) {
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    uint32_t threads = argc > 1 ? (uint32_t)atoi(argv[1])
+                                : (cores > 0 ? (uint32_t)cores : 1);
+    double start = seconds();
+
+    if (threads == 0) {
+        fprintf(stderr, "usage: %s [threads]\n", argv[0]);
+        return 2;
+    }
+
+    buildSpec();
+    setupModel();
+    if (elapsedCap >= (1u << SC_ELAPSED_BITS)) {
+        fprintf(stderr, "minimum greens too long for the packed state\n");
+        return 2;
+    }
+
+    checkTables();
+    printf("tables: %s\n", failures ? "FAILED" : "ok");
+    checkNextStates();
+    if (failures == 0) explore(threads);
+
+    printf("%s in %.2f s on %u threads\n",
+           failures ? "FAILED" : "all invariants hold",
+           seconds() - start, threads);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,207 @@
+#include "ir_commands.h"
+
+/* Sort order of an entry against a key: <0, 0 or >0 */
+static int16_t compareKey(const IrMapEntry *e, uint8_t protocol, uint8_t bits,
+                          uint32_t code) {
+    if (e->protocol != protocol) return e->protocol < protocol ? -1 : 1;
+    if (e->bits != bits)         return e->bits < bits ? -1 : 1;
+    if (e->code != code)         return e->code < code ? -1 : 1;
+    return 0;
+}
+
+static uint8_t keyBits(const IrFrame *frame) {
+    return frame->protocol == IR_SIRC ? frame->bits : 0;
+}
+
+/* Bisection. Returns true if the key is in the map, with *pos its index;
+ * otherwise *pos is where it would be inserted. */
+static bool find(const IrCommandMap *map, const IrFrame *frame,
+                 uint8_t *pos) {
+    uint8_t lo = 0, hi = map->count, bits = keyBits(frame);
+
+    while (lo < hi) {
+        uint8_t mid = (uint8_t)((lo + hi) / 2);
+        int16_t cmp = compareKey(&map->entry[mid], frame->protocol, bits,
+                                 frame->code);
+
+        if (cmp == 0) {
+            *pos = mid;
+            return true;
+        }
+        if (cmp < 0) lo = (uint8_t)(mid + 1);
+        else         hi = mid;
+    }
+    *pos = lo;
+    return false;
+}
+
+static void setEntry(IrMapEntry *e, const IrFrame *frame, IrAction action) {
+    e->code     = frame->code;
+    e->protocol = frame->protocol;
+    e->bits     = keyBits(frame);
+    e->action   = (uint8_t)action;
+}
+
+static bool valid(const IrCommandMap *map) {
+    uint8_t i;
+
+    if (map->magic != IR_MAP_MAGIC || map->count > IR_MAP_SIZE) return false;
+
+    for (i = 0; i < map->count; i++) {
+        const IrMapEntry *e = &map->entry[i];
+
+        if (e->protocol >= NUM_IR_PROTOCOLS || e->action >= NUM_IR_ACTIONS) {
+            return false;
+        }
+        /* Equal neighbours are a learn cut short by a reset - harmless */
+        if (i > 0 && compareKey(&map->entry[i - 1], e->protocol, e->bits,
+                                e->code) > 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* Keeps a map that survived a reset; seeds a fresh or damaged one with the
+ * defaults, which need not be sorted */
+void irMapInit(IrCommandMap *map, const IrMapEntry *defaults,
+               uint8_t numDefaults) {
+    IrFrame frame;
+    uint8_t i;
+
+    if (valid(map)) return;
+
+    map->magic = 0;                 /* until seeding completes */
+    map->count = 0;
+    for (i = 0; i < numDefaults; i++) {
+        frame.protocol = defaults[i].protocol;
+        frame.bits     = defaults[i].bits;
+        frame.toggle   = 0;
+        frame.code     = defaults[i].code;
+        irMapLearn(map, &frame, (IrAction)defaults[i].action);
+    }
+    map->magic = IR_MAP_MAGIC;
+}
+
+IrAction irMapLookup(const IrCommandMap *map, const IrFrame *frame) {
+    uint8_t pos;
+
+    if (!find(map, frame, &pos)) return IR_ACT_NONE;
+    return (IrAction)map->entry[pos].action;
+}
+
+/* Maps the frame's key to `action`, adding it if needed; IR_ACT_NONE
+ * removes it. Returns false if the map is full. Entries are copied one at
+ * a time in an order that keeps the first `count` sorted throughout. */
+bool irMapLearn(IrCommandMap *map, const IrFrame *frame, IrAction action) {
+    uint8_t pos, i;
+
+    if (find(map, frame, &pos)) {
+        if (action != IR_ACT_NONE) {
+            map->entry[pos].action = (uint8_t)action;
+            return true;
+        }
+        for (i = pos; i + 1 < map->count; i++) {
+            map->entry[i] = map->entry[i + 1];
+        }
+        map->count--;
+        return true;
+    }
+
+    if (action == IR_ACT_NONE) return true;
+    if (map->count >= IR_MAP_SIZE) return false;
+
+    if (pos == map->count) {
+        setEntry(&map->entry[pos], frame, action);
+        map->count++;
+        return true;
+    }
+
+    /* Grow by duplicating the last entry, then open the gap */
+    map->entry[map->count] = map->entry[map->count - 1];
+    map->count++;
+    for (i = (uint8_t)(map->count - 2); i > pos; i--) {
+        map->entry[i] = map->entry[i - 1];
+    }
+    setEntry(&map->entry[pos], frame, action);
+    return true;
+}
+
+/* Every frame the main loop does not handle itself goes through here.
+ * Returns the action to dispatch - IR_ACT_NONE while learning. */
+IrAction irMapHandle(IrCommandMap *map, IrLearn *learn, const IrFrame *frame,
+                     uint32_t nowMs) {
+    IrAction action;
+
+    if (learn->step != IR_LEARN_IDLE &&
+        nowMs - learn->startMs >= IR_LEARN_TIMEOUT_MS) {
+        learn->step = IR_LEARN_IDLE;
+    }
+
+    switch (learn->step) {
+        case IR_LEARN_WAIT_ACTION:
+            action = irMapLookup(map, frame);
+            if (action == IR_ACT_NONE) {
+                learn->step = IR_LEARN_IDLE;
+                return IR_ACT_NONE;
+            }
+            learn->action  = (uint8_t)(action == IR_ACT_LEARN ? IR_ACT_NONE
+                                                              : action);
+            learn->step    = IR_LEARN_WAIT_CODE;
+            learn->startMs = nowMs;
+            return IR_ACT_NONE;
+
+        case IR_LEARN_WAIT_CODE:
+            /* The learn key itself stays, or learning could lock itself out */
+            if (irMapLookup(map, frame) != IR_ACT_LEARN) {
+                irMapLearn(map, frame, (IrAction)learn->action);
+            }
+            learn->step = IR_LEARN_IDLE;
+            return IR_ACT_NONE;
+
+        default:
+            action = irMapLookup(map, frame);
+            if (action == IR_ACT_LEARN) {
+                learn->step    = IR_LEARN_WAIT_ACTION;
+                learn->startMs = nowMs;
+                return IR_ACT_NONE;
+            }
+            return action;
+    }
+}
+
+/* True if `frame` repeats the last one on this receiver: a key still held.
+ * Any other frame becomes the last, with no action yet; a stray NEC repeat
+ * changes nothing. */
+bool irKeyHeld(IrHeldKey *key, const IrFrame *frame, uint32_t nowMs) {
+    bool same = key->valid && key->last.protocol == frame->protocol &&
+                key->last.bits == frame->bits &&
+                key->last.code == frame->code;
+    bool recent = key->valid && nowMs - key->lastMs <= IR_REPEAT_WINDOW_MS;
+    bool held;
+
+    if (frame->protocol == IR_NEC_REPEAT) {
+        if (!recent || key->last.protocol != IR_NEC) return false;
+        key->lastMs = nowMs;
+        return true;
+    }
+
+    switch (frame->protocol) {
+        case IR_RC5:
+        case IR_RC6:
+            held = same && key->last.toggle == frame->toggle;
+            break;
+        case IR_SIRC:
+            held = same && recent;
+            break;
+        default:
+            held = false;
+            break;
+    }
+
+    if (!held) key->action = IR_ACT_NONE;
+    key->last   = *frame;
+    key->lastMs = nowMs;
+    key->valid  = true;
+    return held;
+}
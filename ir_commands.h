@@ -0,0 +1,115 @@
+#ifndef IR_COMMANDS_H
+#define IR_COMMANDS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "ir_decode.h"
+
+/* ============================================================================
+ * LEARNABLE IR COMMAND MAP
+ *
+ * Maps a decoded frame - protocol, bit count and code - to an action ID.
+ * The map is an array kept sorted by that key and searched by bisection,
+ * so a lookup is at most log2(IR_MAP_SIZE) + 1 compares however many
+ * remotes it holds. main.c keeps it in FRAM, so learned codes survive a
+ * reset, and dispatches each action through a function table.
+ *
+ * Learning a new remote, with a remote the map already knows:
+ *
+ *   1  press the IR_ACT_LEARN key
+ *   2  press the key whose action the new one should copy
+ *   3  press the new key - it is added to the map, or re-mapped if it was
+ *      already there
+ *
+ * A key mapped to IR_ACT_LEARN in step 2 instead removes the new key from
+ * step 3. The IR_ACT_LEARN key itself cannot be re-mapped, so learning
+ * cannot lock itself out. Nothing is dispatched while learning; an unknown
+ * key in step 2, or no key within IR_LEARN_TIMEOUT_MS, cancels. RC5 / RC6
+ * toggle bits are not part of the key, so a held key and a fresh press of
+ * it match.
+ *
+ * Remotes repeat a frame for as long as a key is held, so each receiver
+ * keeps the last frame it saw (IrHeldKey) and irKeyHeld() drops repeats
+ * before they reach the map - otherwise a held key would toggle
+ * coordination once per frame and complete learn steps on its own:
+ *
+ *   RC5, RC6   the frame every ~110 ms; a new press flips the toggle bit.
+ *              Same code and toggle bit as the last frame: held
+ *   SIRC       the frame every 45 ms, at least three per press. Same code
+ *              within IR_REPEAT_WINDOW_MS of the last frame: held
+ *   NEC        one frame per press, then a repeat frame every 108 ms.
+ *              A repeat within IR_REPEAT_WINDOW_MS of the last NEC frame
+ *              or repeat: held; any other repeat is a stray
+ *
+ * The window is measured from the last frame, so it runs for as long as
+ * the key is held. The caller records in `action` what the press
+ * dispatched, so a held key can keep refreshing it - main.c re-issues a
+ * preemption call, which lapses once frames stop arriving.
+ *
+ * FRAM writes are not atomic. Entries are moved one at a time in an order
+ * that keeps the map sorted, so a reset part way through learning leaves at
+ * worst a duplicate entry. irMapInit() re-seeds the defaults if it finds
+ * the map unsorted or out of range (an entry torn by the reset), or with a
+ * magic other than IR_MAP_MAGIC. The magic changes whenever the defaults
+ * do, and learned keys are then lost.
+ * ========================================================================= */
+
+#define IR_MAP_SIZE             48
+#define IR_MAP_MAGIC            0x1A3D  /* changed when the defaults are */
+#define IR_LEARN_TIMEOUT_MS     10000UL
+#define IR_REPEAT_WINDOW_MS     150UL
+
+typedef enum {
+    IR_ACT_NONE = 0,
+    IR_ACT_MODE_DAYTIME,
+    IR_ACT_MODE_NIGHT,
+    IR_ACT_MODE_HIGH_TRAFFIC,
+    IR_ACT_PREEMPT,             /* on the receiver's approach */
+    IR_ACT_COORD_TOGGLE,
+    IR_ACT_LEARN,
+    IR_ACT_CLOCK_HOUR,          /* step the RTC's hour */
+    IR_ACT_CLOCK_MINUTE,        /* step its minute, seconds to zero */
+    NUM_IR_ACTIONS
+} IrAction;
+
+typedef struct {
+    uint32_t code;
+    uint8_t  protocol;          /* IrProtocol */
+    uint8_t  bits;              /* SIRC only, else 0 */
+    uint8_t  action;            /* IrAction */
+} IrMapEntry;
+
+typedef struct {
+    uint16_t   magic;           /* IR_MAP_MAGIC once seeded */
+    uint8_t    count;
+    IrMapEntry entry[IR_MAP_SIZE];  /* ascending (protocol, bits, code) */
+} IrCommandMap;
+
+typedef enum {
+    IR_LEARN_IDLE = 0,
+    IR_LEARN_WAIT_ACTION,
+    IR_LEARN_WAIT_CODE
+} IrLearnStep;
+
+typedef struct {
+    IrLearnStep step;
+    uint8_t     action;         /* chosen in IR_LEARN_WAIT_ACTION */
+    uint32_t    startMs;
+} IrLearn;
+
+typedef struct {
+    IrFrame  last;              /* never an NEC repeat */
+    uint32_t lastMs;            /* of the last frame or repeat */
+    uint8_t  action;            /* IrAction `last` dispatched, by the caller */
+    bool     valid;             /* false until the first frame */
+} IrHeldKey;
+
+void     irMapInit(IrCommandMap *map, const IrMapEntry *defaults,
+                   uint8_t numDefaults);
+IrAction irMapLookup(const IrCommandMap *map, const IrFrame *frame);
+bool     irMapLearn(IrCommandMap *map, const IrFrame *frame, IrAction action);
+IrAction irMapHandle(IrCommandMap *map, IrLearn *learn, const IrFrame *frame,
+                     uint32_t nowMs);
+bool     irKeyHeld(IrHeldKey *key, const IrFrame *frame, uint32_t nowMs);
+
+#endif /* IR_COMMANDS_H */
@@ -0,0 +1,412 @@
+#include "ir_decode.h"
+
+#define IR_ALL_DECODERS     ((uint8_t)((1u << IR_NUM_DECODERS) - 1))
+
+static bool within(uint16_t us, uint16_t min, uint16_t max) {
+    return us >= min && us <= max;
+}
+
+/* ============================================================================
+ * NEC
+ * Steps: 0 leader mark, 1 leader space, then mark / space per bit from 2,
+ * stop mark at 66. A repeat is leader mark, short space, stop mark.
+ * ========================================================================= */
+
+#define NEC_STOP_STEP       66
+
+static IrStatus necEdge(IrDecodeState *s, bool mark, uint16_t us,
+                        IrFrame *out) {
+    uint8_t step = s->step++;
+    uint8_t cmd, cmdInv;
+
+    if (step == 0) {
+        return within(us, IR_NEC_LEADER_MIN_US, IR_NEC_LEADER_MAX_US)
+               ? IR_MORE : IR_REJECT;
+    }
+    if (step == 1) {
+        if (within(us, IR_NEC_SPACE_MIN_US, IR_NEC_SPACE_MAX_US)) {
+            return IR_MORE;
+        }
+        s->level = 1;                       /* repeat */
+        return within(us, IR_NEC_REPEAT_MIN_US, IR_NEC_REPEAT_MAX_US)
+               ? IR_MORE : IR_REJECT;
+    }
+
+    if (mark) {
+        if (!within(us, IR_NEC_MARK_MIN_US, IR_NEC_MARK_MAX_US)) {
+            return IR_REJECT;
+        }
+        if (s->level) {
+            out->protocol = IR_NEC_REPEAT;
+            out->code     = 0;
+            return IR_DONE;
+        }
+        if (step < NEC_STOP_STEP) return IR_MORE;
+
+        cmd    = (uint8_t)(s->value >> 16);
+        cmdInv = (uint8_t)(s->value >> 24);
+        if ((uint8_t)(cmd ^ cmdInv) != 0xFF) return IR_REJECT;
+
+        out->protocol = IR_NEC;
+        out->code     = s->value;
+        return IR_DONE;
+    }
+
+    if (within(us, IR_NEC_SPACE_1_MIN_US, IR_NEC_SPACE_1_MAX_US)) {
+        s->value |= 1UL << s->bits;
+    } else if (!within(us, IR_NEC_MARK_MIN_US, IR_NEC_SPACE_0_MAX_US)) {
+        return IR_REJECT;
+    }
+    s->bits++;
+    return IR_MORE;
+}
+
+/* ============================================================================
+ * MANCHESTER (RC5, RC6)
+ * Each duration is a run of 1 to maxUnits half-bit units at one level. The
+ * halves of a bit must differ; a bit is complete at its second half, or -
+ * for the last bit - as soon as its first half is a mark, since the second
+ * half can then only be the idle space after the frame.
+ * ========================================================================= */
+
+typedef struct {
+    uint16_t unitUs;
+    uint8_t  maxUnits;
+    uint8_t  bits;
+    uint8_t  wideBit;       /* bit with double-width halves, or 0xFF */
+    bool     oneMarkFirst;  /* RC6: 1 = mark, space. RC5: space, mark */
+} Manchester;
+
+static const Manchester rc5 = { IR_RC5_UNIT_US, 2, 14, 0xFF, false };
+static const Manchester rc6 = { IR_RC6_UNIT_US, 3, 21, 4,    true  };
+
+static uint8_t unitsOf(uint16_t us, uint16_t unitUs) {
+    uint16_t units = (uint16_t)((us + unitUs / 2) / unitUs);
+    uint16_t ideal = (uint16_t)(units * unitUs);
+    uint16_t slack = (uint16_t)((uint32_t)unitUs * IR_UNIT_TOLERANCE_PCT
+                                / 100);
+
+    if (units == 0 || units > 8) return 0;
+    if (us + slack < ideal || us > ideal + slack) return 0;
+    return (uint8_t)units;
+}
+
+static IrStatus manchesterRun(IrDecodeState *s, const Manchester *m,
+                              bool mark, uint16_t us) {
+    uint8_t units = unitsOf(us, m->unitUs);
+    uint8_t width, bit;
+
+    if (units == 0 || units > m->maxUnits) return IR_REJECT;
+
+    while (units--) {
+        width = s->bits == m->wideBit ? 2 : 1;
+
+        if (s->half < width) {              /* first half */
+            if (s->half == 0) s->level = mark;
+            else if (s->level != mark) return IR_REJECT;
+            s->half++;
+
+            if (s->half == width && s->bits == m->bits - 1 &&
+                units == 0 && mark) {
+                s->value = s->value << 1 | (m->oneMarkFirst ? 1 : 0);
+                s->bits++;
+                return IR_DONE;
+            }
+            continue;
+        }
+
+        if (s->level == mark) return IR_REJECT;     /* second half */
+        if (++s->half < 2 * width) continue;
+
+        bit = (uint8_t)(s->level == m->oneMarkFirst);
+        s->value = s->value << 1 | bit;
+        s->half  = 0;
+        if (++s->bits == m->bits) return units == 0 ? IR_DONE : IR_REJECT;
+    }
+    return IR_MORE;
+}
+
+/* S1 S2 T A4..A0 C5..C0. The first half of S1 is the idle space, so the
+ * frame starts half way into it; S2 inverted is command bit 6 (RC5X). */
+static IrStatus rc5Edge(IrDecodeState *s, bool mark, uint16_t us,
+                        IrFrame *out) {
+    IrStatus status;
+    uint32_t v;
+
+    if (s->step++ == 0) {
+        s->half  = 1;
+        s->level = 0;
+    }
+    status = manchesterRun(s, &rc5, mark, us);
+    if (status != IR_DONE) return status;
+
+    v = s->value;
+    if (!(v & (1UL << 13))) return IR_REJECT;
+    out->protocol = IR_RC5;
+    out->toggle   = (uint8_t)((v >> 11) & 1);
+    out->code     = ((v >> 6) & 0x1F) << 8 | (v & 0x3F) |
+                    ((v & (1UL << 12)) ? 0 : 0x40);
+    return IR_DONE;
+}
+
+/* Leader mark and space, then start (1), mode 2..0 (0), trailer T
+ * (double width), A7..A0, C7..C0 */
+static IrStatus rc6Edge(IrDecodeState *s, bool mark, uint16_t us,
+                        IrFrame *out) {
+    uint8_t step = s->step++;
+    IrStatus status;
+    uint32_t v;
+
+    if (step == 0) {
+        return unitsOf(us, IR_RC6_UNIT_US) == 6 ? IR_MORE : IR_REJECT;
+    }
+    if (step == 1) {
+        return unitsOf(us, IR_RC6_UNIT_US) == 2 ? IR_MORE : IR_REJECT;
+    }
+
+    status = manchesterRun(s, &rc6, mark, us);
+    if (status != IR_DONE) return status;
+
+    v = s->value;
+    if ((v >> 17) != 0x8) return IR_REJECT;     /* start 1, mode 0 */
+    out->protocol = IR_RC6;
+    out->toggle   = (uint8_t)((v >> 16) & 1);
+    out->code     = v & 0xFFFF;
+    return IR_DONE;
+}
+
+/* ============================================================================
+ * SONY SIRC
+ * Steps: 0 leader mark, 1 space, then mark (bit) / space from 2.
+ * ========================================================================= */
+
+#define SIRC_MAX_BITS       20
+
+static IrStatus sircFinish(IrDecodeState *s, IrFrame *out) {
+    out->protocol = IR_SIRC;
+    out->bits     = s->bits;
+    out->code     = s->value;
+    return IR_DONE;
+}
+
+static IrStatus sircEdge(IrDecodeState *s, bool mark, uint16_t us,
+                         IrFrame *out) {
+    uint8_t step = s->step++;
+
+    if (step == 0) {
+        return within(us, IR_SIRC_LEADER_MIN_US, IR_SIRC_LEADER_MAX_US)
+               ? IR_MORE : IR_REJECT;
+    }
+    if (!mark) {
+        return within(us, IR_SIRC_SHORT_MIN_US, IR_SIRC_SHORT_MAX_US)
+               ? IR_MORE : IR_REJECT;
+    }
+
+    if (within(us, IR_SIRC_LONG_MIN_US, IR_SIRC_LONG_MAX_US)) {
+        s->value |= 1UL << s->bits;
+    } else if (!within(us, IR_SIRC_SHORT_MIN_US, IR_SIRC_SHORT_MAX_US)) {
+        return IR_REJECT;
+    }
+    if (++s->bits == SIRC_MAX_BITS) return sircFinish(s, out);
+    return IR_MORE;
+}
+
+/* Only right after a bit's mark (odd step count), with a valid length */
+static IrStatus sircGap(IrDecodeState *s, IrFrame *out) {
+    if (!(s->step & 1) || (s->bits != 12 && s->bits != 15)) return IR_REJECT;
+    return sircFinish(s, out);
+}
+
+/* ============================================================================
+ * CHANNEL
+ * ========================================================================= */
+
+const IrDecoder irDecoders[IR_NUM_DECODERS] = {
+    { necEdge,  0       },
+    { rc5Edge,  0       },
+    { rc6Edge,  0       },
+    { sircEdge, sircGap }
+};
+
+static void rearm(IrChannel *ch) {
+    uint8_t d;
+
+    for (d = 0; d < IR_NUM_DECODERS; d++) {
+        ch->dec[d].step  = 0;
+        ch->dec[d].bits  = 0;
+        ch->dec[d].half  = 0;
+        ch->dec[d].level = 0;
+        ch->dec[d].value = 0;
+    }
+    ch->active   = IR_ALL_DECODERS;
+    ch->edges    = 0;
+    ch->nextMark = true;
+}
+
+/* Ends the frame in progress unpublished; counted if it got past a leader */
+static void abandon(IrChannel *ch) {
+    if (ch->active && ch->edges >= 2) ch->stats.aborted++;
+    ch->active = 0;
+}
+
+/* Dropped if the main loop has not taken the last one */
+static bool publish(IrChannel *ch, const IrFrame *frame) {
+    if (ch->frameReady) {
+        ch->stats.dropped++;
+        return false;
+    }
+
+    ch->frame.protocol = frame->protocol;
+    ch->frame.bits     = frame->bits;
+    ch->frame.toggle   = frame->toggle;
+    ch->frame.code     = frame->code;
+    ch->frameReady     = 1;
+    ch->stats.frames++;
+    return true;
+}
+
+/* Called before the capture interrupts are enabled */
+void irInit(IrChannel *ch) {
+    rearm(ch);
+    ch->active          = 0;                /* until the first gap */
+    ch->lastCapture     = 0;
+    ch->ring.head       = 0;
+    ch->ring.tail       = 0;
+    ch->ring.lost       = 0;
+    ch->frameReady      = 0;
+    ch->stats.frames    = 0;
+    ch->stats.dropped   = 0;
+    ch->stats.aborted   = 0;
+    ch->stats.overflows = 0;
+}
+
+/* Interrupt context - the whole of the capture ISR's work on a channel.
+ * `overflow` is COV: an edge was lost before this one. */
+void irQueue(IrChannel *ch, uint32_t capture, bool overflow) {
+    IrEdgeRing *r = &ch->ring;
+    uint8_t next = (uint8_t)((r->head + 1) & IR_EDGE_MASK);
+
+    if (r->lost) return;
+    if (overflow || next == r->tail) {
+        r->lost = 1;
+        return;
+    }
+    r->stamp[r->head] = capture;
+    r->head = next;
+}
+
+/* Main loop. Decodes the queued edges through irCapture(), then counts a
+ * loss the ISR reported after them. Stops after an edge that publishes a
+ * frame and returns true, so the caller can take it before polling on.
+ * `lost` is read before `head`: every edge queued before the loss is
+ * decoded first. */
+bool irPoll(IrChannel *ch) {
+    IrEdgeRing *r = &ch->ring;
+    uint8_t lost = r->lost;
+    uint8_t head = r->head;
+
+    while (r->tail != head) {
+        uint32_t capture = r->stamp[r->tail];
+
+        r->tail = (uint8_t)((r->tail + 1) & IR_EDGE_MASK);
+        if (irCapture(ch, capture)) return true;
+    }
+    if (lost) {
+        irOverflow(ch);
+        r->lost = 0;
+    }
+    return false;
+}
+
+/* Main loop. `capture` is the extended timer count latched at the edge.
+ * Returns true when this edge completes a frame. */
+bool irCapture(IrChannel *ch, uint32_t capture) {
+    uint32_t elapsed = capture - ch->lastCapture;
+    uint16_t duration = (uint16_t)elapsed;
+    IrFrame frame = { 0, 0, 0, 0 };
+    uint8_t d, bit;
+    bool mark;
+
+    ch->lastCapture = capture;
+
+    if (elapsed >= IR_GAP_US) {
+        bool done = false;
+
+        for (d = 0; d < IR_NUM_DECODERS && !done; d++) {
+            if ((ch->active & (1u << d)) && irDecoders[d].gap) {
+                done = irDecoders[d].gap(&ch->dec[d], &frame) == IR_DONE;
+            }
+        }
+        if (!done) abandon(ch);
+        rearm(ch);
+        return done && publish(ch, &frame);
+    }
+
+    if (!ch->active) return false;
+
+    mark = ch->nextMark;
+    ch->nextMark = !mark;
+
+    for (d = 0; d < IR_NUM_DECODERS; d++) {
+        bit = (uint8_t)(1u << d);
+        if (!(ch->active & bit)) continue;
+
+        switch (irDecoders[d].edge(&ch->dec[d], mark, duration, &frame)) {
+            case IR_REJECT:
+                if (ch->active == bit) {    /* the last one */
+                    abandon(ch);
+                    return false;
+                }
+                ch->active &= (uint8_t)~bit;
+                break;
+            case IR_DONE:
+                ch->active = 0;             /* rest of the frame ignored */
+                return publish(ch, &frame);
+            default:
+                break;
+        }
+    }
+    if (ch->edges != 0xFF) ch->edges++;
+    return false;
+}
+
+/* Main loop. Copies out the published frame, if any, and lets the channel
+ * publish its next. */
+bool irTakeFrame(IrChannel *ch, IrFrame *frame) {
+    if (!ch->frameReady) return false;
+
+    frame->protocol = ch->frame.protocol;
+    frame->bits     = ch->frame.bits;
+    frame->toggle   = ch->frame.toggle;
+    frame->code     = ch->frame.code;
+    ch->frameReady  = 0;
+    return true;
+}
+
+/* Edges were lost (masked, overrun); the frame in progress cannot be
+ * trusted. A published frame is kept. */
+void irAbort(IrChannel *ch) {
+    abandon(ch);
+}
+
+/* The capture register overflowed (COV): at least one edge was lost */
+void irOverflow(IrChannel *ch) {
+    ch->stats.overflows++;
+    abandon(ch);
+}
+
+/* Main loop, for a DMA-captured channel: feeds ring[*tail] up to, not
+ * including, ring[head] through irCapture(). Each count is extended
+ * against `now`, the extended timer count, so must be less than one timer
+ * period old. Stops after a count that publishes a frame and returns true,
+ * so the caller can take it before draining on. */
+bool irDrain(IrChannel *ch, const volatile uint16_t *ring, uint8_t size,
+             uint8_t *tail, uint8_t head, uint32_t now) {
+    while (*tail != head) {
+        uint16_t age = (uint16_t)((uint16_t)now - ring[*tail]);
+
+        *tail = (uint8_t)(*tail + 1 == size ? 0 : *tail + 1);
+        if (irCapture(ch, now - age)) return true;
+    }
+    return false;
+}
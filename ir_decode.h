@@ -0,0 +1,195 @@
+#ifndef IR_DECODE_H
+#define IR_DECODE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* ============================================================================
+ * IR CAPTURE AND MULTI-PROTOCOL DECODE
+ *
+ * Each IR receiver is a Timer_A capture input on both edges, counting SMCLK
+ * (1 MHz, so every duration below is in microseconds). The capture ISR
+ * extends each captured count to 32 bits with the timer's overflow count
+ * and queues it with irQueue(); the main loop decodes the queue with
+ * irPoll(). irCapture() turns each count into the time since the previous
+ * edge - so an idle gap of any length up to 71 minutes is seen as one -
+ * and streams it through every protocol decoder still in the running:
+ *
+ *   gap       a duration of IR_GAP_US or more is idle time. It ends the
+ *             frame in progress and re-arms every decoder; the edge that
+ *             ends it starts the next frame's first mark, so durations
+ *             after a gap alternate mark, space, mark...
+ *   decoders  one small state machine per protocol (irDecoders[] in
+ *             ir_decode.c), each fed every mark and space. One that finds
+ *             a duration it cannot use drops out until the next gap. The
+ *             leaders set NEC and RC5 apart from the first duration, but
+ *             not RC6 from SIRC: a 2.67 ms RC6 leader mark is also a SIRC
+ *             leader, and most RC6 durations after it are valid SIRC marks
+ *             and spaces. A clean RC6 frame loses SIRC on its 889 us
+ *             leader space, just over SIRC's 850 us limit; a distorted one
+ *             can keep both in the running to its first 889 us mark, or
+ *             through the whole frame, and the first decoder to complete
+ *             then publishes. Noise costs a handful of compares per edge
+ *   frame     the first decoder to complete publishes an IrFrame in the
+ *             channel; the rest of the frame, if any, is ignored
+ *
+ * Protocols (IrFrame.code layout):
+ *
+ *   IR_NEC         9 ms / 4.5 ms leader, 32 bits by space width, stop mark;
+ *                  the command byte must be followed by its complement.
+ *                  code = the 32 bits LSB first: address 0-15, command
+ *                  16-23, ~command 24-31
+ *   IR_NEC_REPEAT  9 ms / 2.25 ms leader and stop mark. code = 0
+ *   IR_RC5         14 Manchester bits of 889 us halves, 1 = space-mark.
+ *                  code = address << 8 | command (7 bits with RC5X)
+ *   IR_RC6         mode 0: 2.67 ms / 889 us leader, 21 Manchester bits of
+ *                  444 us halves, 1 = mark-space, double-width trailer.
+ *                  code = address << 8 | command
+ *   IR_SIRC        2.4 ms leader, 12, 15 or 20 bits by mark width, LSB
+ *                  first. code = the bits, bits = their number. With no
+ *                  stop mark, 12- and 15-bit frames end at the gap before
+ *                  the remote's repeat
+ *
+ * RC5 and RC6 toggle bits are reported apart from the code, so a held
+ * button and a new press of it map to the same command; irKeyHeld()
+ * (ir_commands.h) compares them to tell the two apart.
+ *
+ * Edge queue: IR_EDGE_RING extended counts per channel, single producer
+ * (the capture ISR) and single consumer (the main loop), like the event
+ * queue. Decoding a duration can take several hundred cycles; in the ISR
+ * that held off every lower-priority interrupt, including the speed-trap
+ * timestamps, so the ISR only queues. The count was latched by
+ * the hardware at the edge, so decoding it later costs no accuracy. When
+ * the ring is full, or the ISR reports COV, the ISR sets `lost` and queues
+ * nothing more until irPoll() has decoded what was queued before the loss
+ * and counted it - the ISR never touches decoder state.
+ *
+ * A published frame is held in the channel until the main loop takes it
+ * with irTakeFrame(); a frame completed meanwhile is dropped. Until its
+ * first gap a channel ignores every edge, and irAbort() / irOverflow() put
+ * it back in that state when edges have been lost.
+ *
+ * Each channel counts, in IrStats, what became of the frames it saw:
+ *
+ *   frames     published
+ *   dropped    completed while the last was still held
+ *   aborted    got past a leader (two durations) and then failed: every
+ *              decoder rejected an edge, a gap cut it short, or edges were
+ *              lost
+ *   overflows  losses of captures: to COV, the timer capturing again
+ *              before the last count was read, or to a full edge queue
+ *
+ * The counters wrap; the main loop may read them at any time.
+ *
+ * A channel captured by DMA instead of an interrupt has its 16-bit counts
+ * written to a ring; irDrain() extends them against the current time and
+ * feeds them through irCapture() from the main loop.
+ * ========================================================================= */
+
+#define IR_GAP_US               10000
+#define IR_EDGE_RING            16      /* ~7 ms of the fastest frame */
+#define IR_EDGE_MASK            (IR_EDGE_RING - 1)
+
+#define IR_NEC_LEADER_MIN_US    8500
+#define IR_NEC_LEADER_MAX_US    9500
+#define IR_NEC_SPACE_MIN_US     4000
+#define IR_NEC_SPACE_MAX_US     5000
+#define IR_NEC_REPEAT_MIN_US    1900
+#define IR_NEC_REPEAT_MAX_US    2600
+#define IR_NEC_MARK_MIN_US      300
+#define IR_NEC_MARK_MAX_US      900
+#define IR_NEC_SPACE_0_MAX_US   900     /* 0: 560 us */
+#define IR_NEC_SPACE_1_MIN_US   1300    /* 1: 1690 us */
+#define IR_NEC_SPACE_1_MAX_US   2100
+
+#define IR_RC5_UNIT_US          889
+#define IR_RC6_UNIT_US          444
+#define IR_UNIT_TOLERANCE_PCT   35      /* of one Manchester half-bit */
+
+#define IR_SIRC_LEADER_MIN_US   2100
+#define IR_SIRC_LEADER_MAX_US   2750
+#define IR_SIRC_SHORT_MIN_US    400     /* space, and a 0 mark: 600 us */
+#define IR_SIRC_SHORT_MAX_US    850
+#define IR_SIRC_LONG_MIN_US     950     /* a 1 mark: 1200 us */
+#define IR_SIRC_LONG_MAX_US     1500
+
+typedef enum {
+    IR_NEC = 0,
+    IR_NEC_REPEAT,
+    IR_RC5,
+    IR_RC6,
+    IR_SIRC,
+    NUM_IR_PROTOCOLS
+} IrProtocol;
+
+#define IR_NUM_DECODERS         4       /* NEC decodes its repeat too */
+
+typedef struct {
+    uint8_t  protocol;      /* IrProtocol */
+    uint8_t  bits;          /* SIRC: 12, 15 or 20 */
+    uint8_t  toggle;        /* RC5 / RC6 */
+    uint32_t code;
+} IrFrame;
+
+/* One decoder's progress through the current frame */
+typedef struct {
+    uint8_t  step;          /* durations taken */
+    uint8_t  bits;          /* bits complete */
+    uint8_t  half;          /* Manchester: units into the current bit */
+    uint8_t  level;         /* Manchester: first-half level, mark = 1 */
+    uint32_t value;
+} IrDecodeState;
+
+typedef enum {
+    IR_MORE = 0,
+    IR_REJECT,
+    IR_DONE
+} IrStatus;
+
+/* edge() takes every duration of a frame; gap(), if the protocol has one,
+ * may complete the frame when idle time follows its last edge */
+typedef struct {
+    IrStatus (*edge)(IrDecodeState *s, bool mark, uint16_t us, IrFrame *out);
+    IrStatus (*gap)(IrDecodeState *s, IrFrame *out);
+} IrDecoder;
+
+typedef struct {
+    uint16_t frames;
+    uint16_t dropped;
+    uint16_t aborted;
+    uint16_t overflows;
+} IrStats;
+
+/* IR_EDGE_RING must be a power of two; one slot is kept empty */
+typedef struct {
+    volatile uint32_t stamp[IR_EDGE_RING];
+    volatile uint8_t  head;         /* next slot to fill - capture ISR */
+    volatile uint8_t  tail;         /* next slot to decode - main loop */
+    volatile uint8_t  lost;         /* set by the ISR, cleared by irPoll() */
+} IrEdgeRing;
+
+typedef struct {
+    IrEdgeRing       ring;
+    IrDecodeState    dec[IR_NUM_DECODERS];  /* main loop only */
+    uint8_t          active;                /* decoders still in the frame */
+    uint8_t          edges;                 /* taken since the gap (max 255) */
+    bool             nextMark;
+    uint32_t         lastCapture;
+    volatile IrFrame frame;
+    volatile uint8_t frameReady;    /* set by the decode, cleared on take */
+    volatile IrStats stats;
+} IrChannel;
+
+extern const IrDecoder irDecoders[IR_NUM_DECODERS];
+
+void irInit(IrChannel *ch);
+void irQueue(IrChannel *ch, uint32_t capture, bool overflow);
+bool irPoll(IrChannel *ch);
+bool irCapture(IrChannel *ch, uint32_t capture);
+bool irTakeFrame(IrChannel *ch, IrFrame *frame);
+void irAbort(IrChannel *ch);
+void irOverflow(IrChannel *ch);
+bool irDrain(IrChannel *ch, const volatile uint16_t *ring, uint8_t size,
+             uint8_t *tail, uint8_t head, uint32_t now);
+
+#endif /* IR_DECODE_H */
@@ -1,7 +1,11 @@
 #include <msp430.h>
 #include <stdint.h>
 #include <stdbool.h>
-#include "traffic_states.h"
+#include "controller.h"
+#include "event_queue.h"
+#include "ir_decode.h"
+#include "ir_commands.h"
+#include "timebase.h"
 #include <msp430fr6989.h>
 #include <driverlib.h>
 
@@ -10,12 +14,64 @@
 #define SOUTH_LEFT_PIN   BIT5   // P2.5
 void initLeftTurnSensors(void);
 
+// Coordination sync pulse from the upstream master (rising edge = cycle zero)
+#define SYNC_PULSE_PIN   BIT3   // P2.3
+
+// ============================================================================
+// PIN DEFINITIONS - SPEED TRAPS (dilemma zone)
+// Upstream / downstream detector per approach, active LOW with pull-ups.
+// Port ISRs timestamp each edge from the free-running Timer_A3.
+// ============================================================================
+#define TRAP_N_UP        BIT4   // P4.4
+#define TRAP_N_DOWN      BIT5   // P4.5
+#define TRAP_S_UP        BIT6   // P4.6
+#define TRAP_S_DOWN      BIT7   // P4.7
+#define TRAP_E_UP        BIT0   // P3.0
+#define TRAP_E_DOWN      BIT1   // P3.1
+#define TRAP_W_UP        BIT2   // P3.2
+#define TRAP_W_DOWN      BIT7   // P3.7
+#define TRAP_P4_PINS     (TRAP_N_UP | TRAP_N_DOWN | TRAP_S_UP | TRAP_S_DOWN)
+#define TRAP_P3_PINS     (TRAP_E_UP | TRAP_E_DOWN | TRAP_W_UP | TRAP_W_DOWN)
+
+// ============================================================================
+// PIN DEFINITIONS - DETECTOR CHAIN (74HC165, see detector_bus.h)
+// Clocked out over eUSCI_A1 in SPI master mode. SIMO is not used: P3.4,
+// its pin, is switched to TB0.3 (SEL1) for the lamp PWM, so the dummy
+// bytes that clock the chain never reach /OE.
+//
+// The chain is only set up and scanned when built with -DDET_CHAIN_FITTED:
+// on a board without it SOMI floats, and the controller would read noise as
+// vehicles. Unscanned, the chain never produces an edge, so the controller
+// keeps its phases on max recall (controller.c).
+// ============================================================================
+#define DET_SOMI_PIN     BIT5   // P3.5 - UCA1SOMI <- QH of the first 74HC165
+#define DET_CLK_PIN      BIT6   // P3.6 - UCA1CLK
+#define DET_LOAD_PIN     BIT6   // P2.6 - SH/LD, LOW = parallel load
+
+// Detector fault lamp - LaunchPad LED1, lit while any detector has failed
+#define FAULT_LAMP_PIN   BIT0   // P1.0
+
 // ============================================================================
 // PIN DEFINITIONS - SHIFT REGISTER (Traffic LEDs)
 // ============================================================================
 #define DATA_PIN        BIT0    // P2.0 - Serial data
 #define SHIFT_CLK_PIN   BIT1    // P2.1 - Shift clock
 #define LATCH_CLK_PIN   BIT2    // P2.2 - Latch clock
+#define OE_PIN          BIT4    // P3.4 - Output enable (active LOW, TB0.3 PWM)
+
+// ============================================================================
+// LAMP DIMMING
+// The 74HC595 /OE line is driven by TB0.3 in set/reset mode, sharing the 1ms
+// period of the Timer_B0 tick (TB0CCR0 = 125), so the lamps are PWM'd at 1kHz.
+// Ambient light is read from a photoresistor divider on P8.4/A7 once a second
+// and mapped onto 16 brightness levels, which also drive MAX7219 register 0x0A.
+// ============================================================================
+#define AMBIENT_PIN             BIT4    // P8.4 - A7 photoresistor divider
+#define LAMP_PWM_PERIOD         125     // Must match TB0CCR0
+#define LAMP_DUTY_MIN_PCT       30      // Signal heads never dim below this
+#define BRIGHTNESS_LEVELS       16      // 0..15, same scale as MAX7219 0x0A
+#define BRIGHTNESS_HYSTERESIS   64      // ADC counts past a level boundary
+#define MATRIX_INTENSITY_DEFAULT 0x0F
 
 // ============================================================================
 // PIN DEFINITIONS - MAX7219 (Pedestrian LED Matrices)
@@ -28,7 +84,7 @@ void initLeftTurnSensors(void);
 // PIN DEFINITIONS - BUTTONS - Active LOW with pull-ups
 // ============================================================================
 #define BTN_PED_NORTH           BIT3    // P3.3
-#define BTN_PED_WEST            BIT6    // P3.6
+#define BTN_PED_WEST            BIT7    // P2.7 (P3.6 is UCA1CLK)
 #define BTN_PED_SOUTH           BIT0    // P4.0
 #define BTN_PED_EAST            BIT1    // P4.1
 
@@ -41,57 +97,35 @@ void initLeftTurnSensors(void);
 #define BUZZ_EAST       BIT2    // P9.2
 #define BUZZ_WEST       BIT3    // P9.3
 
-// Buzzer timing in milliseconds
-// During WALK: slow steady beep
-// During COUNTDOWN: accelerates as counter approaches 0
-#define BEEP_ON_MS          40      // beep pulse duration
-#define GAP_WALK_MS         700     // walk phase - slow steady beep (1Hz overall)
-#define GAP_COUNTDOWN_MAX   700     // counter == 9 -> matches walk pace
-#define GAP_COUNTDOWN_MIN   200      // counter == 0 -> very fast, near continuous
-
 // ============================================================================
 // PEDESTRIAN MATRIX DEFINITIONS
+// One MAX7219 per crosswalk, indexed as the controller's PED_* devices
 // ============================================================================
-#define NUM_DEVICES     4
 #define NUM_OF_DIGIT    12
 #define LSBFIRST        0
 #define MSBFIRST        1
 
-// Device index to intersection direction mapping
-// NOTE: PED_SOUTH and PED_EAST swapped from 1/2 to 2/1
-// This corrects the physical matrix positions on the board without
-// changing the daisy chain wiring order.
-#define PED_NORTH       0
-#define PED_SOUTH       2
-#define PED_EAST        1
-#define PED_WEST        3
-
-// Walk display time (seconds) before countdown begins
-#define WALK_TIME_NS    8
-#define WALK_TIME_EW    8
-
-typedef enum {
-    STATE_HAND,
-    STATE_WALK,
-    STATE_COUNTDOWN
-} State_walking;
-
 // ============================================================================
 // IR RECEIVER DEFINITIONS
+// Capture and decoding are in ir_decode.c; codes map to actions through the
+// learnable command map (ir_commands.h)
+//
+// Edge budget: a receiver taking IR_EDGE_BUDGET capture interrupts within
+// one IR_SERVICE_PERIOD_MS is masked for the rest of it, so sunlight or
+// other IR noise cannot hold off Timer_B0 and the other ISRs. The fastest
+// real frame (RC6) needs about 12 edges per period. A masked receiver has
+// lost edges, so its frame in progress is abandoned when it is unmasked.
+//
+// Built with -DIR_CAPTURE_DMA, ir[0] (P1.5, TA0.CCR0) is captured by DMA2
+// into irDmaRing and drained every IR_SERVICE_PERIOD_MS, with no interrupt
+// per edge. The other receivers stay on interrupts: TA0.CCR1 and TA1.CCR1
+// cannot trigger DMA on this part, and DMA0 / DMA1 run the detector chain.
 // ============================================================================
-#define CaptureBufferSize 68
-#define totalTimings 67
-#define UpperLeader 9500
-#define LowerLeader 8500
 #define NUM_CHANNELS 4
-
-typedef struct {
-    volatile uint16_t buffer[CaptureBufferSize];
-    volatile uint16_t lastCapture;
-    volatile uint8_t frameComplete;
-    volatile uint8_t captureIndex;
-    volatile uint8_t leaderDetected;
-} IR_Channel;
+#define IR_SERVICE_PERIOD_MS    5
+#define IR_EDGE_BUDGET          24
+#define IR_DMA_RING             64      // counts, ~20 ms of the fastest frame
+#define IR_DMA_CHANNEL          0
 
 // =========================
 // IR REMOTE CODES
@@ -118,63 +152,168 @@ typedef struct {
 #define IR_EQ           0xE619FF00
 #define IR_STREPT       0xF20DFF00
 
+// Seeded into the command map on first boot, and again when IR_MAP_MAGIC
+// changes; more are learned in the field
+const IrMapEntry irMapDefaults[] = {
+    { IR_UpArrow,    IR_NEC, 0, IR_ACT_MODE_DAYTIME      },
+    { IR_DownArrow,  IR_NEC, 0, IR_ACT_MODE_NIGHT        },
+    { IR_FastFoward, IR_NEC, 0, IR_ACT_MODE_HIGH_TRAFFIC },
+    { IR_BackButton, IR_NEC, 0, IR_ACT_PREEMPT           },
+    { IR_EQ,         IR_NEC, 0, IR_ACT_COORD_TOGGLE      },
+    { IR_FuncStop,   IR_NEC, 0, IR_ACT_LEARN             },
+    { IR_VolPlus,    IR_NEC, 0, IR_ACT_CLOCK_HOUR        },
+    { IR_VolMinus,   IR_NEC, 0, IR_ACT_CLOCK_MINUTE      }
+};
+#define NUM_IR_DEFAULTS (sizeof irMapDefaults / sizeof irMapDefaults[0])
+
 // ============================================================================
-// GLOBAL VARIABLES - TRAFFIC SIGNAL
+// INTERSECTION
+// The controller logic (controller.c) runs on one IntersectionContext; the
+// bindings below connect it to this board.
 // ============================================================================
-LEDState currentLEDs;
-TrafficState currentState    = STATE_NS_GREEN;
-OperatingMode currentMode    = MODE_DAYTIME;
-volatile uint32_t systemTick = 0;
-volatile uint32_t stateTimer = 0;
-volatile bool stateExpired   = false;
+IntersectionContext intersection;
+
+void boardShowSignals(void *board, const LEDState *leds);
+void boardShowPeds(void *board, const uint8_t image[NUM_DEVICES]);
+void boardSetBuzzer(void *board, uint8_t device, bool on);
+bool boardBayOccupied(void *board, LeftBay bay);
+void boardMaskBay(void *board, LeftBay bay, bool masked);
+bool boardBayChattered(void *board, LeftBay bay);
+void boardSetFaultLamp(void *board, bool on);
+
+const CtlBindings boardBindings = {
+    boardShowSignals,
+    boardShowPeds,
+    boardSetBuzzer,
+    boardBayOccupied,
+    boardMaskBay,
+    boardBayChattered,
+    boardSetFaultLamp
+};
 
-/* ============================================================================
- * EMERGENCY SAVE/RESTORE
- * ========================================================================= */
-volatile TrafficState savedState;
-volatile OperatingMode savedMode;
-volatile bool inEmergency;
+// ============================================================================
+// EVENT QUEUE
+// Every ISR but the IR captures reports through evq (event_queue.h) and
+// serviceEvents() drains it at the top of the main loop; the captures
+// queue their edges in their IrChannel for pollIr(). Everything below that
+// an ISR does not write is owned by the main loop and is not volatile.
+// ============================================================================
+EventQueue evq;
 
 // ============================================================================
-// HALL EFFECT SENSOR DEMAND FLAGS
-// Set by Port_2 ISR when a vehicle is detected in left turn lane
-// Currently used as latch flags - sensors are also polled directly in
-// getNextState() for phase-skip logic in traffic_states.c
+// TIMEBASE
+// timebase.h: milliseconds from the Timer_B0 tick, and cycles - TA0R
+// (SMCLK, 1 us) extended by its overflows. Every clock read goes through
+// tbMillis() / tbCycles(), so none can tear.
 // ============================================================================
-volatile bool northLeftDemand = false;
-volatile bool southLeftDemand = false;
+Timebase timebase;
 
 // ============================================================================
-// GLOBAL VARIABLES - PEDESTRIAN MATRICES
+// SOFTWARE TIMERS
+// Timer_B0 only advances the millisecond count; the main loop runs the
+// wheel (timer_wheel.h) and every callback fires in main context. The
+// controller's own timers run on the same wheel.
 // ============================================================================
-volatile State_walking state_walking[NUM_DEVICES];
-volatile uint8_t walk_counter[NUM_DEVICES];
-volatile uint8_t walk_display_time[NUM_DEVICES];
-volatile uint8_t tick_1s = 0;
-volatile uint16_t msCount = 0;
+TimerWheel wheel;
+SoftTimer  detScanTimer;                // detector chain scan
+SoftTimer  brightnessTimer;             // 1 s ambient light sample
 
-// Walk request flags - set by button press, cleared after start_walk()
-volatile bool pedWalkRequest[NUM_DEVICES];
+// ============================================================================
+// COORDINATION
+// RTC second boundaries are timestamped with tbMillis() in the RTC ISR; the
+// calendar is read once RTCRDY allows it and handed to the controller.
+// irApproach[] maps each IR receiver to the approach it faces, so a
+// preemption call is served on the approach it was received from.
+// ============================================================================
+uint32_t rtcSecondTick   = 0;
+bool     rtcSecondFlag   = false;
+const Approach irApproach[NUM_CHANNELS] = {
+    APPROACH_NORTH,     // ir[0] - P1.5
+    APPROACH_SOUTH,     // ir[1] - P1.6
+    APPROACH_EAST,      // ir[2] - P1.7
+    APPROACH_WEST       // ir[3] - P3.3
+};
 
-// Tracks whether a button-press extension has already been used this phase
-// Cleared at the start of each new vehicle green phase via triggerPedWalk()
-// Limits each pedestrian to one walk-extension per green phase
-volatile bool pedExtendUsed[NUM_DEVICES];
+// ============================================================================
+// DETECTOR CHAIN
+// The detScanTimer starts a scan every DET_SCAN_PERIOD_MS; DMA0 fills
+// detScanBuf from UCA1RXBUF while DMA1 feeds UCA1TXBUF the dummy bytes that
+// clock it, and the DMA0 end-of-scan interrupt posts EV_DET_SCAN. The main
+// loop hands the buffer to the controller before the next scan may start.
+// ============================================================================
+uint8_t detScanBuf[DET_CHAIN_DEVICES];
+bool detScanPending = false;
+const uint8_t detDummyTx = 0xFF;
 
 // ============================================================================
-// GLOBAL VARIABLES - BUZZERS
-// Each buzzer is independently driven from the 1ms Timer_B0 ISR.
-// timerMs[i]    counts milliseconds within the current beep cycle
-// phaseOn[i]    true = currently in BEEP_ON_MS pulse, false = in gap
+// DETECTOR DIAGNOSTICS
+// Judged by the controller on its 1s tick (detector_health.h). Port_2_ISR
+// keeps its own burst count and masks a bay's interrupt itself once it
+// reaches the chatter threshold, so a chattering input cannot flood the
+// event queue. It raises bayChatter[] as it does, and the controller fails
+// the bay as chattering and owns the retry that re-arms it. The fault log
+// lives in FRAM.
 // ============================================================================
-volatile uint16_t buzzTimerMs[NUM_DEVICES];
-volatile bool     buzzPhaseOn[NUM_DEVICES];
+const uint8_t bayPin[NUM_LEFT_BAYS] = {
+    [BAY_NORTH_LEFT] = NORTH_LEFT_PIN,
+    [BAY_SOUTH_LEFT] = SOUTH_LEFT_PIN
+};
+volatile bool bayChatter[NUM_LEFT_BAYS];    // masked by Port_2_ISR
+
+#pragma PERSISTENT(detLog)
+DetLog detLog = {0};
 
 // ============================================================================
 // GLOBAL VARIABLES - IR RECEIVERS
+// The command map lives in FRAM so learned remotes survive a reset.
+// irActions[] dispatches each IrAction; IR_ACT_NONE and IR_ACT_LEARN have
+// no handler.
 // ============================================================================
-IR_Channel ir[NUM_CHANNELS];
-volatile uint32_t result[NUM_CHANNELS];
+IrChannel ir[NUM_CHANNELS];
+volatile uint8_t irEdges[NUM_CHANNELS];     // this period, per receiver
+volatile uint16_t ta1Overflows = 0;         // TAIFG counts, the high half
+                                            // of ir[3]'s captures; TA0's
+                                            // are timebase's
+volatile uint16_t *const irCctl[NUM_CHANNELS] = {
+    &TA0CCTL0, &TA0CCTL1, &TA0CCTL2, &TA1CCTL1
+};
+SoftTimer irServiceTimer;
+
+#ifdef IR_CAPTURE_DMA
+volatile uint16_t irDmaRing[IR_DMA_RING];
+uint8_t irDmaTail = 0;
+#endif
+
+#pragma PERSISTENT(irMap)
+IrCommandMap irMap = {0};
+IrLearn      irLearn;
+IrHeldKey    irHeld[NUM_CHANNELS];      // last frame per receiver
+
+typedef void (*IrActionFn)(uint8_t channel);
+void irActDaytime(uint8_t channel);
+void irActNight(uint8_t channel);
+void irActHighTraffic(uint8_t channel);
+void irActPreempt(uint8_t channel);
+void irActCoordToggle(uint8_t channel);
+void irActClockHour(uint8_t channel);
+void irActClockMinute(uint8_t channel);
+
+const IrActionFn irActions[NUM_IR_ACTIONS] = {
+    [IR_ACT_MODE_DAYTIME]      = irActDaytime,
+    [IR_ACT_MODE_NIGHT]        = irActNight,
+    [IR_ACT_MODE_HIGH_TRAFFIC] = irActHighTraffic,
+    [IR_ACT_PREEMPT]           = irActPreempt,
+    [IR_ACT_COORD_TOGGLE]      = irActCoordToggle,
+    [IR_ACT_CLOCK_HOUR]        = irActClockHour,
+    [IR_ACT_CLOCK_MINUTE]      = irActClockMinute
+};
+
+// ============================================================================
+// GLOBAL VARIABLES - LAMP DIMMING
+// ambientFiltered is an IIR-smoothed ADC reading (1/8 weight per sample)
+// ============================================================================
+uint16_t ambientFiltered = 4095;
+uint8_t  brightnessLevel = BRIGHTNESS_LEVELS - 1;
 
 // ============================================================================
 // PEDESTRIAN IMAGE TABLE
@@ -213,11 +352,17 @@ const uint8_t images[NUM_OF_DIGIT][8] = {
 void System_init(void);
 void GPIO_init(void);
 void Timer_init(void);
-void shiftOut32bits(uint8_t *data);
-OperatingMode checkModeButtons(volatile uint32_t *result);
-void handleModeChange(OperatingMode newMode);
+void shiftOut32bits(const uint8_t *data);
+void handleIrFrame(uint8_t channel);
 void checkPedButtons(void);
-void triggerPedWalk(TrafficState state);
+void RTC_init(void);
+void initSyncPulseInput(void);
+void serviceRtc(void);
+void fyaTimerInit(void);
+void speedTrapInit(void);
+void serviceEvents(void);
+void detectorChainInit(void);
+void detScanStart(void *owner, uint8_t id);
 
 void matrixPinInit(void);
 void matrixClockLow(void);
@@ -227,67 +372,61 @@ void matrixLatchHigh(void);
 void matrixDataLow(void);
 void matrixDataHigh(void);
 void matrixShiftOut(uint8_t bitOrder, uint16_t value);
-void sendMatrixPacket(uint8_t address, uint8_t data[NUM_DEVICES]);
+void sendMatrixPacket(uint8_t address, const uint8_t data[NUM_DEVICES]);
 void ledMatrixInit(void);
-void sendMatrixImage(uint8_t digits[NUM_DEVICES]);
-void updatePedStateMachine(void);
-void displayPedState(void);
-void start_walk(uint8_t device, uint8_t walkTime);
+void sendMatrixImage(const uint8_t digits[NUM_DEVICES]);
 void Timer1_init(void);
 
-uint32_t decodeNEC(volatile uint16_t *buffer);
-void handleCapture(IR_Channel *ch, uint16_t currentcapture);
+void handleCapture(uint8_t channel, uint32_t capture);
+void pollIrChannel(uint8_t channel);
+void pollIr(void);
+uint32_t extendCapture(uint16_t overflows, uint16_t timerCtl, uint16_t count);
 void initTimerA0Capture(void);
 void initTimerA1Capture(void);
 void initTimerAContinuousMode(void);
 void initPins(void);
 void InitIRChannels(void);
 void TimerEnableCCRI(void);
+void irDmaInit(void);
+void irService(void *owner, uint8_t id);
 
 void buzzerInit(void);
-void setBuzzerPin(uint8_t device, bool on);
-uint16_t buzzerGapForDevice(uint8_t device);
-void serviceBuzzers(void);
+void softTimersInit(void);
+void brightnessTick(void *owner, uint8_t id);
 
-// Returns true if any pedestrian matrix is currently in WALK or COUNTDOWN
-// Used to block traffic phase transitions until all pedestrians finish crossing
-bool anyPedestrianActive(void);
+void lampDimmingInit(void);
+uint16_t readAmbientLight(void);
+void updateBrightness(void);
+void setLampBrightness(uint8_t level);
+void setMatrixIntensity(uint8_t level);
 
 // ============================================================================
 // MAIN FUNCTION
 // ============================================================================
 int main(void) {
-    OperatingMode requestedMode;
-    bool ledsNeedUpdate;
-    int i;
-
     WDTCTL = WDTPW | WDTHOLD;
 
     PM5CTL0 &= ~LOCKLPM5;
 
+    tbInit(&timebase, &TA0R, &TA0CTL, TAIFG);
     System_init();
     GPIO_init();
     initLeftTurnSensors();
+    initSyncPulseInput();
     Timer_init();
+    RTC_init();
+    fyaTimerInit();
+    speedTrapInit();
+#ifdef DET_CHAIN_FITTED
+    detectorChainInit();
+#endif
     matrixPinInit();
     ledMatrixInit();
     buzzerInit();
+    lampDimmingInit();
 
-    initLEDState(&currentLEDs);
-    setAllRed(&currentLEDs);
-    shiftOut32bits(currentLEDs.byte);
-
-    for (i = 0; i < NUM_DEVICES; i++) {
-        state_walking[i]     = STATE_HAND;
-        pedWalkRequest[i]    = false;
-        pedExtendUsed[i]     = false;
-        walk_counter[i]      = 0;
-        walk_display_time[i] = 0;
-        buzzTimerMs[i]       = 0;
-        buzzPhaseOn[i]       = false;
-    }
-
-    displayPedState();
+    softTimersInit();
+    ctlInit(&intersection, &boardBindings, 0, &wheel, &detLog);
 
     InitIRChannels();
     initPins();
@@ -295,105 +434,19 @@ int main(void) {
     initTimerA1Capture();
     TimerEnableCCRI();
     initTimerAContinuousMode();
+    evqInit(&evq);
     __enable_interrupt();
 
-    currentState = STATE_NS_GREEN;
-    currentMode  = MODE_DAYTIME;
-    stateTimer   = getStateDuration(currentState);
-
-    executeState(&currentLEDs, currentState);
-    shiftOut32bits(currentLEDs.byte);
+    ctlStart(&intersection);
 
     while (1) {
-        for (unsigned int j = 0; j < NUM_CHANNELS; j++) {
-            if (ir[j].frameComplete) {
-                result[j] = decodeNEC(ir[j].buffer);
-                ir[j].frameComplete = 0;
-                ir[j].leaderDetected = 0;
-            }
-        }
-
-        ledsNeedUpdate = false;
-
-        requestedMode = checkModeButtons(result);
-        for (unsigned int j = 0; j < NUM_CHANNELS; j++) result[j] = 0;
-        if (requestedMode != currentMode) {
-            handleModeChange(requestedMode);
-            ledsNeedUpdate = true;
-        }
-
+        // Due software timers first - state expiry, 1 s tick, scans, beeps
+        wheelAdvance(&wheel, tbMillis(&timebase));
+        serviceEvents();
+        pollIr();
+        serviceRtc();
         checkPedButtons();
-
-        if (stateExpired) {
-            // CRITICAL: do not advance state if any pedestrian is still
-            // walking or counting down. Hold the green phase until all
-            // pedestrians have finished crossing (state returns to HAND).
-            // Emergency mode bypasses this check - safety override always wins.
-            if (!inEmergency && anyPedestrianActive()) {
-                // Reload stateTimer with a small holdover so we keep
-                // checking each loop iteration without spinning
-                stateTimer = 1000;  // 1 second holdover, will retry
-                stateExpired = false;
-            }
-            else {
-                stateExpired = false;
-
-                if (inEmergency) {
-                if (currentState == STATE_EMERGENCY_ALL_RED) {
-                    currentState = STATE_EMERGENCY_HOLD;
-                    stateTimer   = getStateDuration(STATE_EMERGENCY_HOLD);
-                    ledsNeedUpdate = true;
-                }
-                else {
-                    inEmergency  = false;
-                    currentMode  = savedMode;
-                    currentState = savedState;
-                    stateTimer   = getStateDuration(savedState);
-                    ledsNeedUpdate = true;
-                }
-            }
-            else {
-                currentState = getNextState(currentState, currentMode);
-
-                if (currentMode == MODE_DAYTIME) {
-                    if (currentState > STATE_RETURN_TO_START)
-                        currentState = STATE_NS_GREEN;
-                }
-                else if (currentMode == MODE_HIGH_TRAFFIC) {
-                    if (currentState < STATE_N_PRIORITY_START ||
-                        currentState > STATE_RETURN_HT)
-                        currentState = STATE_N_PRIORITY_START;
-                }
-
-                stateTimer = getStateDuration(currentState);
-                triggerPedWalk(currentState);
-                ledsNeedUpdate = true;
-            }
-            }  // end of !anyPedestrianActive else branch
-        }
-
-        if (ledsNeedUpdate) {
-            executeState(&currentLEDs, currentState);
-            shiftOut32bits(currentLEDs.byte);
-        }
-
-        // 1-second pedestrian update
-        if (tick_1s) {
-            tick_1s = 0;
-
-            for (i = 0; i < NUM_DEVICES; i++) {
-                if (pedWalkRequest[i]) {
-                    start_walk(i, WALK_TIME_NS);
-                    pedWalkRequest[i] = false;
-                }
-            }
-
-            updatePedStateMachine();
-            displayPedState();
-        }
-
-        // Service buzzers - runs every loop iteration (woken by 1ms tick)
-        serviceBuzzers();
+        ctlStep(&intersection);
 
         __bis_SR_register(LPM0_bits + GIE);
         __no_operation();
@@ -401,176 +454,23 @@ int main(void) {
 }
 
 // ============================================================================
-// PEDESTRIAN BUTTON HANDLER
-// Two behaviors based on current matrix state:
-//
-//   1. STATE_HAND during a green phase: queue a fresh walk request
-//   2. STATE_WALK with extension unused: reset walk timer to full duration
-//      (one extension per green phase per direction)
-//
-// Presses during STATE_COUNTDOWN are ignored - too late to extend.
+// PEDESTRIAN BUTTONS
+// Polled every pass; a held button is handed to the controller, which
+// decides between a walk request and an extension (ctlPedButton).
 // ============================================================================
 void checkPedButtons(void) {
+    uint8_t p2btn = P2IN;
     uint8_t p3btn = P3IN;
     uint8_t p4btn = P4IN;
 
-    // North - P3.3
-    if (!(p3btn & BTN_PED_NORTH)) {
-        if (state_walking[PED_NORTH] == STATE_WALK &&
-            !pedExtendUsed[PED_NORTH]) {
-            walk_display_time[PED_NORTH] = WALK_TIME_NS;
-            pedExtendUsed[PED_NORTH] = true;
-        }
-        else if (currentState == STATE_NS_GREEN ||
-                 currentState == STATE_NS_BOTH_GREEN) {
-            pedWalkRequest[PED_NORTH] = true;
-        }
-    }
-
-    // South - P4.0
-    if (!(p4btn & BTN_PED_SOUTH)) {
-        if (state_walking[PED_SOUTH] == STATE_WALK &&
-            !pedExtendUsed[PED_SOUTH]) {
-            walk_display_time[PED_SOUTH] = WALK_TIME_NS;
-            pedExtendUsed[PED_SOUTH] = true;
-        }
-        else if (currentState == STATE_NS_GREEN ||
-                 currentState == STATE_NS_BOTH_GREEN) {
-            pedWalkRequest[PED_SOUTH] = true;
-        }
-    }
-
-    // East - P4.1
-    if (!(p4btn & BTN_PED_EAST)) {
-        if (state_walking[PED_EAST] == STATE_WALK &&
-            !pedExtendUsed[PED_EAST]) {
-            walk_display_time[PED_EAST] = WALK_TIME_EW;
-            pedExtendUsed[PED_EAST] = true;
-        }
-        else if (currentState == STATE_E_THRU_GREEN ||
-                 currentState == STATE_E_THRU_GREEN_HT) {
-            pedWalkRequest[PED_EAST] = true;
-        }
-    }
-
-    // West - P3.6
-    if (!(p3btn & BTN_PED_WEST)) {
-        if (state_walking[PED_WEST] == STATE_WALK &&
-            !pedExtendUsed[PED_WEST]) {
-            walk_display_time[PED_WEST] = WALK_TIME_EW;
-            pedExtendUsed[PED_WEST] = true;
-        }
-        else if (currentState == STATE_W_THRU_GREEN ||
-                 currentState == STATE_W_THRU_GREEN_HT) {
-            pedWalkRequest[PED_WEST] = true;
-        }
-    }
-}
-
-// ============================================================================
-// AUTO PEDESTRIAN TRIGGER
-// Called on every state transition - only fires walk on green states
-// Also resets the per-phase extension flag for affected directions so each
-// pedestrian gets a fresh extension opportunity at the start of every green
-// ============================================================================
-void triggerPedWalk(TrafficState state) {
-    switch (state) {
-        case STATE_NS_GREEN:
-        case STATE_NS_BOTH_GREEN:
-            pedExtendUsed[PED_NORTH] = false;
-            pedExtendUsed[PED_SOUTH] = false;
-            start_walk(PED_NORTH, WALK_TIME_NS);
-            start_walk(PED_SOUTH, WALK_TIME_NS);
-            break;
-        case STATE_W_THRU_GREEN:
-        case STATE_W_THRU_GREEN_HT:
-            pedExtendUsed[PED_WEST] = false;
-            start_walk(PED_WEST, WALK_TIME_EW);
-            break;
-        case STATE_E_THRU_GREEN:
-        case STATE_E_THRU_GREEN_HT:
-            pedExtendUsed[PED_EAST] = false;
-            start_walk(PED_EAST, WALK_TIME_EW);
-            break;
-        default:
-            break;
-    }
+    if (!(p3btn & BTN_PED_NORTH)) ctlPedButton(&intersection, PED_NORTH);
+    if (!(p4btn & BTN_PED_SOUTH)) ctlPedButton(&intersection, PED_SOUTH);
+    if (!(p4btn & BTN_PED_EAST))  ctlPedButton(&intersection, PED_EAST);
+    if (!(p2btn & BTN_PED_WEST))  ctlPedButton(&intersection, PED_WEST);
 }
 
 // ============================================================================
-// PEDESTRIAN STATE MACHINE UPDATE
-// ============================================================================
-void updatePedStateMachine(void) {
-    int i;
-    for (i = 0; i < NUM_DEVICES; i++) {
-        switch (state_walking[i]) {
-            case STATE_WALK:
-                if (walk_display_time[i] > 0) walk_display_time[i]--;
-                if (walk_display_time[i] == 0) {
-                    state_walking[i] = STATE_COUNTDOWN;
-                    walk_counter[i]  = 9;
-                }
-                break;
-
-            case STATE_COUNTDOWN:
-                if (walk_counter[i] > 0) walk_counter[i]--;
-                else state_walking[i] = STATE_HAND;
-                break;
-
-            default:
-                break;
-        }
-    }
-}
-
-void displayPedState(void) {
-    uint8_t display_all[NUM_DEVICES];
-    int i;
-    for (i = 0; i < NUM_DEVICES; i++) {
-        switch (state_walking[i]) {
-            case STATE_HAND:      display_all[i] = 10;              break;
-            case STATE_WALK:      display_all[i] = 11;              break;
-            case STATE_COUNTDOWN: display_all[i] = walk_counter[i]; break;
-            default:              display_all[i] = 10;              break;
-        }
-    }
-    sendMatrixImage(display_all);
-}
-
-void start_walk(uint8_t device, uint8_t walkTime) {
-    if (state_walking[device] == STATE_HAND) {
-        state_walking[device]     = STATE_WALK;
-        walk_display_time[device] = walkTime;
-    }
-}
-
-// ============================================================================
-// PEDESTRIAN ACTIVITY CHECK
-// Returns true if ANY direction is currently walking or counting down.
-// Used to block traffic phase transition until pedestrians finish crossing.
-// ============================================================================
-bool anyPedestrianActive(void) {
-    uint8_t i;
-    for (i = 0; i < NUM_DEVICES; i++) {
-        if (state_walking[i] == STATE_WALK ||
-            state_walking[i] == STATE_COUNTDOWN) {
-            return true;
-        }
-    }
-    return false;
-}
-
-// ============================================================================
-// BUZZER CONTROL - 4 INDEPENDENT BUZZERS
-//
-// Each buzzer mirrors the state of its corresponding pedestrian matrix:
-//   STATE_HAND      -> silent
-//   STATE_WALK      -> slow steady beep, 40ms on, 500ms gap
-//   STATE_COUNTDOWN -> accelerating beep
-//                      counter 9: 500ms gap (matches walk pace)
-//                      counter 0: 25ms gap (near continuous)
-//
-// All timing driven from 1ms Timer_B0 ISR via buzzTimerMs[] counter.
+// BUZZERS - one per crosswalk, beep cadence from the controller
 // ============================================================================
 void buzzerInit(void) {
     P9DIR |=  (BUZZ_NORTH | BUZZ_SOUTH | BUZZ_EAST | BUZZ_WEST);
@@ -579,7 +479,8 @@ void buzzerInit(void) {
     P9SEL1 &= ~(BUZZ_NORTH | BUZZ_SOUTH | BUZZ_EAST | BUZZ_WEST);
 }
 
-void setBuzzerPin(uint8_t device, bool on) {
+void boardSetBuzzer(void *board, uint8_t device, bool on) {
+    (void)board;
     uint8_t mask;
     switch (device) {
         case PED_NORTH: mask = BUZZ_NORTH; break;
@@ -592,136 +493,452 @@ void setBuzzerPin(uint8_t device, bool on) {
     else    P9OUT &= ~mask;
 }
 
-// Returns the current gap (off-time) in ms for this device based on its state
-// Returns 0 when buzzer should be silent
-uint16_t buzzerGapForDevice(uint8_t device) {
-    uint32_t span;
-    uint16_t gap;
+// ============================================================================
+// LAMP DIMMING
+//
+// Brightness follows ambient light on a 1s cadence:
+//   ADC sample -> IIR filter -> level 0..15 (with hysteresis) ->
+//     /OE duty  = LAMP_DUTY_MIN_PCT .. 100%
+//     MAX7219   = intensity register 0x0A
+//
+// The hysteresis band keeps the level from hunting when the reading sits on
+// a boundary (dusk, passing headlights).
+// ============================================================================
+void lampDimmingInit(void) {
+    // /OE on TB0.3 - output low until the first brightness update. TB0.3
+    // is the secondary function of P3.4 (SEL1); the primary is UCA1SIMO.
+    P3DIR  |=  OE_PIN;
+    P3SEL0 &= ~OE_PIN;
+    P3SEL1 |=  OE_PIN;
+    TB0CCTL3 = OUTMOD_0;
+
+    // Ambient sensor on A7, single conversion against AVCC
+    P8SEL0 |= AMBIENT_PIN;
+    P8SEL1 |= AMBIENT_PIN;
+    ADC12CTL0  = ADC12SHT0_2 | ADC12ON;
+    ADC12CTL1  = ADC12SHP;
+    ADC12CTL2  = ADC12RES_2;
+    ADC12MCTL0 = ADC12INCH_7;
+
+    ambientFiltered = readAmbientLight();
+    brightnessLevel = (uint8_t)(ambientFiltered >> 8);
+    setLampBrightness(brightnessLevel);
+}
+
+uint16_t readAmbientLight(void) {
+    ADC12CTL0 |= ADC12ENC | ADC12SC;
+    while (ADC12CTL1 & ADC12BUSY);
+    ADC12CTL0 &= ~ADC12ENC;
+    return ADC12MEM0 & 0x0FFF;
+}
 
-    switch (state_walking[device]) {
-        case STATE_HAND:
-            return 0;  // silent
+void updateBrightness(void) {
+    uint16_t raw = readAmbientLight();
+    uint16_t lower, upper;
 
-        case STATE_WALK:
-            return GAP_WALK_MS;
+    ambientFiltered = (uint16_t)(ambientFiltered -
+                                 (ambientFiltered >> 3) + (raw >> 3));
 
-        case STATE_COUNTDOWN:
-            // Linear interpolation between MAX (counter=9) and MIN (counter=0)
-            // gap = MIN + (MAX - MIN) * counter / 9
-            span = (uint32_t)(GAP_COUNTDOWN_MAX - GAP_COUNTDOWN_MIN);
-            gap = (uint16_t)(GAP_COUNTDOWN_MIN +
-                             (span * walk_counter[device]) / 9U);
-            return gap;
+    // Each level spans 256 counts; move only once past the hysteresis band
+    lower = (uint16_t)brightnessLevel << 8;
+    upper = lower + 255;
 
-        default:
-            return 0;
+    if (ambientFiltered > upper + BRIGHTNESS_HYSTERESIS &&
+        brightnessLevel < BRIGHTNESS_LEVELS - 1) {
+        brightnessLevel++;
+        setLampBrightness(brightnessLevel);
+    }
+    else if (lower >= BRIGHTNESS_HYSTERESIS &&
+             ambientFiltered < lower - BRIGHTNESS_HYSTERESIS &&
+             brightnessLevel > 0) {
+        brightnessLevel--;
+        setLampBrightness(brightnessLevel);
     }
 }
 
-void serviceBuzzers(void) {
-    uint8_t i;
-    uint16_t gap;
+void setLampBrightness(uint8_t level) {
+    uint16_t dutyPct;
 
-    for (i = 0; i < NUM_DEVICES; i++) {
-        gap = buzzerGapForDevice(i);
+    if (level >= BRIGHTNESS_LEVELS) level = BRIGHTNESS_LEVELS - 1;
 
-        // Silent state - turn off and reset
-        if (gap == 0) {
-            setBuzzerPin(i, false);
-            buzzPhaseOn[i] = false;
-            buzzTimerMs[i] = 0;
-            continue;
-        }
+    dutyPct = LAMP_DUTY_MIN_PCT +
+              ((100 - LAMP_DUTY_MIN_PCT) * level) / (BRIGHTNESS_LEVELS - 1);
 
-        // Active state - manage beep on/off cycle
-        if (buzzPhaseOn[i]) {
-            // Currently in pulse - check if pulse duration elapsed
-            if (buzzTimerMs[i] >= BEEP_ON_MS) {
-                setBuzzerPin(i, false);
-                buzzPhaseOn[i] = false;
-                buzzTimerMs[i] = 0;
-            }
-        } else {
-            // Currently in gap - check if gap duration elapsed
-            if (buzzTimerMs[i] >= gap) {
-                setBuzzerPin(i, true);
-                buzzPhaseOn[i] = true;
-                buzzTimerMs[i] = 0;
-            }
-        }
+    if (dutyPct >= 100) {
+        // Hold /OE low - set/reset mode cannot produce a 100% duty cycle
+        TB0CCTL3 = OUTMOD_0;
+    } else {
+        // Set/reset: /OE low from CCR0 rollover until CCR3, high after
+        TB0CCR3  = (uint16_t)((LAMP_PWM_PERIOD * dutyPct) / 100);
+        TB0CCTL3 = OUTMOD_3;
     }
+
+    setMatrixIntensity(level);
+}
+
+void setMatrixIntensity(uint8_t level) {
+    uint8_t data[NUM_DEVICES];
+    int i;
+    for (i = 0; i < NUM_DEVICES; i++) data[i] = level & 0x0F;
+    sendMatrixPacket(0x0A, data);
 }
 
 // ============================================================================
 // INITIALIZATION
 // ============================================================================
+// MCLK 8 MHz straight from the DCO. At the 1 MHz default, four IR
+// receivers in sunlight needed more than the whole CPU for their capture
+// interrupts alone (host/isrlatency.c). SMCLK stays at DCO / 8 = 1 MHz:
+// every timer, capture and the SPI clock count it. FRAM runs without wait
+// states up to 8 MHz.
 void System_init(void) {
-    // 1 MHz default DCO
+    CSCTL0_H = CSKEY_H;
+    CSCTL1   = DCOFSEL_6;                       // 8 MHz (DCORSEL = 0)
+    CSCTL2   = SELA__LFXTCLK | SELS__DCOCLK | SELM__DCOCLK;
+    CSCTL3   = DIVA__1 | DIVS__8 | DIVM__1;
+    CSCTL0_H = 0;
 }
 
 void GPIO_init(void) {
+    P1OUT &= ~FAULT_LAMP_PIN;
+    P1DIR |=  FAULT_LAMP_PIN;
+
     P2DIR |=  (DATA_PIN | SHIFT_CLK_PIN | LATCH_CLK_PIN);
     P2OUT &= ~(DATA_PIN | SHIFT_CLK_PIN | LATCH_CLK_PIN);
 
-    P3DIR &= ~(BTN_PED_NORTH | BTN_PED_WEST);
-    P3REN |=  (BTN_PED_NORTH | BTN_PED_WEST);
-    P3OUT |=  (BTN_PED_NORTH | BTN_PED_WEST);
+    P2DIR &= ~BTN_PED_WEST;
+    P2REN |=  BTN_PED_WEST;
+    P2OUT |=  BTN_PED_WEST;
+
+    P3DIR &= ~BTN_PED_NORTH;
+    P3REN |=  BTN_PED_NORTH;
+    P3OUT |=  BTN_PED_NORTH;
 
     P4DIR &= ~(BTN_PED_SOUTH | BTN_PED_EAST);
     P4REN |=  (BTN_PED_SOUTH | BTN_PED_EAST);
     P4OUT |=  (BTN_PED_SOUTH | BTN_PED_EAST);
 }
 
+// RTC_C in calendar mode from the 32.768kHz LFXT on PJ.4/PJ.5.
+// RTCRDYIE fires once per second as the calendar registers update, which is
+// the second boundary the coordination master time is latched against.
+// RTC_C is reset only by a BOR: after a PUC (watchdog, software reset) it is
+// still running and keeps its time. After a BOR - power up, the RST pin -
+// it is held, and starts from 00:00:00 until set with the clock keys.
+void RTC_init(void) {
+    PJSEL0 |= BIT4 | BIT5;
+
+    CSCTL0_H = CSKEY_H;
+    CSCTL4  &= ~LFXTOFF;
+    do {
+        CSCTL5  &= ~LFXTOFFG;
+        SFRIFG1 &= ~OFIFG;
+    } while (SFRIFG1 & OFIFG);
+    CSCTL0_H = 0;
+
+    RTCCTL0_H = RTCKEY_H;
+    if (RTCCTL13 & RTCHOLD) {
+        RTCCTL13 = RTCHOLD | RTCMODE;
+        RTCHOUR  = 0;
+        RTCMIN   = 0;
+        RTCSEC   = 0;
+    }
+    RTCCTL0_L = RTCRDYIE;
+    RTCCTL13 &= ~RTCHOLD;
+    RTCCTL0_H = 0;
+}
+
+void initSyncPulseInput(void) {
+    P2SEL0 &= ~SYNC_PULSE_PIN;
+    P2SEL1 &= ~SYNC_PULSE_PIN;
+    P2DIR  &= ~SYNC_PULSE_PIN;
+    P2REN  |=  SYNC_PULSE_PIN;
+    P2OUT  &= ~SYNC_PULSE_PIN;      // pull-down, pulse is active high
+    P2IES  &= ~SYNC_PULSE_PIN;      // rising edge
+    P2IFG  &= ~SYNC_PULSE_PIN;
+    P2IE   |=  SYNC_PULSE_PIN;
+}
+
+// Timer_A2: free-running FYA flash on ACLK, independent of the main loop
+void fyaTimerInit(void) {
+    TA2CCR0  = (uint16_t)((FYA_ACLK_HZ * FYA_FLASH_HALF_PERIOD_MS) / 1000 - 1);
+    TA2CCTL0 = CCIE;
+    TA2CTL   = TASSEL__ACLK | MC__UP | TACLR;
+}
+
+// Timer_A3: free-running trap timestamp clock, SMCLK / 8 / 8 = 15625 Hz
+// (64us resolution, wraps every 4.2s)
+void speedTrapInit(void) {
+    P4SEL0 &= ~TRAP_P4_PINS;  P4SEL1 &= ~TRAP_P4_PINS;
+    P4DIR  &= ~TRAP_P4_PINS;  P4REN  |=  TRAP_P4_PINS;
+    P4OUT  |=  TRAP_P4_PINS;  P4IES  |=  TRAP_P4_PINS;
+    P4IFG  &= ~TRAP_P4_PINS;  P4IE   |=  TRAP_P4_PINS;
+
+    P3SEL0 &= ~TRAP_P3_PINS;  P3SEL1 &= ~TRAP_P3_PINS;
+    P3DIR  &= ~TRAP_P3_PINS;  P3REN  |=  TRAP_P3_PINS;
+    P3OUT  |=  TRAP_P3_PINS;  P3IES  |=  TRAP_P3_PINS;
+    P3IFG  &= ~TRAP_P3_PINS;  P3IE   |=  TRAP_P3_PINS;
+
+    TA3EX0 = TAIDEX_7;
+    TA3CTL = TASSEL__SMCLK | ID__8 | MC__CONTINUOUS | TACLR;
+}
+
+// eUSCI_A1 as a 3-pin SPI master at SMCLK (1 MHz), mode 0: the 74HC165
+// shifts on the rising edge, which is also where its previous bit is read
+void detectorChainInit(void) {
+    P2SEL0 &= ~DET_LOAD_PIN;
+    P2SEL1 &= ~DET_LOAD_PIN;
+    P2OUT  |=  DET_LOAD_PIN;
+    P2DIR  |=  DET_LOAD_PIN;
+
+    P3SEL0 |=  (DET_SOMI_PIN | DET_CLK_PIN);
+    P3SEL1 &= ~(DET_SOMI_PIN | DET_CLK_PIN);
+
+    UCA1CTLW0  = UCSWRST;
+    UCA1CTLW0 |= UCMST | UCSYNC | UCMSB | UCCKPH | UCSSEL__SMCLK;
+    UCA1BRW    = 1;
+    UCA1CTLW0 &= ~UCSWRST;
+
+    DMACTL0 = DMA0TSEL__UCA1RXIFG | DMA1TSEL__UCA1TXIFG;
+
+    // DMA0: UCA1RXBUF -> detScanBuf, interrupt at the end of the scan
+    __data16_write_addr((unsigned short)&DMA0SA, (unsigned long)&UCA1RXBUF);
+    __data16_write_addr((unsigned short)&DMA0DA, (unsigned long)detScanBuf);
+    DMA0SZ  = DET_CHAIN_DEVICES;
+    DMA0CTL = DMADT_0 | DMASRCINCR_0 | DMADSTINCR_3 |
+              DMASRCBYTE | DMADSTBYTE | DMAIE;
+
+    // DMA1: dummy bytes -> UCA1TXBUF after the first, one per TXIFG
+    __data16_write_addr((unsigned short)&DMA1SA, (unsigned long)&detDummyTx);
+    __data16_write_addr((unsigned short)&DMA1DA, (unsigned long)&UCA1TXBUF);
+    DMA1SZ  = DET_CHAIN_DEVICES - 1;
+    DMA1CTL = DMADT_0 | DMASRCINCR_0 | DMADSTINCR_0 |
+              DMASRCBYTE | DMADSTBYTE;
+}
+
+// detScanTimer callback. Skipped if the last scan is still running.
+void detScanStart(void *owner, uint8_t id) {
+    (void)owner;
+    (void)id;
+    if (detScanPending || (DMA0CTL & DMAEN)) return;
+    detScanPending = true;
+
+    P2OUT &= ~DET_LOAD_PIN;
+    P2OUT |=  DET_LOAD_PIN;
+
+    DMA0CTL |= DMAEN;
+    DMA1CTL |= DMAEN;
+    UCA1TXBUF = detDummyTx;
+}
+
+// ============================================================================
+// SOFTWARE TIMERS
+// ============================================================================
+void softTimersInit(void) {
+    wheelInit(&wheel, tbMillis(&timebase));
+    timerInit(&detScanTimer, detScanStart, 0, 0);
+    timerInit(&brightnessTimer, brightnessTick, 0, 0);
+    timerInit(&irServiceTimer, irService, 0, 0);
+
+#ifdef DET_CHAIN_FITTED
+    timerStart(&wheel, &detScanTimer, DET_SCAN_PERIOD_MS, DET_SCAN_PERIOD_MS);
+#endif
+    timerStart(&wheel, &brightnessTimer, 1000, 1000);
+    timerStart(&wheel, &irServiceTimer, IR_SERVICE_PERIOD_MS,
+               IR_SERVICE_PERIOD_MS);
+}
+
+void brightnessTick(void *owner, uint8_t id) {
+    (void)owner;
+    (void)id;
+    updateBrightness();
+}
+
 void Timer_init(void) {
-    // Timer_B0: 1ms tick - drives traffic state machine, ped 1s tick, and buzzers
+    // Timer_B0: 1ms tick - tbTick(), which the software timer wheel runs on
+    // CCR0 also sets the lamp PWM period (TB0.3 on /OE, see lampDimmingInit)
     TB0CTL   = TASSEL__SMCLK | MC__UP | ID__8;
     TB0CCR0  = 125;
     TB0CCTL0 = CCIE;
 }
 
 // ============================================================================
-// MODE CONTROL
+// EVENT SERVICE
+// Drains everything the ISRs posted since the last pass into the
+// controller. Runs at the top of the main loop, right after the timer wheel.
 // ============================================================================
-OperatingMode checkModeButtons(volatile uint32_t *result) {
-    for (int i = 0; i < NUM_CHANNELS; i++) {
-        if (result[i] == IR_BackButton) return MODE_EMERGENCY;
+void serviceEvents(void) {
+    Event ev;
+
+    while (evqPop(&evq, &ev)) {
+        switch (ev.type) {
+            case EV_LEFT_ARRIVAL:
+                ctlLeftArrival(&intersection, (LeftBay)ev.arg);
+                break;
+            case EV_SYNC_PULSE:
+                ctlSyncPulse(&intersection, ev.tick);
+                break;
+            case EV_RTC_SECOND:
+                rtcSecondTick = ev.tick;
+                rtcSecondFlag = true;
+                break;
+            case EV_FYA_FLASH:
+                ctlFyaFlash(&intersection, ev.arg != 0);
+                break;
+            case EV_TRAP_EDGE:
+                ctlTrapEdge(&intersection, (Approach)(ev.arg / 2),
+                            ev.arg % 2, ev.data);
+                break;
+            case EV_DET_SCAN:
+                ctlDetectorScan(&intersection, detScanBuf);
+                detScanPending = false;
+                break;
+            default:
+                break;
+        }
     }
+}
 
-    OperatingMode newMode = currentMode;
-    for (int i = 0; i < NUM_CHANNELS; i++) {
-        if (result[i] == IR_UpArrow)         newMode = MODE_DAYTIME;
-        else if (result[i] == IR_DownArrow)  newMode = MODE_NIGHT;
-        else if (result[i] == IR_FastFoward) newMode = MODE_HIGH_TRAFFIC;
+// ============================================================================
+// RTC SERVICE
+// RTC registers are read only while RTCRDY is set, so a read never straddles
+// an RTC update. The controller derives coordination master time and the
+// time-of-day left-turn mode from it.
+//
+// The RTC has no backup supply, so it is set from an IR remote: each press
+// of the clock-hour key steps the hour, and each press of the clock-minute
+// key steps the minute and restarts the seconds, so a press on the minute
+// sets them too. Neither carries into the next field. The calendar is held
+// while it is written; the new time reaches the controller at the next
+// second.
+// ============================================================================
+void serviceRtc(void) {
+    uint32_t msOfDay;
+
+    if (!rtcSecondFlag || !(RTCCTL13 & RTCRDY)) return;
+
+    rtcSecondFlag = false;
+    msOfDay = ((uint32_t)RTCHOUR * 3600UL +
+               (uint32_t)RTCMIN  * 60UL +
+               (uint32_t)RTCSEC) * 1000UL;
+    ctlRtcSecond(&intersection, msOfDay, rtcSecondTick);
+}
+
+// ============================================================================
+// IR COMMANDS
+// Transit calls are checked first (transit_priority.h); any other frame goes
+// through the command map and is dispatched for the receiver's approach.
+// The frames of a key still held (irKeyHeld), NEC repeats included, do not
+// act again - except that a held preemption key keeps re-issuing its call,
+// as an emitter's stream of frames would, until it is released.
+// ============================================================================
+void irActDaytime(uint8_t channel) {
+    ctlCommand(&intersection, CMD_MODE_DAYTIME, irApproach[channel]);
+}
+
+void irActNight(uint8_t channel) {
+    ctlCommand(&intersection, CMD_MODE_NIGHT, irApproach[channel]);
+}
+
+void irActHighTraffic(uint8_t channel) {
+    ctlCommand(&intersection, CMD_MODE_HIGH_TRAFFIC, irApproach[channel]);
+}
+
+void irActPreempt(uint8_t channel) {
+    ctlCommand(&intersection, CMD_PREEMPT, irApproach[channel]);
+}
+
+void irActCoordToggle(uint8_t channel) {
+    ctlCommand(&intersection, CMD_COORD_TOGGLE, irApproach[channel]);
+}
+
+void irActClockHour(uint8_t channel) {
+    (void)channel;
+    RTCCTL0_H = RTCKEY_H;
+    RTCCTL13 |= RTCHOLD;
+    RTCHOUR   = (uint8_t)((RTCHOUR + 1) % 24);
+    RTCCTL13 &= ~RTCHOLD;
+    RTCCTL0_H = 0;
+}
+
+void irActClockMinute(uint8_t channel) {
+    (void)channel;
+    RTCCTL0_H = RTCKEY_H;
+    RTCCTL13 |= RTCHOLD;
+    RTCMIN    = (uint8_t)((RTCMIN + 1) % 60);
+    RTCSEC    = 0;
+    RTCCTL13 &= ~RTCHOLD;
+    RTCCTL0_H = 0;
+}
+
+void handleIrFrame(uint8_t channel) {
+    IrFrame frame;
+    IrAction action;
+    Approach transitApproach;
+    uint32_t now = tbMillis(&timebase);
+
+    if (!irTakeFrame(&ir[channel], &frame)) return;
+    if (irKeyHeld(&irHeld[channel], &frame, now)) {
+        if (irHeld[channel].action == IR_ACT_PREEMPT) irActPreempt(channel);
+        return;
     }
-    return newMode;
-}
-
-void handleModeChange(OperatingMode newMode) {
-    if (newMode == MODE_EMERGENCY) {
-        if (!inEmergency) {
-            savedState   = currentState;
-            savedMode    = currentMode;
-            inEmergency  = true;
-            currentMode  = MODE_EMERGENCY;
-            currentState = STATE_EMERGENCY_ALL_RED;
-            stateTimer   = getStateDuration(STATE_EMERGENCY_ALL_RED);
-            stateExpired = false;
-        }
+    if (frame.protocol == IR_NEC_REPEAT) return;    // nothing held
+
+    if (frame.protocol == IR_NEC &&
+        tspDecodeCall(frame.code, &transitApproach)) {
+        ctlTransitCall(&intersection, transitApproach);
         return;
     }
 
-    inEmergency  = false;
-    currentMode  = newMode;
+    action = irMapHandle(&irMap, &irLearn, &frame, now);
+    irHeld[channel].action = (uint8_t)action;
+    if (irActions[action]) irActions[action](channel);
+}
+
+// ============================================================================
+// BOARD BINDINGS
+// ============================================================================
+void boardShowSignals(void *board, const LEDState *leds) {
+    (void)board;
+    shiftOut32bits(leds->byte);
+}
+
+void boardShowPeds(void *board, const uint8_t image[NUM_DEVICES]) {
+    (void)board;
+    sendMatrixImage(image);
+}
 
-    switch (newMode) {
-        case MODE_DAYTIME:      currentState = STATE_NS_GREEN;         break;
-        case MODE_HIGH_TRAFFIC: currentState = STATE_N_PRIORITY_START; break;
-        case MODE_NIGHT:        currentState = STATE_NIGHT_FLASH_ON;   break;
-        default: break;
+// Hall sensors are active LOW
+bool boardBayOccupied(void *board, LeftBay bay) {
+    (void)board;
+    return !(P2IN & bayPin[bay]);
+}
+
+// A chattering bay's interrupt is masked until its retry; re-arming clears
+// any edge that latched while it was masked
+void boardMaskBay(void *board, LeftBay bay, bool masked) {
+    (void)board;
+    if (masked) {
+        P2IE &= ~bayPin[bay];
+    } else {
+        P2IFG &= ~bayPin[bay];
+        P2IE  |=  bayPin[bay];
     }
+}
+
+// Set by the ISR, cleared here; the bay stays masked in between, so the
+// ISR cannot set it again before it is read
+bool boardBayChattered(void *board, LeftBay bay) {
+    (void)board;
+    if (!bayChatter[bay]) return false;
+    bayChatter[bay] = false;
+    return true;
+}
 
-    stateTimer   = getStateDuration(currentState);
-    stateExpired = false;
+void boardSetFaultLamp(void *board, bool on) {
+    (void)board;
+    if (on) P1OUT |=  FAULT_LAMP_PIN;
+    else    P1OUT &= ~FAULT_LAMP_PIN;
 }
 
 // ============================================================================
@@ -762,7 +979,7 @@ void matrixShiftOut(uint8_t bitOrder, uint16_t value) {
     }
 }
 
-void sendMatrixPacket(uint8_t address, uint8_t data[NUM_DEVICES]) {
+void sendMatrixPacket(uint8_t address, const uint8_t data[NUM_DEVICES]) {
     int i;
     matrixLatchLow();
     for (i = NUM_DEVICES - 1; i >= 0; i--) {
@@ -784,14 +1001,14 @@ void ledMatrixInit(void) {
     for (i = 0; i < NUM_DEVICES; i++) data[i] = 0x07;
     sendMatrixPacket(0x0B, data);
 
-    for (i = 0; i < NUM_DEVICES; i++) data[i] = 0x0F;
+    for (i = 0; i < NUM_DEVICES; i++) data[i] = MATRIX_INTENSITY_DEFAULT;
     sendMatrixPacket(0x0A, data);
 
     for (i = 0; i < NUM_DEVICES; i++) data[i] = 0x01;
     sendMatrixPacket(0x0C, data);
 }
 
-void sendMatrixImage(uint8_t digits[NUM_DEVICES]) {
+void sendMatrixImage(const uint8_t digits[NUM_DEVICES]) {
     uint8_t row, i;
     uint8_t row_data[NUM_DEVICES];
     for (row = 0; row < 8; row++) {
@@ -805,7 +1022,7 @@ void sendMatrixImage(uint8_t digits[NUM_DEVICES]) {
 // ============================================================================
 // SHIFT REGISTER CONTROL
 // ============================================================================
-void shiftOut32bits(uint8_t *data) {
+void shiftOut32bits(const uint8_t *data) {
     int16_t byte_idx, bit_idx;
 
     P2OUT &= ~LATCH_CLK_PIN;
@@ -830,38 +1047,47 @@ void shiftOut32bits(uint8_t *data) {
 // ============================================================================
 // IR RECEIVER HELPERS
 // ============================================================================
-uint32_t decodeNEC(volatile uint16_t *buffer) {
-    uint32_t value = 0;
-    int index = 2;
-    for (int bit = 0; bit < 32; bit++) {
-        uint16_t space = buffer[index + 1];
-        if (space > 1500) value |= (1UL << bit);
-        index += 2;
+// Interrupt context - the capture ISR's top half. The receiver masks itself
+// once it has used its edge budget; the count is queued for pollIr(), with
+// COV if an edge was lost before this one.
+void handleCapture(uint8_t channel, uint32_t capture) {
+    bool overflow = (*irCctl[channel] & COV) != 0;
+
+    if (++irEdges[channel] >= IR_EDGE_BUDGET) {
+        *irCctl[channel] &= ~CCIE;
     }
-    return value;
+    if (overflow) *irCctl[channel] &= ~COV;
+    irQueue(&ir[channel], capture, overflow);
 }
 
-void handleCapture(IR_Channel *ch, uint16_t currentcapture) {
-    uint16_t duration = currentcapture - ch->lastCapture;
-    ch->lastCapture = currentcapture;
-
-    if (duration > LowerLeader && duration < UpperLeader) {
-        ch->leaderDetected = 1;
-        ch->captureIndex = 0;
+// Main loop - decodes every edge the capture ISRs queued and acts on each
+// frame as it completes
+void pollIrChannel(uint8_t channel) {
+    while (irPoll(&ir[channel])) {
+        handleIrFrame(channel);
     }
+}
 
-    if (ch->leaderDetected) {
-        if (ch->captureIndex < CaptureBufferSize) {
-            ch->buffer[ch->captureIndex++] = duration;
-        }
-        if (ch->captureIndex == totalTimings) {
-            ch->frameComplete = 1;
-            ch->captureIndex = 0;
-            ch->leaderDetected = 0;
-        }
+void pollIr(void) {
+    uint8_t channel;
+
+    for (channel = 0; channel < NUM_CHANNELS; channel++) {
+#ifdef IR_CAPTURE_DMA
+        if (channel == IR_DMA_CHANNEL) continue;
+#endif
+        pollIrChannel(channel);
     }
 }
 
+// Interrupt context. TAIFG is the lowest priority of a timer's interrupts,
+// so an overflow may still be pending, uncounted, when a capture is handled;
+// a count in the low half of the period was then latched after it. Valid
+// for captures handled within half a period (32 ms) of the edge.
+uint32_t extendCapture(uint16_t overflows, uint16_t timerCtl, uint16_t count) {
+    if ((timerCtl & TAIFG) && count < 0x8000) overflows++;
+    return (uint32_t)overflows << 16 | count;
+}
+
 void initTimerA0Capture(void) {
     Timer_A_initCaptureModeParam capture = {0};
     capture.captureMode = TIMER_A_CAPTUREMODE_RISING_AND_FALLING_EDGE;
@@ -871,7 +1097,13 @@ void initTimerA0Capture(void) {
     capture.captureOutputMode = TIMER_A_OUTPUTMODE_OUTBITVALUE;
 
     capture.captureRegister = TIMER_A_CAPTURECOMPARE_REGISTER_0;
+#ifdef IR_CAPTURE_DMA
+    capture.captureInterruptEnable = TIMER_A_CAPTURECOMPARE_INTERRUPT_DISABLE;
     Timer_A_initCaptureMode(TIMER_A0_BASE, &capture);
+    capture.captureInterruptEnable = TIMER_A_CAPTURECOMPARE_INTERRUPT_ENABLE;
+#else
+    Timer_A_initCaptureMode(TIMER_A0_BASE, &capture);
+#endif
     capture.captureRegister = TIMER_A_CAPTURECOMPARE_REGISTER_1;
     Timer_A_initCaptureMode(TIMER_A0_BASE, &capture);
     capture.captureRegister = TIMER_A_CAPTURECOMPARE_REGISTER_2;
@@ -893,7 +1125,7 @@ void initTimerAContinuousMode(void) {
     Timer_A_initContinuousModeParam continuousmode = {0};
     continuousmode.clockSource = TIMER_A_CLOCKSOURCE_SMCLK;
     continuousmode.clockSourceDivider = TIMER_A_CLOCKSOURCE_DIVIDER_1;
-    continuousmode.timerInterruptEnable_TAIE = TIMER_A_TAIE_INTERRUPT_DISABLE;
+    continuousmode.timerInterruptEnable_TAIE = TIMER_A_TAIE_INTERRUPT_ENABLE;
     continuousmode.timerClear = TIMER_A_DO_CLEAR;
     continuousmode.startTimer = true;
 
@@ -910,17 +1142,18 @@ void initPins(void) {
 
 void InitIRChannels(void) {
     for (int i = 0; i < NUM_CHANNELS; i++) {
-        ir[i].lastCapture = 0;
-        ir[i].frameComplete = 0;
-        ir[i].captureIndex = 0;
-        ir[i].leaderDetected = 0;
-        result[i] = 0;
+        irInit(&ir[i]);
     }
+    irMapInit(&irMap, irMapDefaults, NUM_IR_DEFAULTS);
 }
 
 void TimerEnableCCRI(void) {
+#ifdef IR_CAPTURE_DMA
+    irDmaInit();
+#else
     Timer_A_enableCaptureCompareInterrupt(TIMER_A0_BASE,
         TIMER_A_CAPTURECOMPARE_REGISTER_0);
+#endif
     Timer_A_enableCaptureCompareInterrupt(TIMER_A0_BASE,
         TIMER_A_CAPTURECOMPARE_REGISTER_1);
     Timer_A_enableCaptureCompareInterrupt(TIMER_A0_BASE,
@@ -929,6 +1162,56 @@ void TimerEnableCCRI(void) {
         TIMER_A_CAPTURECOMPARE_REGISTER_1);
 }
 
+#ifdef IR_CAPTURE_DMA
+// DMA2: TA0CCR0 -> irDmaRing on every capture, round and round. Repeated
+// single transfer reloads the size and destination at the end of the ring,
+// and the DMA's read of TA0CCR0 clears its CCIFG for the next edge. No DMA
+// interrupt - the main loop finds the write position from DMA2SZ.
+void irDmaInit(void) {
+    DMACTL1 = DMA2TSEL__TA0CCR0;
+    __data16_write_addr((unsigned short)&DMA2SA, (unsigned long)&TA0CCR0);
+    __data16_write_addr((unsigned short)&DMA2DA, (unsigned long)irDmaRing);
+    DMA2SZ  = IR_DMA_RING;
+    DMA2CTL = DMADT_4 | DMASRCINCR_0 | DMADSTINCR_3 | DMAEN;
+}
+#endif
+
+// irServiceTimer callback. Starts each receiver's next edge budget,
+// unmasking the ones that ran out once what they queued is decoded, and
+// drains the DMA ring.
+void irService(void *owner, uint8_t id) {
+    uint8_t channel;
+    (void)owner;
+    (void)id;
+
+    for (channel = 0; channel < NUM_CHANNELS; channel++) {
+#ifdef IR_CAPTURE_DMA
+        if (channel == IR_DMA_CHANNEL) continue;
+#endif
+        irEdges[channel] = 0;
+        if (!(*irCctl[channel] & CCIE)) {
+            pollIrChannel(channel);
+            irAbort(&ir[channel]);
+            *irCctl[channel] &= ~(CCIFG | COV);
+            *irCctl[channel] |= CCIE;
+        }
+    }
+
+#ifdef IR_CAPTURE_DMA
+    // SZ counts down from IR_DMA_RING to 1, then reloads. Every count in
+    // the ring is from the last period or so, well within a timer period.
+    while (irDrain(&ir[IR_DMA_CHANNEL], irDmaRing, IR_DMA_RING, &irDmaTail,
+                   (uint8_t)(IR_DMA_RING - DMA2SZ),
+                   (uint32_t)tbCycles(&timebase))) {
+        handleIrFrame(IR_DMA_CHANNEL);
+    }
+    if (TA0CCTL0 & COV) {
+        TA0CCTL0 &= ~COV;
+        irOverflow(&ir[IR_DMA_CHANNEL]);
+    }
+#endif
+}
+
 void initLeftTurnSensors(void) {
     P2SEL0 &= ~(NORTH_LEFT_PIN | SOUTH_LEFT_PIN);
     P2SEL1 &= ~(NORTH_LEFT_PIN | SOUTH_LEFT_PIN);
@@ -942,87 +1225,180 @@ void initLeftTurnSensors(void) {
 
 // ============================================================================
 // INTERRUPT SERVICE ROUTINES
+// Every ISR is a top half: it takes the time its event happened, hands it
+// to the main loop (evq, or an IR channel's edge queue) and returns. The
+// work behind it - IR decoding, detector logic, the controller - runs in
+// the main loop, which Timer_B0 wakes every 1 ms.
+//
+// Priority is the fixed vector order, highest first:
+//
+//   Timer_B0   1 ms tick                       tbTick()
+//   TA0 CCR0   ir[0] capture                   count -> edge queue
+//   TA0 IV     ir[1], ir[2] capture, overflow  count -> edge queue, TAIFG
+//   DMA        detector scan complete          evq
+//   TA1 IV     ir[3] capture, overflow         count -> edge queue, TAIFG
+//   TA2 CCR0   FYA flash cadence               evq
+//   Port 2     bay Hall edges, sync pulse      evq, chatter mask
+//   Port 3/4   speed traps                     TA3R -> evq
+//   RTC        second boundary                 evq
+//
+// IR edges are timed by the capture hardware and trap edges by the TA3R
+// read that opens their ISR, so latency only reaches a timestamp through
+// the ISRs that run before it - for a trap edge, all of them. Each handler
+// is therefore kept to tens of cycles; host/isrlatency.c models the
+// latency of every source under combined load.
+//
+// No ISR re-enables GIE. evq and the IR edge queues have one producer only
+// because ISRs do not nest, and so do bayEdge()'s burst counts and the IR
+// edge budgets; and nesting is not by priority - once GIE is set, any
+// enabled interrupt preempts, lower ones included. An ISR may set GIE only
+// once it is done with everything it shares with other ISRs and has masked
+// its own source. With every handler a top half, none needs to.
 // ============================================================================
 #pragma vector = TIMER0_A0_VECTOR
 __interrupt void TIMER0_A0_CCR0_ISR(void) {
-    uint16_t currentcapture =
-        Timer_A_getCaptureCompareCount(TIMER_A0_BASE,
-                                       TIMER_A_CAPTURECOMPARE_REGISTER_0);
-    handleCapture(&ir[0], currentcapture);
+    uint16_t count = TA0CCR0;
+
+    handleCapture(0, extendCapture(timebase.overflowLow, TA0CTL, count));
 }
 
 #pragma vector = TIMER0_A1_VECTOR
 __interrupt void TIMER0_A1_ISR(void) {
-    switch (__even_in_range(TA0IV, 4)) {
-        case 2: {
-            uint16_t currentcapture =
-                Timer_A_getCaptureCompareCount(TIMER_A0_BASE,
-                                               TIMER_A_CAPTURECOMPARE_REGISTER_1);
-            handleCapture(&ir[1], currentcapture);
+    switch (__even_in_range(TA0IV, TA0IV_TAIFG)) {
+        case 2:
+            handleCapture(1, extendCapture(timebase.overflowLow, TA0CTL,
+                                           TA0CCR1));
             break;
-        }
-        case 4: {
-            uint16_t currentcapture =
-                Timer_A_getCaptureCompareCount(TIMER_A0_BASE,
-                                               TIMER_A_CAPTURECOMPARE_REGISTER_2);
-            handleCapture(&ir[2], currentcapture);
+        case 4:
+            handleCapture(2, extendCapture(timebase.overflowLow, TA0CTL,
+                                           TA0CCR2));
+            break;
+        case TA0IV_TAIFG:
+            tbOverflow(&timebase);
             break;
-        }
     }
 }
 
 #pragma vector = TIMER1_A1_VECTOR
 __interrupt void TIMER1_A1_ISR(void) {
-    switch (__even_in_range(TA1IV, 2)) {
-        case 2: {
-            uint16_t current =
-                Timer_A_getCaptureCompareCount(TIMER_A1_BASE,
-                    TIMER_A_CAPTURECOMPARE_REGISTER_1);
-            handleCapture(&ir[3], current);
+    switch (__even_in_range(TA1IV, TA1IV_TAIFG)) {
+        case 2:
+            handleCapture(3, extendCapture(ta1Overflows, TA1CTL, TA1CCR1));
+            break;
+        case TA1IV_TAIFG:
+            ta1Overflows++;
             break;
-        }
     }
 }
 
-// Timer_B0 - 1ms tick (traffic + 1s pedestrian + buzzer timing)
+// Timer_B0 - 1ms tick. Every software timer hangs off tbMillis(); the main
+// loop runs them from the timer wheel.
 #pragma vector=TIMER0_B0_VECTOR
 __interrupt void Timer_B0_ISR(void) {
-    uint8_t i;
-    systemTick++;
+    tbTick(&timebase);
 
-    // Increment buzzer timers every 1ms - used by serviceBuzzers()
-    for (i = 0; i < NUM_DEVICES; i++) {
-        buzzTimerMs[i]++;
-    }
+    // Always wake CPU so main loop can advance the wheel every 1ms
+    __bic_SR_register_on_exit(LPM0_bits);
+}
+
+// Timer_A2 - flashing yellow arrow cadence
+#pragma vector=TIMER2_A0_VECTOR
+__interrupt void Timer_A2_ISR(void) {
+    static bool on = false;
+
+    on = !on;
+    evqPush(&evq, EV_FYA_FLASH, on, 0, tbMillis(&timebase));
+    __bic_SR_register_on_exit(LPM0_bits);
+}
+
+// Called from the port ISRs with Timer_A3 read on entry
+static void trapEdge(Approach approach, uint8_t detector, uint16_t capture) {
+    evqPush(&evq, EV_TRAP_EDGE, (uint8_t)(approach * 2 + detector), capture,
+            tbMillis(&timebase));
+}
+
+#pragma vector=PORT3_VECTOR
+__interrupt void Port_3_ISR(void) {
+    uint16_t capture = TA3R;
+    uint8_t flags = P3IFG & TRAP_P3_PINS;
+
+    P3IFG &= ~flags;
+    if (flags & TRAP_E_UP)   trapEdge(APPROACH_EAST, TRAP_UP, capture);
+    if (flags & TRAP_E_DOWN) trapEdge(APPROACH_EAST, TRAP_DOWN, capture);
+    if (flags & TRAP_W_UP)   trapEdge(APPROACH_WEST, TRAP_UP, capture);
+    if (flags & TRAP_W_DOWN) trapEdge(APPROACH_WEST, TRAP_DOWN, capture);
+}
+
+#pragma vector=PORT4_VECTOR
+__interrupt void Port_4_ISR(void) {
+    uint16_t capture = TA3R;
+    uint8_t flags = P4IFG & TRAP_P4_PINS;
 
-    // 1-second tick for pedestrian state machine
-    msCount++;
-    if (msCount >= 1000) {
-        msCount = 0;
-        tick_1s = 1;
+    P4IFG &= ~flags;
+    if (flags & TRAP_N_UP)   trapEdge(APPROACH_NORTH, TRAP_UP, capture);
+    if (flags & TRAP_N_DOWN) trapEdge(APPROACH_NORTH, TRAP_DOWN, capture);
+    if (flags & TRAP_S_UP)   trapEdge(APPROACH_SOUTH, TRAP_UP, capture);
+    if (flags & TRAP_S_DOWN) trapEdge(APPROACH_SOUTH, TRAP_DOWN, capture);
+}
+
+// DMA0 - detector chain scan complete
+#pragma vector=DMA_VECTOR
+__interrupt void DMA_ISR(void) {
+    switch (__even_in_range(DMAIV, DMAIV_DMA2IFG)) {
+        case DMAIV_DMA0IFG:
+            evqPush(&evq, EV_DET_SCAN, 0, 0, tbMillis(&timebase));
+            break;
+        default:
+            break;
     }
+}
 
-    // Traffic state timer
-    if (stateTimer > 0) {
-        stateTimer--;
-        if (stateTimer == 0) {
-            stateExpired = true;
-        }
+// Posts a Hall edge, masking the bay once DET_CHATTER_EDGES arrive within
+// one DET_HEALTH_PERIOD_MS (chattering - see controller.c). The window is
+// this ISR's own, so the controller is told through bayChatter[] rather
+// than left to find the burst in its own count.
+static void bayEdge(LeftBay bay) {
+    static uint32_t burstStart[NUM_LEFT_BAYS];
+    static uint8_t  burst[NUM_LEFT_BAYS];
+    uint32_t now = tbMillis(&timebase);
+
+    if (now - burstStart[bay] >= DET_HEALTH_PERIOD_MS) {
+        burstStart[bay] = now;
+        burst[bay]      = 0;
+    }
+    if (++burst[bay] >= DET_CHATTER_EDGES) {
+        P2IE &= ~bayPin[bay];
+        bayChatter[bay] = true;
+        burst[bay]      = 0;
     }
 
-    // Always wake CPU so main loop can service buzzers every 1ms
-    __bic_SR_register_on_exit(LPM0_bits);
+    evqPush(&evq, EV_LEFT_ARRIVAL, bay, 0, now);
 }
 
 #pragma vector=PORT2_VECTOR
 __interrupt void Port_2_ISR(void) {
     if (P2IFG & NORTH_LEFT_PIN) {
-        northLeftDemand = true;
+        bayEdge(BAY_NORTH_LEFT);
         P2IFG &= ~NORTH_LEFT_PIN;
     }
     if (P2IFG & SOUTH_LEFT_PIN) {
-        southLeftDemand = true;
+        bayEdge(BAY_SOUTH_LEFT);
         P2IFG &= ~SOUTH_LEFT_PIN;
     }
+    if (P2IFG & SYNC_PULSE_PIN) {
+        evqPush(&evq, EV_SYNC_PULSE, 0, 0, tbMillis(&timebase));
+        P2IFG &= ~SYNC_PULSE_PIN;
+    }
     P2IFG &= ~(NORTH_LEFT_PIN | SOUTH_LEFT_PIN);
 }
+
+#pragma vector=RTC_VECTOR
+__interrupt void RTC_ISR(void) {
+    switch (__even_in_range(RTCIV, RTCIV__RT1PSIFG)) {
+        case RTCIV__RTCRDYIFG:
+            evqPush(&evq, EV_RTC_SECOND, 0, 0, tbMillis(&timebase));
+            break;
+        default:
+            break;
+    }
+}
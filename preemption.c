@@ -0,0 +1,112 @@
+#include "preemption.h"
+
+/* ============================================================================
+ * STATE CLASSIFICATION
+ * ========================================================================= */
+
+static TrafficState trackGreenFor(Approach approach) {
+    switch (approach) {
+        case APPROACH_NORTH: return STATE_PREEMPT_N_GREEN;
+        case APPROACH_SOUTH: return STATE_PREEMPT_S_GREEN;
+        case APPROACH_EAST:  return STATE_PREEMPT_E_GREEN;
+        default:             return STATE_PREEMPT_W_GREEN;
+    }
+}
+
+static TrafficState exitYellowFor(Approach approach) {
+    switch (approach) {
+        case APPROACH_NORTH: return STATE_PREEMPT_N_YELLOW;
+        case APPROACH_SOUTH: return STATE_PREEMPT_S_YELLOW;
+        case APPROACH_EAST:  return STATE_PREEMPT_E_YELLOW;
+        default:             return STATE_PREEMPT_W_YELLOW;
+    }
+}
+
+/* State the controller resumes in; the phase engine is restarted at
+ * preemptExitBarrier() */
+static TrafficState exitStateFor(OperatingMode mode) {
+    if (mode == MODE_NIGHT) {
+        return STATE_NIGHT_FLASH_ON;
+    }
+    return STATE_PHASE_ENGINE;
+}
+
+/* ============================================================================
+ * PUBLIC API
+ * ========================================================================= */
+
+void preemptInit(PreemptState *pre) {
+    pre->phase      = PREEMPT_IDLE;
+    pre->approach   = APPROACH_NORTH;
+    pre->returnMode = MODE_DAYTIME;
+    pre->callAgeMs  = 0;
+}
+
+bool preemptActive(const PreemptState *pre) {
+    return pre->phase != PREEMPT_IDLE;
+}
+
+/* Registers a call frame. Returns true only when a new preemption starts,
+ * with *entryState set to the state the controller must switch to now.
+ * STATE_PHASE_ENGINE means stay there and force the engine off; the
+ * sequence continues once the engine is idle. */
+bool preemptCall(PreemptState *pre, Approach approach,
+                 OperatingMode mode, TrafficState current,
+                 TrafficState *entryState) {
+    if (pre->phase != PREEMPT_IDLE) {
+        if (approach == pre->approach) pre->callAgeMs = 0;
+        return false;
+    }
+
+    pre->phase      = PREEMPT_CLEARING;
+    pre->approach   = approach;
+    pre->returnMode = mode;
+    pre->callAgeMs  = 0;
+
+    if (current == STATE_NIGHT_FLASH_ON || current == STATE_NIGHT_FLASH_OFF ||
+        current == STATE_NIGHT_TRANSITION) {
+        *entryState = STATE_EMERGENCY_ALL_RED;
+    } else {
+        *entryState = current;
+    }
+    return true;
+}
+
+/* Ages the active call; called from the main loop's 1s tick */
+void preemptService(PreemptState *pre, uint32_t elapsedMs) {
+    if (pre->phase != PREEMPT_IDLE && pre->callAgeMs < PREEMPT_CALL_DROP_MS) {
+        pre->callAgeMs += elapsedMs;
+    }
+}
+
+/* Replaces getNextState while preemption is active. Returning `current`
+ * during TRACK GREEN means keep holding. When the sequence completes the
+ * engine returns to IDLE and the caller restores pre->returnMode. */
+TrafficState preemptNextState(PreemptState *pre, TrafficState current) {
+    switch (pre->phase) {
+        case PREEMPT_CLEARING:
+            pre->phase = PREEMPT_TRACK_GREEN;
+            return trackGreenFor(pre->approach);
+
+        case PREEMPT_TRACK_GREEN:
+            if (pre->callAgeMs < PREEMPT_CALL_DROP_MS) return current;
+            pre->phase = PREEMPT_EXITING;
+            return exitYellowFor(pre->approach);
+
+        case PREEMPT_EXITING:
+            if (current != STATE_PREEMPT_EXIT_ALL_RED) {
+                return STATE_PREEMPT_EXIT_ALL_RED;
+            }
+            pre->phase = PREEMPT_IDLE;
+            return exitStateFor(pre->returnMode);
+
+        default:
+            return current;
+    }
+}
+
+/* Barrier the plan resumes at: E/W after a N/S preemption and vice versa */
+uint8_t preemptExitBarrier(const PreemptState *pre) {
+    return (pre->approach == APPROACH_NORTH ||
+            pre->approach == APPROACH_SOUTH) ? 1 : 0;
+}
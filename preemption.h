@@ -0,0 +1,53 @@
+#ifndef PREEMPTION_H
+#define PREEMPTION_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "traffic_states.h"
+
+/* ============================================================================
+ * EMERGENCY VEHICLE PREEMPTION
+ *
+ * A call carries the approach of the IR receiver that saw it. The engine
+ * walks a fixed sequence instead of freezing the plan mid-phase:
+ *
+ *   CLEARING     every running green is cut to its yellow (the phase engine
+ *                is forced off by main.c); yellows and red clearances
+ *                already in progress time out normally
+ *   TRACK GREEN  every movement on the calling approach is green, held for
+ *                TIME_PREEMPT_MIN_GREEN and then for as long as call frames
+ *                keep arriving (a gap of PREEMPT_CALL_DROP_MS drops it)
+ *   EXITING      approach yellow -> exit all-red -> the plan's exit phase
+ *
+ * On exit the return mode's plan restarts at the barrier that does not
+ * contain the preempted approach, so the approaches that waited are served
+ * first.
+ * Calls from other approaches are ignored until the sequence completes.
+ * ========================================================================= */
+
+#define PREEMPT_CALL_DROP_MS    3000
+
+typedef enum {
+    PREEMPT_IDLE = 0,
+    PREEMPT_CLEARING,
+    PREEMPT_TRACK_GREEN,
+    PREEMPT_EXITING
+} PreemptPhase;
+
+typedef struct {
+    PreemptPhase  phase;
+    Approach      approach;
+    OperatingMode returnMode;
+    uint32_t      callAgeMs;
+} PreemptState;
+
+void         preemptInit(PreemptState *pre);
+bool         preemptActive(const PreemptState *pre);
+bool         preemptCall(PreemptState *pre, Approach approach,
+                         OperatingMode mode, TrafficState current,
+                         TrafficState *entryState);
+void         preemptService(PreemptState *pre, uint32_t elapsedMs);
+TrafficState preemptNextState(PreemptState *pre, TrafficState current);
+uint8_t      preemptExitBarrier(const PreemptState *pre);
+
+#endif /* PREEMPTION_H */
@@ -0,0 +1,62 @@
+#include "queue_model.h"
+
+void queueInit(BayQueue *bay) {
+    bay->queue        = 0;
+    bay->greenElapsed = 0;
+    bay->greenActive  = false;
+}
+
+void queueArrival(BayQueue *bay, uint16_t count) {
+    bay->queue += (uint32_t)count * QUEUE_SCALE;
+}
+
+/* Called on every state change; a rising edge restarts the lost-time clock */
+void queueSetGreen(BayQueue *bay, bool green) {
+    if (green && !bay->greenActive) bay->greenElapsed = 0;
+    bay->greenActive = green;
+}
+
+/* Discharges the queue for `elapsedMs` of time just past */
+void queueUpdate(BayQueue *bay, uint32_t elapsedMs) {
+    uint32_t start, end, discharging, discharged;
+
+    if (!bay->greenActive) return;
+
+    start = bay->greenElapsed;
+    end   = start + elapsedMs;
+    bay->greenElapsed = end;
+
+    if (end <= QUEUE_STARTUP_LOST_MS) return;
+    if (start < QUEUE_STARTUP_LOST_MS) start = QUEUE_STARTUP_LOST_MS;
+
+    discharging = end - start;
+    discharged  = (discharging * QUEUE_SCALE) / QUEUE_SAT_HEADWAY_MS;
+
+    bay->queue = (bay->queue > discharged) ? bay->queue - discharged : 0;
+}
+
+/* Whole vehicles, rounded up - a partial vehicle still needs a headway */
+uint16_t queueVehicles(const BayQueue *bay) {
+    return (uint16_t)((bay->queue + QUEUE_SCALE - 1) / QUEUE_SCALE);
+}
+
+uint32_t queueGreenTime(const BayQueue *bay) {
+    uint32_t green = QUEUE_STARTUP_LOST_MS +
+                     (uint32_t)queueVehicles(bay) * QUEUE_SAT_HEADWAY_MS;
+
+    if (green < QUEUE_LEFT_MIN_GREEN) green = QUEUE_LEFT_MIN_GREEN;
+    if (green > QUEUE_LEFT_MAX_GREEN) green = QUEUE_LEFT_MAX_GREEN;
+    return green;
+}
+
+bool queueSpillbackImminent(const BayQueue *bay) {
+    return bay->queue >=
+           (uint32_t)(QUEUE_BAY_STORAGE - QUEUE_SPILLBACK_MARGIN) * QUEUE_SCALE;
+}
+
+/* Green, past its minimum, and nothing left to discharge */
+bool queueGappedOut(const BayQueue *bay) {
+    return bay->greenActive &&
+           bay->greenElapsed >= QUEUE_LEFT_MIN_GREEN &&
+           bay->queue == 0;
+}
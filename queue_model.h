@@ -0,0 +1,58 @@
+#ifndef QUEUE_MODEL_H
+#define QUEUE_MODEL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* ============================================================================
+ * LEFT-TURN BAY QUEUE MODEL
+ *
+ * The Hall sensors at the bay entrances (P2.4 north, P2.5 south) only see
+ * arrivals. The standing queue is estimated by integrating those arrivals
+ * against saturation-flow discharge while the bay's protected left is green:
+ *
+ *   queue += arrivals
+ *   queue -= (green time past QUEUE_STARTUP_LOST_MS) / QUEUE_SAT_HEADWAY_MS
+ *
+ * The estimate sizes the next protected left (lost time + one headway per
+ * queued vehicle, clamped to QUEUE_LEFT_MIN/MAX_GREEN) and flags imminent
+ * spillback once the queue is within QUEUE_SPILLBACK_MARGIN vehicles of the
+ * bay storage, so the controller can bring the left phase forward before
+ * the queue blocks the through lane. Once the minimum left green has run
+ * and the estimate reaches zero the left has gapped out and may end early,
+ * each bay on its own.
+ *
+ * Queues are kept in milli-vehicles so partial discharge is not lost
+ * between updates.
+ * ========================================================================= */
+
+#define QUEUE_SAT_HEADWAY_MS     2000
+#define QUEUE_STARTUP_LOST_MS    2000
+#define QUEUE_BAY_STORAGE        6
+#define QUEUE_SPILLBACK_MARGIN   1
+#define QUEUE_LEFT_MIN_GREEN     4000
+#define QUEUE_LEFT_MAX_GREEN    15000
+#define QUEUE_SCALE              1000
+
+typedef enum {
+    BAY_NORTH_LEFT = 0,
+    BAY_SOUTH_LEFT,
+    NUM_LEFT_BAYS
+} LeftBay;
+
+typedef struct {
+    uint32_t queue;             /* milli-vehicles */
+    uint32_t greenElapsed;      /* ms into the current protected left */
+    bool     greenActive;
+} BayQueue;
+
+void     queueInit(BayQueue *bay);
+void     queueArrival(BayQueue *bay, uint16_t count);
+void     queueSetGreen(BayQueue *bay, bool green);
+void     queueUpdate(BayQueue *bay, uint32_t elapsedMs);
+uint16_t queueVehicles(const BayQueue *bay);
+uint32_t queueGreenTime(const BayQueue *bay);
+bool     queueSpillbackImminent(const BayQueue *bay);
+bool     queueGappedOut(const BayQueue *bay);
+
+#endif /* QUEUE_MODEL_H */
@@ -0,0 +1,453 @@
+#include "ring_engine.h"
+
+/* ============================================================================
+ * HELPERS
+ * ========================================================================= */
+
+static uint32_t countDown(uint32_t timer, uint32_t ms) {
+    return (timer > ms) ? timer - ms : 0;
+}
+
+static bool phaseServed(const RingEngine *eng, uint8_t phase) {
+    if (phase == PHASE_NONE) return false;
+    return ((eng->plan->recall | eng->recall | eng->demand) &
+            PHASE_BIT(phase)) != 0;
+}
+
+/* Phases showing green or yellow on rings other than `ring` */
+static uint16_t shownOnOtherRings(const RingEngine *eng, uint8_t ring) {
+    uint16_t mask = 0;
+    uint8_t r;
+    for (r = 0; r < NUM_RINGS; r++) {
+        if (r == ring || eng->ring[r].phase == PHASE_NONE) continue;
+        if (eng->ring[r].interval == RING_GREEN ||
+            eng->ring[r].interval == RING_YELLOW) {
+            mask |= PHASE_BIT(eng->ring[r].phase);
+        }
+    }
+    return mask;
+}
+
+/* First slot at or after `from` in this ring's barrier with a phase to
+ * serve, or PHASES_PER_SLOT if there is none */
+static uint8_t nextServedSlot(const RingEngine *eng, uint8_t ring,
+                              uint8_t from) {
+    uint8_t slot;
+
+    if (eng->forceOff || eng->endBarrier) return PHASES_PER_SLOT;
+
+    for (slot = from; slot < PHASES_PER_SLOT; slot++) {
+        if (phaseServed(eng, eng->plan->sequence[ring][eng->barrier][slot])) {
+            return slot;
+        }
+    }
+    return PHASES_PER_SLOT;
+}
+
+static void enterWait(RingEngine *eng, uint8_t ring) {
+    RingTimer *t = &eng->ring[ring];
+    t->phase     = PHASE_NONE;
+    t->interval  = RING_WAIT;
+    t->timer     = 0;
+    t->elapsed   = 0;
+    t->clearHold = 0;
+    eng->changed = true;
+}
+
+static void startGreen(RingEngine *eng, uint8_t ring, uint8_t slot) {
+    RingTimer *t = &eng->ring[ring];
+    Phase phase = (Phase)eng->plan->sequence[ring][eng->barrier][slot];
+
+    t->slot = slot;
+
+    /* Never happens with a valid plan - skip rather than show a conflict */
+    if (phaseDefs[phase].conflicts & shownOnOtherRings(eng, ring)) {
+        enterWait(eng, ring);
+        return;
+    }
+
+    t->phase     = phase;
+    t->interval  = RING_GREEN;
+    t->timer     = eng->plan->split[phase];
+    t->elapsed   = 0;
+    t->clearHold = 0;
+
+    eng->demand       &= (uint16_t)~PHASE_BIT(phase);
+    eng->greenStarted |= PHASE_BIT(phase);
+    eng->changed       = true;
+}
+
+static void startYellow(RingEngine *eng, uint8_t ring) {
+    RingTimer *t = &eng->ring[ring];
+    t->interval = RING_YELLOW;
+    t->timer    = eng->plan->yellow[t->phase];
+    eng->greenEnded |= PHASE_BIT(t->phase);
+    eng->changed     = true;
+}
+
+static bool canTerminate(const RingEngine *eng, uint8_t ring) {
+    const RingTimer *t = &eng->ring[ring];
+
+    if (eng->forceOff) return true;
+    if (eng->hold & PHASE_BIT(t->phase)) return false;
+    if (eng->endBarrier) return t->elapsed >= eng->plan->minGreen[t->phase];
+    return t->timer == 0;
+}
+
+/* Starts the first served phase of every ring in the current barrier.
+ * Returns false if no ring has anything to serve there. */
+static bool enterBarrier(RingEngine *eng) {
+    bool started = false;
+    uint8_t r, slot;
+
+    for (r = 0; r < NUM_RINGS; r++) {
+        slot = nextServedSlot(eng, r, 0);
+        if (slot < PHASES_PER_SLOT) {
+            startGreen(eng, r, slot);
+            if (eng->ring[r].interval == RING_GREEN) started = true;
+        } else {
+            enterWait(eng, r);
+        }
+    }
+    return started;
+}
+
+/* Overlaps follow their parents: green while any parent is green, then
+ * yellow -> red clearance -> available again */
+static void stepOverlaps(RingEngine *eng, uint32_t elapsedMs) {
+    uint16_t greens = ringGreens(eng);
+    RingTimer *t;
+    uint8_t o;
+
+    for (o = 0; o < NUM_OVERLAPS; o++) {
+        t = &eng->overlap[o];
+        t->timer = countDown(t->timer, elapsedMs);
+
+        switch (t->interval) {
+            case RING_GREEN:
+                if (!(greens & overlapDefs[o].parents)) {
+                    t->interval = RING_YELLOW;
+                    t->timer    = overlapDefs[o].yellow;
+                    eng->changed = true;
+                }
+                break;
+
+            case RING_YELLOW:
+                if (t->timer == 0) {
+                    t->interval = RING_RED;
+                    t->timer    = overlapDefs[o].redClear;
+                    eng->changed = true;
+                }
+                break;
+
+            case RING_RED:
+                if (t->timer == 0) t->interval = RING_WAIT;
+                break;
+
+            default:
+                if (greens & overlapDefs[o].parents) {
+                    t->interval = RING_GREEN;
+                    eng->changed = true;
+                }
+                break;
+        }
+    }
+}
+
+static bool overlapsClear(const RingEngine *eng) {
+    uint8_t o;
+    for (o = 0; o < NUM_OVERLAPS; o++) {
+        if (eng->overlap[o].interval != RING_WAIT) return false;
+    }
+    return true;
+}
+
+static void crossBarrier(RingEngine *eng) {
+    uint8_t tries;
+
+    eng->endBarrier = false;
+
+    for (tries = 0; tries < NUM_BARRIERS; tries++) {
+        eng->barrier = (uint8_t)((eng->barrier + 1) % NUM_BARRIERS);
+        if (eng->barrier == 0) eng->cycleStarted = true;
+        if (enterBarrier(eng)) return;
+    }
+}
+
+/* ============================================================================
+ * PUBLIC API
+ * ========================================================================= */
+
+/* Idle with every ring and overlap red, no calls and no plan. Once, before
+ * the first ringStart(). */
+void ringInit(RingEngine *eng) {
+    uint8_t i;
+
+    eng->plan         = 0;
+    eng->barrier      = 0;
+    eng->demand       = 0;
+    eng->recall       = 0;
+    eng->hold         = 0;
+    eng->greenStarted = 0;
+    eng->greenEnded   = 0;
+    eng->cycleStarted = false;
+    eng->forceOff     = false;
+    eng->endBarrier   = false;
+    eng->idle         = true;
+
+    for (i = 0; i < NUM_RINGS; i++) {
+        eng->ring[i].slot = 0;
+        enterWait(eng, i);
+    }
+    for (i = 0; i < NUM_OVERLAPS; i++) {
+        eng->overlap[i].slot      = 0;
+        eng->overlap[i].phase     = PHASE_NONE;
+        eng->overlap[i].interval  = RING_WAIT;
+        eng->overlap[i].timer     = 0;
+        eng->overlap[i].elapsed   = 0;
+        eng->overlap[i].clearHold = 0;
+    }
+}
+
+/* Starts `plan` at the beginning of `barrier`. Outstanding calls are kept. */
+void ringStart(RingEngine *eng, const PhasePlan *plan, uint8_t barrier) {
+    uint8_t r;
+
+    eng->plan         = plan;
+    eng->barrier      = barrier % NUM_BARRIERS;
+    eng->hold         = 0;
+    eng->greenStarted = 0;
+    eng->greenEnded   = 0;
+    eng->cycleStarted = (eng->barrier == 0);
+    eng->forceOff     = false;
+    eng->endBarrier   = false;
+    eng->idle         = false;
+
+    for (r = 0; r < NUM_RINGS; r++) {
+        eng->ring[r].slot = 0;
+        enterWait(eng, r);
+    }
+
+    if (!enterBarrier(eng)) crossBarrier(eng);
+    stepOverlaps(eng, 0);
+}
+
+void ringStep(RingEngine *eng, uint32_t elapsedMs) {
+    RingTimer *t;
+    bool allReady = true;
+    bool allWaiting = true;
+    uint8_t r, slot;
+
+    if (eng->idle || eng->plan == 0) return;
+
+    for (r = 0; r < NUM_RINGS; r++) {
+        t = &eng->ring[r];
+        if (t->interval == RING_GREEN) t->elapsed += elapsedMs;
+        t->timer     = countDown(t->timer, elapsedMs);
+        t->clearHold = countDown(t->clearHold, elapsedMs);
+    }
+
+    /* Clearances time out: yellow -> red -> next phase in the ring */
+    for (r = 0; r < NUM_RINGS; r++) {
+        t = &eng->ring[r];
+        if (t->timer != 0) continue;
+
+        if (t->interval == RING_YELLOW) {
+            t->interval = RING_RED;
+            t->timer    = eng->plan->redClear[t->phase];
+            if (t->clearHold > t->timer) t->timer = t->clearHold;
+            eng->changed = true;
+        }
+        else if (t->interval == RING_RED) {
+            slot = nextServedSlot(eng, r, (uint8_t)(t->slot + 1));
+            if (slot < PHASES_PER_SLOT) startGreen(eng, r, slot);
+            else                        enterWait(eng, r);
+        }
+    }
+
+    /* Greens: one with a successor in its ring ends on its own; the last
+     * phase of each ring waits until every ring is ready for the barrier */
+    for (r = 0; r < NUM_RINGS; r++) {
+        t = &eng->ring[r];
+
+        if (t->interval == RING_WAIT) continue;
+        allWaiting = false;
+
+        if (t->interval != RING_GREEN) {
+            allReady = false;
+        }
+        else if (eng->forceOff) {
+            startYellow(eng, r);
+            allReady = false;
+        }
+        else if (!canTerminate(eng, r)) {
+            allReady = false;
+        }
+        else if (nextServedSlot(eng, r, (uint8_t)(t->slot + 1)) <
+                 PHASES_PER_SLOT) {
+            startYellow(eng, r);
+            allReady = false;
+        }
+    }
+
+    if (allReady && !allWaiting) {
+        for (r = 0; r < NUM_RINGS; r++) {
+            if (eng->ring[r].interval == RING_GREEN) startYellow(eng, r);
+        }
+    }
+
+    stepOverlaps(eng, elapsedMs);
+
+    if (!allWaiting || !overlapsClear(eng)) return;
+
+    if (eng->forceOff) {
+        eng->idle = true;
+        return;
+    }
+    crossBarrier(eng);
+    stepOverlaps(eng, 0);
+}
+
+void ringPlaceCall(RingEngine *eng, Phase phase) {
+    if (phase != PHASE_NONE) eng->demand |= PHASE_BIT(phase);
+}
+
+/* Every green goes straight to its yellow; once all rings have cleared the
+ * engine goes idle until the next ringStart() */
+void ringForceOff(RingEngine *eng) {
+    eng->forceOff = true;
+}
+
+/* Ends the current barrier early: greens terminate once their minimum green
+ * is met (holds still apply) and no further phases start before the cross */
+void ringEndBarrier(RingEngine *eng) {
+    eng->endBarrier = true;
+}
+
+bool ringIdle(const RingEngine *eng) {
+    return eng->idle;
+}
+
+Phase ringGreenPhase(const RingEngine *eng, uint8_t ring) {
+    if (eng->ring[ring].interval != RING_GREEN) return PHASE_NONE;
+    return eng->ring[ring].phase;
+}
+
+uint32_t ringGreenElapsed(const RingEngine *eng, uint8_t ring) {
+    if (eng->ring[ring].interval != RING_GREEN) return 0;
+    return eng->ring[ring].elapsed;
+}
+
+uint32_t ringGreenRemaining(const RingEngine *eng, uint8_t ring) {
+    if (eng->ring[ring].interval != RING_GREEN) return 0;
+    return eng->ring[ring].timer;
+}
+
+void ringSetGreenRemaining(RingEngine *eng, uint8_t ring, uint32_t ms) {
+    if (eng->ring[ring].interval == RING_GREEN) eng->ring[ring].timer = ms;
+}
+
+/* Keeps the ring's current phase in red clearance for at least `ms` from
+ * now. Only a yellow or red clearance in progress can be extended. */
+void ringExtendClearance(RingEngine *eng, uint8_t ring, uint32_t ms) {
+    RingTimer *t = &eng->ring[ring];
+
+    if (t->interval == RING_YELLOW) {
+        if (ms > t->clearHold) t->clearHold = ms;
+    }
+    else if (t->interval == RING_RED) {
+        if (ms > t->timer) t->timer = ms;
+    }
+}
+
+bool ringPhaseGreen(const RingEngine *eng, Phase phase) {
+    return (ringGreens(eng) & PHASE_BIT(phase)) != 0;
+}
+
+uint16_t ringGreens(const RingEngine *eng) {
+    uint16_t mask = 0;
+    uint8_t r;
+    for (r = 0; r < NUM_RINGS; r++) {
+        if (eng->ring[r].interval == RING_GREEN) {
+            mask |= PHASE_BIT(eng->ring[r].phase);
+        }
+    }
+    return mask;
+}
+
+uint16_t ringYellows(const RingEngine *eng) {
+    uint16_t mask = 0;
+    uint8_t r;
+    for (r = 0; r < NUM_RINGS; r++) {
+        if (eng->ring[r].interval == RING_YELLOW) {
+            mask |= PHASE_BIT(eng->ring[r].phase);
+        }
+    }
+    return mask;
+}
+
+uint8_t ringOverlapGreens(const RingEngine *eng) {
+    uint8_t mask = 0;
+    uint8_t o;
+    for (o = 0; o < NUM_OVERLAPS; o++) {
+        if (eng->overlap[o].interval == RING_GREEN) mask |= OVERLAP_BIT(o);
+    }
+    return mask;
+}
+
+uint8_t ringOverlapYellows(const RingEngine *eng) {
+    uint8_t mask = 0;
+    uint8_t o;
+    for (o = 0; o < NUM_OVERLAPS; o++) {
+        if (eng->overlap[o].interval == RING_YELLOW) mask |= OVERLAP_BIT(o);
+    }
+    return mask;
+}
+
+void ringRender(const RingEngine *eng, LEDState *state) {
+    renderPhases(state, ringGreens(eng), ringYellows(eng),
+                 ringOverlapGreens(eng), ringOverlapYellows(eng));
+}
+
+/* ============================================================================
+ * PLAN GEOMETRY
+ * Nominal figures with every phase served at its split.
+ * ========================================================================= */
+
+uint32_t ringPlanCycleLength(const PhasePlan *plan) {
+    uint32_t cycle = 0;
+    uint32_t ringTime, longest;
+    uint8_t b, r, s, p;
+
+    for (b = 0; b < NUM_BARRIERS; b++) {
+        longest = 0;
+        for (r = 0; r < NUM_RINGS; r++) {
+            ringTime = 0;
+            for (s = 0; s < PHASES_PER_SLOT; s++) {
+                p = plan->sequence[r][b][s];
+                if (p == PHASE_NONE) continue;
+                ringTime += (uint32_t)plan->split[p] + plan->yellow[p] +
+                            plan->redClear[p];
+            }
+            if (ringTime > longest) longest = ringTime;
+        }
+        cycle += longest;
+    }
+    return cycle;
+}
+
+/* Sum of the through-movement splits on one ring */
+uint32_t ringPlanThroughGreen(const PhasePlan *plan, uint8_t ring) {
+    uint32_t total = 0;
+    uint8_t b, s, p;
+
+    for (b = 0; b < NUM_BARRIERS; b++) {
+        for (s = 0; s < PHASES_PER_SLOT; s++) {
+            p = plan->sequence[ring][b][s];
+            if (p != PHASE_NONE && phaseDefs[p].approaches != 0) {
+                total += plan->split[p];
+            }
+        }
+    }
+    return total;
+}
@@ -0,0 +1,96 @@
+#ifndef RING_ENGINE_H
+#define RING_ENGINE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "traffic_states.h"
+
+/* ============================================================================
+ * DUAL-RING PHASE ENGINE
+ *
+ * Runs a PhasePlan (traffic_states.h). Each ring times its own phases
+ * green -> yellow -> red clearance -> next phase, independently of the
+ * other ring, but only within the current barrier:
+ *
+ *   - a ring serves the phases of its barrier slot in plan order, skipping
+ *     any that are neither on recall nor called
+ *   - a ring's last phase in the barrier does not terminate on its own;
+ *     it rests in green until the other ring's last phase is also ready,
+ *     and both then clear together (time left over by a ring that finished
+ *     early goes to the concurrent phase)
+ *   - once both rings have cleared, the barrier is crossed; crossing back
+ *     into barrier 0 starts a new cycle
+ *
+ * Overlaps (traffic_states.h) follow their parents and time their own
+ * clearance; the barrier is not crossed, nor the engine made idle, until
+ * every overlap is red again.
+ *
+ * A green is ready to terminate when its timer runs out and it is not in
+ * `hold`. `recall` adds to the plan's recalls and, like `demand`, is
+ * cleared by ringInit() and kept across ringStart(). A phase is never
+ * started while a conflicting phase (phaseDefs[]) is green or yellow on the
+ * other ring. A phase's red clearance can be stretched from its yellow
+ * onwards (ringExtendClearance).
+ *
+ * The engine only times intervals. Callers adjust green times on the events
+ * it raises (greenStarted / greenEnded / cycleStarted, cleared by the
+ * caller) and render the result with ringRender().
+ * ========================================================================= */
+
+typedef enum {
+    RING_WAIT = 0,      /* at the barrier, all phases red (overlaps: red) */
+    RING_GREEN,
+    RING_YELLOW,
+    RING_RED
+} RingInterval;
+
+typedef struct {
+    uint8_t      slot;          /* index into plan->sequence[ring][barrier] */
+    Phase        phase;         /* PHASE_NONE while waiting */
+    RingInterval interval;
+    uint32_t     timer;         /* ms left in the interval */
+    uint32_t     elapsed;       /* ms since the green started */
+    uint32_t     clearHold;     /* ms the red clearance must still cover */
+} RingTimer;
+
+typedef struct {
+    const PhasePlan *plan;
+    uint8_t   barrier;
+    RingTimer ring[NUM_RINGS];
+    RingTimer overlap[NUM_OVERLAPS];    /* slot and elapsed unused */
+    uint16_t  demand;           /* calls (PHASE_BIT), cleared when served */
+    uint16_t  recall;           /* recalls on top of the plan's (fallback) */
+    uint16_t  hold;             /* greens that may not terminate */
+    uint16_t  greenStarted;     /* events since the caller last cleared them */
+    uint16_t  greenEnded;
+    bool      cycleStarted;
+    bool      changed;          /* displayed intervals changed */
+    bool      forceOff;         /* clear every ring and stop */
+    bool      endBarrier;       /* leave the barrier once min greens are met */
+    bool      idle;
+} RingEngine;
+
+void     ringInit(RingEngine *eng);
+void     ringStart(RingEngine *eng, const PhasePlan *plan, uint8_t barrier);
+void     ringStep(RingEngine *eng, uint32_t elapsedMs);
+void     ringPlaceCall(RingEngine *eng, Phase phase);
+void     ringForceOff(RingEngine *eng);
+void     ringEndBarrier(RingEngine *eng);
+bool     ringIdle(const RingEngine *eng);
+
+Phase    ringGreenPhase(const RingEngine *eng, uint8_t ring);
+uint32_t ringGreenElapsed(const RingEngine *eng, uint8_t ring);
+uint32_t ringGreenRemaining(const RingEngine *eng, uint8_t ring);
+void     ringSetGreenRemaining(RingEngine *eng, uint8_t ring, uint32_t ms);
+void     ringExtendClearance(RingEngine *eng, uint8_t ring, uint32_t ms);
+bool     ringPhaseGreen(const RingEngine *eng, Phase phase);
+uint16_t ringGreens(const RingEngine *eng);
+uint16_t ringYellows(const RingEngine *eng);
+uint8_t  ringOverlapGreens(const RingEngine *eng);
+uint8_t  ringOverlapYellows(const RingEngine *eng);
+void     ringRender(const RingEngine *eng, LEDState *state);
+
+uint32_t ringPlanCycleLength(const PhasePlan *plan);
+uint32_t ringPlanThroughGreen(const PhasePlan *plan, uint8_t ring);
+
+#endif /* RING_ENGINE_H */
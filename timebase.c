@@ -0,0 +1,51 @@
+#include "timebase.h"
+
+/* Called before interrupts are enabled */
+void tbInit(Timebase *tb, const volatile uint16_t *timer,
+            const volatile uint16_t *timerCtl, uint16_t overflowFlag) {
+    tb->msLow        = 0;
+    tb->msHigh       = 0;
+    tb->overflowLow  = 0;
+    tb->overflowHigh = 0;
+    tb->timer        = timer;
+    tb->timerCtl     = timerCtl;
+    tb->overflowFlag = overflowFlag;
+}
+
+/* Interrupt context - the 1 ms tick */
+void tbTick(Timebase *tb) {
+    if (++tb->msLow == 0) tb->msHigh++;
+}
+
+/* Interrupt context - the timer's overflow */
+void tbOverflow(Timebase *tb) {
+    if (++tb->overflowLow == 0) tb->overflowHigh++;
+}
+
+uint32_t tbMillis(const Timebase *tb) {
+    uint16_t high, low;
+
+    do {
+        high = tb->msHigh;
+        low  = tb->msLow;
+    } while (high != tb->msHigh);
+    return (uint32_t)high << 16 | low;
+}
+
+/* The overflow count is re-read whole: the ISR may have run anywhere
+ * between the first reads, and either half may be the one that moved. */
+uint64_t tbCycles(const Timebase *tb) {
+    uint16_t high, low, count, ctl;
+    uint32_t overflows;
+
+    do {
+        high  = tb->overflowHigh;
+        low   = tb->overflowLow;
+        count = *tb->timer;
+        ctl   = *tb->timerCtl;
+    } while (low != tb->overflowLow || high != tb->overflowHigh);
+
+    overflows = (uint32_t)high << 16 | low;
+    if ((ctl & tb->overflowFlag) && count < 0x8000) overflows++;
+    return (uint64_t)overflows << 16 | count;
+}
@@ -0,0 +1,56 @@
+#ifndef TIMEBASE_H
+#define TIMEBASE_H
+
+#include <stdint.h>
+
+/* ============================================================================
+ * MONOTONIC TIMEBASE
+ *
+ * Two clocks, each advanced by an interrupt and readable from any context:
+ *
+ *   milliseconds  32 bits, advanced by tbTick() from the 1 ms tick ISR.
+ *                 Wraps after 49.7 days; compare as `now - then`
+ *   cycles        48 bits: a free-running 16-bit hardware timer, extended
+ *                 by a 32-bit count of its overflows that tbOverflow()
+ *                 advances from the timer's overflow ISR. On SMCLK (1 MHz)
+ *                 one cycle is a microsecond and the count wraps after
+ *                 8.9 years
+ *
+ * The CPU moves 16 bits at a time, so a 32-bit counter read outside the
+ * ISR that writes it can tear: an interrupt between the two halves pairs
+ * an old half with a new one, and 0x0000FFFF -> 0x00010000 reads as
+ * 0x0001FFFF. Each counter is therefore kept as two 16-bit halves and read
+ * lock-free, retrying on change:
+ *
+ *   high, low, high again - the ISR carries into the high half only as
+ *   the low half wraps, so an unchanged high half means the low half was
+ *   read in the same epoch
+ *
+ * The cycle read takes the overflow count, the timer and the overflow
+ * count again. With the overflow ISR held off - inside a higher-priority
+ * ISR, or the few cycles before it is entered - an overflow can be pending
+ * but uncounted; a timer count in the low half of the period was then read
+ * after it, and one more overflow is added. So tbCycles() is valid in any
+ * context, as long as no ISR runs for half a timer period (32 ms).
+ *
+ * Each counter has one writer, its ISR; ISRs do not nest.
+ * ========================================================================= */
+
+typedef struct {
+    volatile uint16_t msLow;
+    volatile uint16_t msHigh;
+    volatile uint16_t overflowLow;
+    volatile uint16_t overflowHigh;
+    const volatile uint16_t *timer;     /* the free-running count, TAxR */
+    const volatile uint16_t *timerCtl;  /* holding its overflow flag */
+    uint16_t overflowFlag;              /* TAIFG */
+} Timebase;
+
+void     tbInit(Timebase *tb, const volatile uint16_t *timer,
+                const volatile uint16_t *timerCtl, uint16_t overflowFlag);
+void     tbTick(Timebase *tb);
+void     tbOverflow(Timebase *tb);
+uint32_t tbMillis(const Timebase *tb);
+uint64_t tbCycles(const Timebase *tb);
+
+#endif /* TIMEBASE_H */
@@ -0,0 +1,148 @@
+#include "timer_wheel.h"
+
+/* ============================================================================
+ * HELPERS
+ * ========================================================================= */
+
+static void unlink(SoftTimer *t) {
+    if (t->list == 0) return;
+
+    if (t->prev) t->prev->next = t->next;
+    else         *t->list      = t->next;
+    if (t->next) t->next->prev = t->prev;
+
+    t->next = 0;
+    t->prev = 0;
+    t->list = 0;
+}
+
+static void pushFront(SoftTimer **list, SoftTimer *t) {
+    t->prev = 0;
+    t->next = *list;
+    if (*list) (*list)->prev = t;
+    *list   = t;
+    t->list = list;
+}
+
+/* Files `t` by how far its expiry is from the wheel's current tick */
+static void file(TimerWheel *wheel, SoftTimer *t) {
+    uint32_t delta = t->expires - wheel->now;
+    uint32_t when  = t->expires;
+    uint8_t level;
+
+    if (delta < WHEEL_SLOTS) {
+        level = 0;
+    }
+    else if (delta < (1UL << (2 * WHEEL_BITS))) {
+        level = 1;
+    }
+    else {
+        level = 2;
+        /* Beyond the wheel - park in the furthest slot, re-filed later */
+        if (delta >= (1UL << (3 * WHEEL_BITS))) {
+            when = wheel->now + ((uint32_t)WHEEL_MASK << (2 * WHEEL_BITS));
+        }
+    }
+
+    pushFront(&wheel->slot[level][(when >> (level * WHEEL_BITS)) &
+                                  WHEEL_MASK], t);
+}
+
+/* Moves every timer of one slot down into the levels below */
+static void cascade(TimerWheel *wheel, uint8_t level) {
+    SoftTimer **slot = &wheel->slot[level][(wheel->now >>
+                                            (level * WHEEL_BITS)) &
+                                           WHEEL_MASK];
+    SoftTimer *t;
+
+    while ((t = *slot) != 0) {
+        unlink(t);
+        file(wheel, t);
+    }
+}
+
+/* ============================================================================
+ * PUBLIC API
+ * ========================================================================= */
+
+void wheelInit(TimerWheel *wheel, uint32_t now) {
+    uint8_t level, i;
+    for (level = 0; level < WHEEL_LEVELS; level++) {
+        for (i = 0; i < WHEEL_SLOTS; i++) wheel->slot[level][i] = 0;
+    }
+    wheel->now = now;
+}
+
+/* Processes every tick up to `now`, running due callbacks in order */
+void wheelAdvance(TimerWheel *wheel, uint32_t now) {
+    SoftTimer *due;
+    SoftTimer *t;
+
+    while (wheel->now != now) {
+        wheel->now++;
+
+        if ((wheel->now & WHEEL_MASK) == 0) {
+            if (((wheel->now >> WHEEL_BITS) & WHEEL_MASK) == 0) {
+                cascade(wheel, 2);
+            }
+            cascade(wheel, 1);
+        }
+
+        /* Detach the due slot first so callbacks can re-arm freely */
+        due = 0;
+        while ((t = wheel->slot[0][wheel->now & WHEEL_MASK]) != 0) {
+            unlink(t);
+            pushFront(&due, t);
+        }
+
+        while ((t = due) != 0) {
+            unlink(t);
+            if (t->expires != wheel->now) {
+                file(wheel, t);         /* parked beyond the wheel */
+                continue;
+            }
+            if (t->period != 0) {
+                t->expires += t->period;
+                file(wheel, t);
+            }
+            t->callback(t->owner, t->id);
+        }
+    }
+}
+
+void timerInit(SoftTimer *t, TimerCallback callback, void *owner,
+               uint8_t id) {
+    t->next     = 0;
+    t->prev     = 0;
+    t->list     = 0;
+    t->expires  = 0;
+    t->period   = 0;
+    t->callback = callback;
+    t->owner    = owner;
+    t->id       = id;
+}
+
+/* (Re)arms `t` to fire `delayMs` from now (at least 1 ms), then every
+ * `periodMs` if that is non-zero */
+void timerStart(TimerWheel *wheel, SoftTimer *t, uint32_t delayMs,
+                uint32_t periodMs) {
+    unlink(t);
+    if (delayMs == 0) delayMs = 1;
+
+    t->expires = wheel->now + delayMs;
+    t->period  = periodMs;
+    file(wheel, t);
+}
+
+void timerCancel(SoftTimer *t) {
+    unlink(t);
+}
+
+bool timerArmed(const SoftTimer *t) {
+    return t->list != 0;
+}
+
+uint32_t timerRemaining(const TimerWheel *wheel, const SoftTimer *t) {
+    if (t->list == 0) return 0;
+    return t->expires - wheel->now;
+}
@@ -0,0 +1,66 @@
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* ============================================================================
+ * SOFTWARE TIMER WHEEL
+ *
+ * One-shot and periodic millisecond timers on a three-level hierarchical
+ * wheel, WHEEL_SLOTS slots per level:
+ *
+ *   level 0   1 ms slots       timers due within   64 ms
+ *   level 1   64 ms slots      timers due within    4.1 s
+ *   level 2   4096 ms slots    timers due within  262 s (further out they
+ *                              park in the last slot and are re-filed)
+ *
+ * Each slot is a doubly linked list, so starting and cancelling a timer are
+ * O(1). Every tick the wheel touches only the level-0 slot that is due;
+ * on each 64 ms (and 4096 ms) boundary the next level-1 (level-2) slot is
+ * re-filed into the level below.
+ *
+ * The Timer_B0 ISR only advances the millisecond count (timebase.h).
+ * wheelAdvance() is called from the main loop and runs the callbacks of
+ * every timer that fell due since the last call, in main context, so
+ * callbacks may start and cancel timers (their own included).
+ *
+ * Every timer carries an owner pointer that is handed back to its callback,
+ * so one wheel can serve any number of controller instances.
+ * ========================================================================= */
+
+#define WHEEL_BITS      6
+#define WHEEL_SLOTS     (1u << WHEEL_BITS)
+#define WHEEL_MASK      (WHEEL_SLOTS - 1)
+#define WHEEL_LEVELS    3
+
+typedef void (*TimerCallback)(void *owner, uint8_t id);
+
+typedef struct SoftTimer {
+    struct SoftTimer  *next;
+    struct SoftTimer  *prev;
+    struct SoftTimer **list;    /* slot head it is filed in, 0 if idle */
+    uint32_t           expires; /* wheel time it falls due */
+    uint32_t           period;  /* 0 = one-shot */
+    TimerCallback      callback;
+    void              *owner;   /* passed to the callback */
+    uint8_t            id;      /* passed to the callback */
+} SoftTimer;
+
+typedef struct {
+    SoftTimer *slot[WHEEL_LEVELS][WHEEL_SLOTS];
+    uint32_t   now;             /* last tick processed */
+} TimerWheel;
+
+void     wheelInit(TimerWheel *wheel, uint32_t now);
+void     wheelAdvance(TimerWheel *wheel, uint32_t now);
+
+void     timerInit(SoftTimer *t, TimerCallback callback, void *owner,
+                   uint8_t id);
+void     timerStart(TimerWheel *wheel, SoftTimer *t, uint32_t delayMs,
+                    uint32_t periodMs);
+void     timerCancel(SoftTimer *t);
+bool     timerArmed(const SoftTimer *t);
+uint32_t timerRemaining(const TimerWheel *wheel, const SoftTimer *t);
+
+#endif /* TIMER_WHEEL_H */
@@ -1,8 +1,5 @@
 #include "traffic_states.h"
 #include <string.h>
-//TRYING THIS 
-volatile bool northLeftDemand = false;
-volatile bool southLeftDemand = false;
 
 /* ============================================================================
  * HELPER FUNCTIONS
@@ -71,91 +68,65 @@ bool getLED(LEDState *state, uint8_t ledNumber) {
 }
 
 /* ============================================================================
- * DAYTIME MODE STATES (0-18)
+ * NIGHT MODE STATES (38-40)
  * ========================================================================= */
 
-/* State 0: North-South Green */
-void setState_0_NSGreen(LEDState *state) {
-    clearAllLEDs(state);
-    setLED(state, N_COMBO_GREEN, true);
-    setLED(state, N_THRU_GREEN, true);
-    setLED(state, S_COMBO_GREEN, true);
-    setLED(state, S_THRU_GREEN, true);
-    setLED(state, S_RIGHT_GREEN_BALL, true);
-    setLED(state, W_THRU_RED, true);
-    setLED(state, W_RIGHT_RED, true);
-    setLED(state, E_THRU_LEFT_RED, true);
-    setLED(state, E_THRU_RIGHT_RED, true);
-}
-
-/* State 1: North-South Yellow */
-void setState_1_NSYellow(LEDState *state) {
+/* State 38: Flash ON - N/S yellow, E/W red */
+void setState_38_NightFlashOn(LEDState *state) {
     clearAllLEDs(state);
     setLED(state, N_COMBO_YELLOW, true);
     setLED(state, N_THRU_YELLOW, true);
     setLED(state, S_COMBO_YELLOW, true);
     setLED(state, S_THRU_YELLOW, true);
-    setLED(state, S_RIGHT_YELLOW, true);
     setLED(state, W_THRU_RED, true);
     setLED(state, W_RIGHT_RED, true);
     setLED(state, E_THRU_LEFT_RED, true);
     setLED(state, E_THRU_RIGHT_RED, true);
 }
 
-void setState_2_AllRed1(LEDState *state) { setAllRed(state); }
-
-/* State 3: North Left Turn Green (Protected) */
-void setState_3_NLeftGreen(LEDState *state) {
+/* State 39: Flash OFF - all dark */
+void setState_39_NightFlashOff(LEDState *state) {
     clearAllLEDs(state);
-    setLED(state, N_LEFT_GREEN_ARROW, true);
-    setLED(state, N_COMBO_RED, true);
-    setLED(state, N_THRU_RED, true);
-    setLED(state, S_COMBO_RED, true);
-    setLED(state, S_THRU_RED, true);
-    setLED(state, S_RIGHT_RED, true);
-    setLED(state, W_THRU_RED, true);
-    setLED(state, W_RIGHT_RED, true);
-    setLED(state, E_THRU_LEFT_RED, true);
-    setLED(state, E_THRU_RIGHT_RED, true);
 }
 
-/* State 4: North Left Turn Yellow */
-void setState_4_NLeftYellow(LEDState *state) {
-    clearAllLEDs(state);
-    setLED(state, N_COMBO_YELLOW, true);
-    setLED(state, N_THRU_RED, true);
-    setLED(state, S_COMBO_RED, true);
-    setLED(state, S_THRU_RED, true);
-    setLED(state, S_RIGHT_RED, true);
-    setLED(state, W_THRU_RED, true);
-    setLED(state, W_RIGHT_RED, true);
-    setLED(state, E_THRU_LEFT_RED, true);
-    setLED(state, E_THRU_RIGHT_RED, true);
-}
+/* State 40: Night Transition - all red between the flash and the engine */
+void setState_40_NightTransition(LEDState *state) { setAllRed(state); }
+
+/* ============================================================================
+ * EMERGENCY MODE STATES (41-42)
+ * ========================================================================= */
 
-void setState_5_AllRed2(LEDState *state) { setAllRed(state); }
+void setState_41_EmergencyAllRed(LEDState *state) { setAllRed(state); }
+void setState_42_EmergencyHold(LEDState *state)    { setAllRed(state); }
 
-/* State 6: South Left Turn Green (Protected) */
-void setState_6_SLeftGreen(LEDState *state) {
+/* ============================================================================
+ * PREEMPTION STATES (43-51)
+ * Track-clearance green: every movement on the preempting approach is
+ * released, all other approaches held red.
+ * ========================================================================= */
+
+/* State 43: North track-clearance green */
+void setState_43_PreemptNGreen(LEDState *state) {
     clearAllLEDs(state);
-    setLED(state, S_LEFT_GREEN_ARROW, true);
+    setLED(state, N_LEFT_GREEN_ARROW, true);
+    setLED(state, N_COMBO_GREEN, true);
+    setLED(state, N_THRU_GREEN, true);
     setLED(state, S_COMBO_RED, true);
     setLED(state, S_THRU_RED, true);
     setLED(state, S_RIGHT_RED, true);
-    setLED(state, N_COMBO_RED, true);
-    setLED(state, N_THRU_RED, true);
     setLED(state, W_THRU_RED, true);
     setLED(state, W_RIGHT_RED, true);
     setLED(state, E_THRU_LEFT_RED, true);
     setLED(state, E_THRU_RIGHT_RED, true);
 }
 
-/* State 7: South Left Turn Yellow */
-void setState_7_SLeftYellow(LEDState *state) {
+/* State 44: South track-clearance green */
+void setState_44_PreemptSGreen(LEDState *state) {
     clearAllLEDs(state);
-    setLED(state, S_COMBO_YELLOW, true);
-    setLED(state, S_THRU_RED, true);
-    setLED(state, S_RIGHT_RED, true);
+    setLED(state, S_LEFT_GREEN_ARROW, true);
+    setLED(state, S_COMBO_GREEN, true);
+    setLED(state, S_THRU_GREEN, true);
+    setLED(state, S_RIGHT_GREEN_BALL, true);
     setLED(state, N_COMBO_RED, true);
     setLED(state, N_THRU_RED, true);
     setLED(state, W_THRU_RED, true);
@@ -164,40 +135,8 @@ void setState_7_SLeftYellow(LEDState *state) {
     setLED(state, E_THRU_RIGHT_RED, true);
 }
 
-void setState_8_AllRed3(LEDState *state) { setAllRed(state); }
-
-/* State 9: West Through Green ONLY - Split Phase */
-void setState_9_WThruGreen(LEDState *state) {
-    clearAllLEDs(state);
-    setLED(state, W_THRU_GREEN, true);
-    setLED(state, W_RIGHT_GREEN_BALL, true);
-    setLED(state, E_THRU_LEFT_RED, true);
-    setLED(state, E_THRU_RIGHT_RED, true);
-    setLED(state, N_COMBO_RED, true);
-    setLED(state, N_THRU_RED, true);
-    setLED(state, S_COMBO_RED, true);
-    setLED(state, S_THRU_RED, true);
-    setLED(state, S_RIGHT_RED, true);
-}
-
-/* State 10: West Through Yellow ONLY */
-void setState_10_WThruYellow(LEDState *state) {
-    clearAllLEDs(state);
-    setLED(state, W_THRU_YELLOW, true);
-    setLED(state, W_RIGHT_YELLOW, true);
-    setLED(state, E_THRU_LEFT_RED, true);
-    setLED(state, E_THRU_RIGHT_RED, true);
-    setLED(state, N_COMBO_RED, true);
-    setLED(state, N_THRU_RED, true);
-    setLED(state, S_COMBO_RED, true);
-    setLED(state, S_THRU_RED, true);
-    setLED(state, S_RIGHT_RED, true);
-}
-
-void setState_11_AllRed4(LEDState *state) { setAllRed(state); }
-
-/* State 12: East Through Green ONLY - Split Phase */
-void setState_12_EThruGreen(LEDState *state) {
+/* State 45: East track-clearance green */
+void setState_45_PreemptEGreen(LEDState *state) {
     clearAllLEDs(state);
     setLED(state, E_THRU_LEFT_GREEN, true);
     setLED(state, E_THRU_RIGHT_GREEN, true);
@@ -210,81 +149,25 @@ void setState_12_EThruGreen(LEDState *state) {
     setLED(state, S_RIGHT_RED, true);
 }
 
-/* State 13: East Through Yellow */
-void setState_13_EThruYellow(LEDState *state) {
-    clearAllLEDs(state);
-    setLED(state, E_THRU_LEFT_YELLOW, true);
-    setLED(state, E_THRU_RIGHT_YELLOW, true);
-    setLED(state, W_THRU_RED, true);
-    setLED(state, W_RIGHT_RED, true);
-    setLED(state, N_COMBO_RED, true);
-    setLED(state, N_THRU_RED, true);
-    setLED(state, S_COMBO_RED, true);
-    setLED(state, S_THRU_RED, true);
-    setLED(state, S_RIGHT_RED, true);
-}
-
-void setState_14_AllRed5(LEDState *state) { setAllRed(state); }
-
-/* State 15: West Right Turn Green (Protected) */
-void setState_15_WRightGreen(LEDState *state) {
+/* State 46: West track-clearance green */
+void setState_46_PreemptWGreen(LEDState *state) {
     clearAllLEDs(state);
-    setLED(state, W_RIGHT_GREEN_ARROW, true);
-    setLED(state, W_THRU_RED, true);
-    setLED(state, N_COMBO_RED, true);
-    setLED(state, N_THRU_RED, true);
-    setLED(state, S_COMBO_RED, true);
-    setLED(state, S_THRU_RED, true);
-    setLED(state, S_RIGHT_RED, true);
+    setLED(state, W_THRU_GREEN, true);
+    setLED(state, W_RIGHT_GREEN_BALL, true);
     setLED(state, E_THRU_LEFT_RED, true);
     setLED(state, E_THRU_RIGHT_RED, true);
-}
-
-/* State 16: West Right Turn Yellow */
-void setState_16_WRightYellow(LEDState *state) {
-    clearAllLEDs(state);
-    setLED(state, W_RIGHT_YELLOW, true);
-    setLED(state, W_THRU_RED, true);
     setLED(state, N_COMBO_RED, true);
     setLED(state, N_THRU_RED, true);
     setLED(state, S_COMBO_RED, true);
     setLED(state, S_THRU_RED, true);
     setLED(state, S_RIGHT_RED, true);
-    setLED(state, E_THRU_LEFT_RED, true);
-    setLED(state, E_THRU_RIGHT_RED, true);
-}
-
-void setState_17_AllRed6(LEDState *state)    { setAllRed(state); }
-void setState_18_ReturnStart(LEDState *state) { setAllRed(state); }
-
-/* ============================================================================
- * HIGH TRAFFIC MODE STATES (19-35)
- * Sequence: N solo (10s) -> S left during N (8s) -> Both green (25s) ->
- *           N left during S (8s) -> Both yellow (3s) -> All red -> E/W split
- * ========================================================================= */
-
-void setState_19_NPriorityStart(LEDState *state) { setAllRed(state); }
-
-/* State 20: North solo green (10s) */
-void setState_20_NSoloGreen(LEDState *state) {
-    clearAllLEDs(state);
-    setLED(state, N_COMBO_GREEN, true);
-    setLED(state, N_THRU_GREEN, true);
-    setLED(state, S_COMBO_RED, true);
-    setLED(state, S_THRU_RED, true);
-    setLED(state, S_RIGHT_RED, true);
-    setLED(state, W_THRU_RED, true);
-    setLED(state, W_RIGHT_RED, true);
-    setLED(state, E_THRU_LEFT_RED, true);
-    setLED(state, E_THRU_RIGHT_RED, true);
 }
 
-/* State 21: South left arrow while North still green (8s) */
-void setState_21_SLeftDuringN(LEDState *state) {
+/* State 47: North preemption exit yellow */
+void setState_47_PreemptNYellow(LEDState *state) {
     clearAllLEDs(state);
-    setLED(state, N_COMBO_GREEN, true);
-    setLED(state, N_THRU_GREEN, true);
-    setLED(state, S_LEFT_GREEN_ARROW, true);
+    setLED(state, N_COMBO_YELLOW, true);
+    setLED(state, N_THRU_YELLOW, true);
     setLED(state, S_COMBO_RED, true);
     setLED(state, S_THRU_RED, true);
     setLED(state, S_RIGHT_RED, true);
@@ -294,97 +177,22 @@ void setState_21_SLeftDuringN(LEDState *state) {
     setLED(state, E_THRU_RIGHT_RED, true);
 }
 
-/* State 22: Both North and South green together (25s) */
-void setState_22_NSBothGreen(LEDState *state) {
-    clearAllLEDs(state);
-    setLED(state, N_COMBO_GREEN, true);
-    setLED(state, N_THRU_GREEN, true);
-    setLED(state, S_COMBO_GREEN, true);
-    setLED(state, S_THRU_GREEN, true);
-    setLED(state, S_RIGHT_GREEN_BALL, true);
-    setLED(state, W_THRU_RED, true);
-    setLED(state, W_RIGHT_RED, true);
-    setLED(state, E_THRU_LEFT_RED, true);
-    setLED(state, E_THRU_RIGHT_RED, true);
-}
-
-/* State 23: North left arrow while South still green (8s) */
-void setState_23_NLeftDuringS(LEDState *state) {
-    clearAllLEDs(state);
-    setLED(state, N_LEFT_GREEN_ARROW, true);
-    setLED(state, N_COMBO_RED, true);
-    setLED(state, N_THRU_RED, true);
-    setLED(state, S_COMBO_GREEN, true);
-    setLED(state, S_THRU_GREEN, true);
-    setLED(state, S_RIGHT_GREEN_BALL, true);
-    setLED(state, W_THRU_RED, true);
-    setLED(state, W_RIGHT_RED, true);
-    setLED(state, E_THRU_LEFT_RED, true);
-    setLED(state, E_THRU_RIGHT_RED, true);
-}
-
-/* State 24: Both North and South yellow together (3s) */
-void setState_24_NSHTYellow(LEDState *state) {
+/* State 48: South preemption exit yellow */
+void setState_48_PreemptSYellow(LEDState *state) {
     clearAllLEDs(state);
-    setLED(state, N_COMBO_YELLOW, true);
-    setLED(state, N_THRU_YELLOW, true);
     setLED(state, S_COMBO_YELLOW, true);
     setLED(state, S_THRU_YELLOW, true);
     setLED(state, S_RIGHT_YELLOW, true);
-    setLED(state, W_THRU_RED, true);
-    setLED(state, W_RIGHT_RED, true);
-    setLED(state, E_THRU_LEFT_RED, true);
-    setLED(state, E_THRU_RIGHT_RED, true);
-}
-
-void setState_25_AllRedHT1(LEDState *state) { setAllRed(state); }
-
-/* State 26: West Through Green ONLY - Split Phase */
-void setState_26_WThruGreenHT(LEDState *state) {
-    clearAllLEDs(state);
-    setLED(state, W_THRU_GREEN, true);
-    setLED(state, W_RIGHT_GREEN_BALL, true);
-    setLED(state, E_THRU_LEFT_RED, true);
-    setLED(state, E_THRU_RIGHT_RED, true);
     setLED(state, N_COMBO_RED, true);
     setLED(state, N_THRU_RED, true);
-    setLED(state, S_COMBO_RED, true);
-    setLED(state, S_THRU_RED, true);
-    setLED(state, S_RIGHT_RED, true);
-}
-
-/* State 27: West Through Yellow ONLY */
-void setState_27_WThruYellowHT(LEDState *state) {
-    clearAllLEDs(state);
-    setLED(state, W_THRU_YELLOW, true);
-    setLED(state, W_RIGHT_YELLOW, true);
-    setLED(state, E_THRU_LEFT_RED, true);
-    setLED(state, E_THRU_RIGHT_RED, true);
-    setLED(state, N_COMBO_RED, true);
-    setLED(state, N_THRU_RED, true);
-    setLED(state, S_COMBO_RED, true);
-    setLED(state, S_THRU_RED, true);
-    setLED(state, S_RIGHT_RED, true);
-}
-
-void setState_28_AllRedHT2(LEDState *state) { setAllRed(state); }
-
-/* State 29: East Through Green ONLY - Split Phase */
-void setState_29_EThruGreenHT(LEDState *state) {
-    clearAllLEDs(state);
-    setLED(state, E_THRU_LEFT_GREEN, true);
-    setLED(state, E_THRU_RIGHT_GREEN, true);
     setLED(state, W_THRU_RED, true);
     setLED(state, W_RIGHT_RED, true);
-    setLED(state, N_COMBO_RED, true);
-    setLED(state, N_THRU_RED, true);
-    setLED(state, S_COMBO_RED, true);
-    setLED(state, S_THRU_RED, true);
-    setLED(state, S_RIGHT_RED, true);
+    setLED(state, E_THRU_LEFT_RED, true);
+    setLED(state, E_THRU_RIGHT_RED, true);
 }
 
-/* State 30: East Through Yellow */
-void setState_30_EThruYellowHT(LEDState *state) {
+/* State 49: East preemption exit yellow */
+void setState_49_PreemptEYellow(LEDState *state) {
     clearAllLEDs(state);
     setLED(state, E_THRU_LEFT_YELLOW, true);
     setLED(state, E_THRU_RIGHT_YELLOW, true);
@@ -397,70 +205,21 @@ void setState_30_EThruYellowHT(LEDState *state) {
     setLED(state, S_RIGHT_RED, true);
 }
 
-void setState_31_AllRedHT3(LEDState *state) { setAllRed(state); }
-
-/* State 32: West Right Turn Green (Protected) - HT */
-void setState_32_WRightGreenHT(LEDState *state) {
+/* State 50: West preemption exit yellow */
+void setState_50_PreemptWYellow(LEDState *state) {
     clearAllLEDs(state);
-    setLED(state, W_RIGHT_GREEN_ARROW, true);
-    setLED(state, W_THRU_RED, true);
-    setLED(state, N_COMBO_RED, true);
-    setLED(state, N_THRU_RED, true);
-    setLED(state, S_COMBO_RED, true);
-    setLED(state, S_THRU_RED, true);
-    setLED(state, S_RIGHT_RED, true);
+    setLED(state, W_THRU_YELLOW, true);
+    setLED(state, W_RIGHT_YELLOW, true);
     setLED(state, E_THRU_LEFT_RED, true);
     setLED(state, E_THRU_RIGHT_RED, true);
-}
-
-/* State 33: West Right Turn Yellow - HT */
-void setState_33_WRightYellowHT(LEDState *state) {
-    clearAllLEDs(state);
-    setLED(state, W_RIGHT_YELLOW, true);
-    setLED(state, W_THRU_RED, true);
     setLED(state, N_COMBO_RED, true);
     setLED(state, N_THRU_RED, true);
     setLED(state, S_COMBO_RED, true);
     setLED(state, S_THRU_RED, true);
     setLED(state, S_RIGHT_RED, true);
-    setLED(state, E_THRU_LEFT_RED, true);
-    setLED(state, E_THRU_RIGHT_RED, true);
 }
 
-void setState_34_AllRedHT4(LEDState *state)  { setAllRed(state); }
-void setState_35_ReturnHT(LEDState *state)    { setAllRed(state); }
-
-/* ============================================================================
- * NIGHT MODE STATES (38-40)
- * ========================================================================= */
-
-/* State 38: Flash ON - N/S yellow, E/W red */
-void setState_38_NightFlashOn(LEDState *state) {
-    clearAllLEDs(state);
-    setLED(state, N_COMBO_YELLOW, true);
-    setLED(state, N_THRU_YELLOW, true);
-    setLED(state, S_COMBO_YELLOW, true);
-    setLED(state, S_THRU_YELLOW, true);
-    setLED(state, W_THRU_RED, true);
-    setLED(state, W_RIGHT_RED, true);
-    setLED(state, E_THRU_LEFT_RED, true);
-    setLED(state, E_THRU_RIGHT_RED, true);
-}
-
-/* State 39: Flash OFF - all dark */
-void setState_39_NightFlashOff(LEDState *state) {
-    clearAllLEDs(state);
-}
-
-/* State 40: Night Transition (reserved) */
-void setState_40_NightTransition(LEDState *state) { setAllRed(state); }
-
-/* ============================================================================
- * EMERGENCY MODE STATES (41-42)
- * ========================================================================= */
-
-void setState_41_EmergencyAllRed(LEDState *state) { setAllRed(state); }
-void setState_42_EmergencyHold(LEDState *state)    { setAllRed(state); }
+void setState_51_PreemptExitAllRed(LEDState *state) { setAllRed(state); }
 
 /* ============================================================================
  * EXECUTE STATE
@@ -468,46 +227,6 @@ void setState_42_EmergencyHold(LEDState *state)    { setAllRed(state); }
 
 void executeState(LEDState *state, TrafficState currentState) {
     switch (currentState) {
-        /* Daytime (0-18) */
-        case STATE_NS_GREEN:          setState_0_NSGreen(state);        break;
-        case STATE_NS_YELLOW:         setState_1_NSYellow(state);       break;
-        case STATE_ALL_RED_1:         setState_2_AllRed1(state);        break;
-        case STATE_N_LEFT_GREEN:      setState_3_NLeftGreen(state);     break;
-        case STATE_N_LEFT_YELLOW:     setState_4_NLeftYellow(state);    break;
-        case STATE_ALL_RED_2:         setState_5_AllRed2(state);        break;
-        case STATE_S_LEFT_GREEN:      setState_6_SLeftGreen(state);     break;
-        case STATE_S_LEFT_YELLOW:     setState_7_SLeftYellow(state);    break;
-        case STATE_ALL_RED_3:         setState_8_AllRed3(state);        break;
-        case STATE_W_THRU_GREEN:      setState_9_WThruGreen(state);     break;
-        case STATE_W_THRU_YELLOW:     setState_10_WThruYellow(state);   break;
-        case STATE_ALL_RED_4:         setState_11_AllRed4(state);       break;
-        case STATE_E_THRU_GREEN:      setState_12_EThruGreen(state);    break;
-        case STATE_E_THRU_YELLOW:     setState_13_EThruYellow(state);   break;
-        case STATE_ALL_RED_5:         setState_14_AllRed5(state);       break;
-        case STATE_W_RIGHT_GREEN:     setState_15_WRightGreen(state);   break;
-        case STATE_W_RIGHT_YELLOW:    setState_16_WRightYellow(state);  break;
-        case STATE_ALL_RED_6:         setState_17_AllRed6(state);       break;
-        case STATE_RETURN_TO_START:   setState_18_ReturnStart(state);   break;
-
-        /* High Traffic (19-35) */
-        case STATE_N_PRIORITY_START:  setState_19_NPriorityStart(state); break;
-        case STATE_N_SOLO_GREEN:      setState_20_NSoloGreen(state);     break;
-        case STATE_S_LEFT_DURING_N:   setState_21_SLeftDuringN(state);   break;
-        case STATE_NS_BOTH_GREEN:     setState_22_NSBothGreen(state);    break;
-        case STATE_N_LEFT_DURING_S:   setState_23_NLeftDuringS(state);   break;
-        case STATE_NS_HT_YELLOW:      setState_24_NSHTYellow(state);     break;
-        case STATE_ALL_RED_HT_1:      setState_25_AllRedHT1(state);      break;
-        case STATE_W_THRU_GREEN_HT:   setState_26_WThruGreenHT(state);   break;
-        case STATE_W_THRU_YELLOW_HT:  setState_27_WThruYellowHT(state);  break;
-        case STATE_ALL_RED_HT_2:      setState_28_AllRedHT2(state);      break;
-        case STATE_E_THRU_GREEN_HT:   setState_29_EThruGreenHT(state);   break;
-        case STATE_E_THRU_YELLOW_HT:  setState_30_EThruYellowHT(state);  break;
-        case STATE_ALL_RED_HT_3:      setState_31_AllRedHT3(state);      break;
-        case STATE_W_RIGHT_GREEN_HT:  setState_32_WRightGreenHT(state);  break;
-        case STATE_W_RIGHT_YELLOW_HT: setState_33_WRightYellowHT(state); break;
-        case STATE_ALL_RED_HT_4:      setState_34_AllRedHT4(state);      break;
-        case STATE_RETURN_HT:         setState_35_ReturnHT(state);       break;
-
         /* Night (38-40) */
         case STATE_NIGHT_FLASH_ON:    setState_38_NightFlashOn(state);    break;
         case STATE_NIGHT_FLASH_OFF:   setState_39_NightFlashOff(state);   break;
@@ -517,6 +236,17 @@ void executeState(LEDState *state, TrafficState currentState) {
         case STATE_EMERGENCY_ALL_RED: setState_41_EmergencyAllRed(state); break;
         case STATE_EMERGENCY_HOLD:    setState_42_EmergencyHold(state);   break;
 
+        /* Preemption (43-51) */
+        case STATE_PREEMPT_N_GREEN:   setState_43_PreemptNGreen(state);   break;
+        case STATE_PREEMPT_S_GREEN:   setState_44_PreemptSGreen(state);   break;
+        case STATE_PREEMPT_E_GREEN:   setState_45_PreemptEGreen(state);   break;
+        case STATE_PREEMPT_W_GREEN:   setState_46_PreemptWGreen(state);   break;
+        case STATE_PREEMPT_N_YELLOW:  setState_47_PreemptNYellow(state);  break;
+        case STATE_PREEMPT_S_YELLOW:  setState_48_PreemptSYellow(state);  break;
+        case STATE_PREEMPT_E_YELLOW:  setState_49_PreemptEYellow(state);  break;
+        case STATE_PREEMPT_W_YELLOW:  setState_50_PreemptWYellow(state);  break;
+        case STATE_PREEMPT_EXIT_ALL_RED: setState_51_PreemptExitAllRed(state); break;
+
         default: setAllRed(state); break;
     }
 }
@@ -527,46 +257,6 @@ void executeState(LEDState *state, TrafficState currentState) {
 
 uint32_t getStateDuration(TrafficState state) {
     switch (state) {
-        /* Daytime */
-        case STATE_NS_GREEN:          return TIME_NS_GREEN;
-        case STATE_NS_YELLOW:         return TIME_YELLOW;
-        case STATE_ALL_RED_1:         return TIME_ALL_RED;
-        case STATE_N_LEFT_GREEN:      return TIME_N_LEFT_GREEN;
-        case STATE_N_LEFT_YELLOW:     return TIME_YELLOW;
-        case STATE_ALL_RED_2:         return TIME_ALL_RED;
-        case STATE_S_LEFT_GREEN:      return TIME_S_LEFT_GREEN;
-        case STATE_S_LEFT_YELLOW:     return TIME_YELLOW;
-        case STATE_ALL_RED_3:         return TIME_ALL_RED;
-        case STATE_W_THRU_GREEN:      return TIME_W_THRU_GREEN;
-        case STATE_W_THRU_YELLOW:     return TIME_YELLOW;
-        case STATE_ALL_RED_4:         return TIME_ALL_RED;
-        case STATE_E_THRU_GREEN:      return TIME_E_THRU_GREEN;
-        case STATE_E_THRU_YELLOW:     return TIME_YELLOW;
-        case STATE_ALL_RED_5:         return TIME_ALL_RED;
-        case STATE_W_RIGHT_GREEN:     return TIME_W_RIGHT_GREEN;
-        case STATE_W_RIGHT_YELLOW:    return TIME_YELLOW;
-        case STATE_ALL_RED_6:         return TIME_ALL_RED;
-        case STATE_RETURN_TO_START:   return TIME_ALL_RED;
-
-        /* High Traffic */
-        case STATE_N_PRIORITY_START:  return TIME_ALL_RED;
-        case STATE_N_SOLO_GREEN:      return TIME_N_SOLO_GREEN;
-        case STATE_S_LEFT_DURING_N:   return TIME_S_LEFT_DURING_N;
-        case STATE_NS_BOTH_GREEN:     return TIME_NS_BOTH_GREEN;
-        case STATE_N_LEFT_DURING_S:   return TIME_N_LEFT_DURING_S;
-        case STATE_NS_HT_YELLOW:      return TIME_YELLOW;
-        case STATE_ALL_RED_HT_1:      return TIME_ALL_RED;
-        case STATE_W_THRU_GREEN_HT:   return TIME_W_THRU_GREEN_HT;
-        case STATE_W_THRU_YELLOW_HT:  return TIME_YELLOW;
-        case STATE_ALL_RED_HT_2:      return TIME_ALL_RED;
-        case STATE_E_THRU_GREEN_HT:   return TIME_E_THRU_GREEN_HT;
-        case STATE_E_THRU_YELLOW_HT:  return TIME_YELLOW;
-        case STATE_ALL_RED_HT_3:      return TIME_ALL_RED;
-        case STATE_W_RIGHT_GREEN_HT:  return TIME_W_RIGHT_GREEN_HT;
-        case STATE_W_RIGHT_YELLOW_HT: return TIME_YELLOW;
-        case STATE_ALL_RED_HT_4:      return TIME_ALL_RED;
-        case STATE_RETURN_HT:         return TIME_ALL_RED;
-
         /* Night */
         case STATE_NIGHT_FLASH_ON:    return TIME_NIGHT_FLASH_ON;
         case STATE_NIGHT_FLASH_OFF:   return TIME_NIGHT_FLASH_OFF;
@@ -576,109 +266,301 @@ uint32_t getStateDuration(TrafficState state) {
         case STATE_EMERGENCY_ALL_RED: return TIME_ALL_RED;
         case STATE_EMERGENCY_HOLD:    return TIME_EMERGENCY_HOLD;
 
+        /* Preemption */
+        case STATE_PREEMPT_N_GREEN:
+        case STATE_PREEMPT_S_GREEN:
+        case STATE_PREEMPT_E_GREEN:
+        case STATE_PREEMPT_W_GREEN:   return TIME_PREEMPT_MIN_GREEN;
+        case STATE_PREEMPT_N_YELLOW:
+        case STATE_PREEMPT_S_YELLOW:
+        case STATE_PREEMPT_E_YELLOW:
+        case STATE_PREEMPT_W_YELLOW:  return TIME_YELLOW;
+        case STATE_PREEMPT_EXIT_ALL_RED: return TIME_ALL_RED;
+
         default: return TIME_ALL_RED;
     }
 }
 
 /* ============================================================================
- * NEXT STATE LOGIC
+ * LEFT ARROWS
+ * Bitmask (APPROACH_BIT) of approaches whose protected left arrow is green.
+ * Phase-engine lefts come from phaseDefs[].leftArrows instead.
+ * ========================================================================= */
+
+uint8_t getStateLeftArrows(TrafficState state) {
+    switch (state) {
+        case STATE_PREEMPT_N_GREEN:
+            return APPROACH_BIT(APPROACH_NORTH);
+
+        case STATE_PREEMPT_S_GREEN:
+            return APPROACH_BIT(APPROACH_SOUTH);
+
+        default:
+            return 0;
+    }
+}
+
+
+/* ============================================================================
+ * PHASE DEFINITIONS
+ * Signal head masks per phase, see the PHASES block in traffic_states.h.
+ * ========================================================================= */
+
+#define BARRIER_0_PHASES  (PHASE_BIT(PHASE_1) | PHASE_BIT(PHASE_2) | \
+                           PHASE_BIT(PHASE_5) | PHASE_BIT(PHASE_6))
+#define BARRIER_1_PHASES  (PHASE_BIT(PHASE_3) | PHASE_BIT(PHASE_4) | \
+                           PHASE_BIT(PHASE_7) | PHASE_BIT(PHASE_8))
+
+const PhaseDef phaseDefs[NUM_PHASES] = {
+    /* 1: North protected left - the combo head shows the yellow */
+    [PHASE_1] = {
+        .greenOn    = LED_BIT(N_LEFT_GREEN_ARROW),
+        .greenOff   = 0,
+        .yellowOn   = LED_BIT(N_COMBO_YELLOW),
+        .yellowOff  = LED_BIT(N_COMBO_RED),
+        .ring = 0, .barrier = 0,
+        .approaches = 0,
+        .leftArrows = APPROACH_BIT(APPROACH_NORTH),
+        .conflicts  = PHASE_BIT(PHASE_2) | BARRIER_1_PHASES
+    },
+    /* 2: North through */
+    [PHASE_2] = {
+        .greenOn    = LED_BIT(N_COMBO_GREEN) | LED_BIT(N_THRU_GREEN),
+        .greenOff   = LED_BIT(N_COMBO_RED) | LED_BIT(N_THRU_RED),
+        .yellowOn   = LED_BIT(N_COMBO_YELLOW) | LED_BIT(N_THRU_YELLOW),
+        .yellowOff  = LED_BIT(N_COMBO_RED) | LED_BIT(N_THRU_RED),
+        .ring = 0, .barrier = 0,
+        .approaches = APPROACH_BIT(APPROACH_NORTH),
+        .leftArrows = 0,
+        .conflicts  = PHASE_BIT(PHASE_1) | BARRIER_1_PHASES
+    },
+    /* 3: unused - no heads */
+    [PHASE_3] = {
+        .ring = 0, .barrier = 1,
+        .conflicts  = PHASE_BIT(PHASE_4) | BARRIER_0_PHASES
+    },
+    /* 4: West through, right turns permissive on the ball */
+    [PHASE_4] = {
+        .greenOn    = LED_BIT(W_THRU_GREEN) | LED_BIT(W_RIGHT_GREEN_BALL),
+        .greenOff   = LED_BIT(W_THRU_RED) | LED_BIT(W_RIGHT_RED) |
+                      LED_BIT(W_RIGHT_YELLOW),
+        .yellowOn   = LED_BIT(W_THRU_YELLOW) | LED_BIT(W_RIGHT_YELLOW),
+        .yellowOff  = LED_BIT(W_THRU_RED) | LED_BIT(W_RIGHT_RED),
+        .ring = 0, .barrier = 1,
+        .approaches = APPROACH_BIT(APPROACH_WEST),
+        .leftArrows = 0,
+        .conflicts  = PHASE_BIT(PHASE_3) | BARRIER_0_PHASES
+    },
+    /* 5: South protected left */
+    [PHASE_5] = {
+        .greenOn    = LED_BIT(S_LEFT_GREEN_ARROW),
+        .greenOff   = 0,
+        .yellowOn   = LED_BIT(S_COMBO_YELLOW),
+        .yellowOff  = LED_BIT(S_COMBO_RED),
+        .ring = 1, .barrier = 0,
+        .approaches = 0,
+        .leftArrows = APPROACH_BIT(APPROACH_SOUTH),
+        .conflicts  = PHASE_BIT(PHASE_6) | BARRIER_1_PHASES
+    },
+    /* 6: South through and right */
+    [PHASE_6] = {
+        .greenOn    = LED_BIT(S_COMBO_GREEN) | LED_BIT(S_THRU_GREEN) |
+                      LED_BIT(S_RIGHT_GREEN_BALL),
+        .greenOff   = LED_BIT(S_COMBO_RED) | LED_BIT(S_THRU_RED) |
+                      LED_BIT(S_RIGHT_RED),
+        .yellowOn   = LED_BIT(S_COMBO_YELLOW) | LED_BIT(S_THRU_YELLOW) |
+                      LED_BIT(S_RIGHT_YELLOW),
+        .yellowOff  = LED_BIT(S_COMBO_RED) | LED_BIT(S_THRU_RED) |
+                      LED_BIT(S_RIGHT_RED),
+        .ring = 1, .barrier = 0,
+        .approaches = APPROACH_BIT(APPROACH_SOUTH),
+        .leftArrows = 0,
+        .conflicts  = PHASE_BIT(PHASE_5) | BARRIER_1_PHASES
+    },
+    /* 7: unused - the W right arrow is an overlap */
+    [PHASE_7] = {
+        .ring = 1, .barrier = 1,
+        .conflicts  = PHASE_BIT(PHASE_8) | BARRIER_0_PHASES
+    },
+    /* 8: East through, left turns permissive */
+    [PHASE_8] = {
+        .greenOn    = LED_BIT(E_THRU_LEFT_GREEN) | LED_BIT(E_THRU_RIGHT_GREEN),
+        .greenOff   = LED_BIT(E_THRU_LEFT_RED) | LED_BIT(E_THRU_RIGHT_RED),
+        .yellowOn   = LED_BIT(E_THRU_LEFT_YELLOW) |
+                      LED_BIT(E_THRU_RIGHT_YELLOW),
+        .yellowOff  = LED_BIT(E_THRU_LEFT_RED) | LED_BIT(E_THRU_RIGHT_RED),
+        .ring = 1, .barrier = 1,
+        .approaches = APPROACH_BIT(APPROACH_EAST),
+        .leftArrows = 0,
+        .conflicts  = PHASE_BIT(PHASE_7) | BARRIER_0_PHASES
+    }
+};
+
+/* ============================================================================
+ * OVERLAP DEFINITIONS
+ * ========================================================================= */
+
+const OverlapDef overlapDefs[NUM_OVERLAPS] = {
+    [OVERLAP_S_RIGHT] = {
+        .parents    = PHASE_BIT(PHASE_4),
+        .greenOn    = LED_BIT(S_RIGHT_GREEN_ARROW),
+        .greenOff   = LED_BIT(S_RIGHT_RED),
+        .yellowOn   = LED_BIT(S_RIGHT_YELLOW),
+        .yellowOff  = LED_BIT(S_RIGHT_RED),
+        .yellow     = TIME_OVERLAP_YELLOW,
+        .redClear   = TIME_OVERLAP_ALL_RED
+    },
+    [OVERLAP_W_RIGHT] = {
+        .parents    = PHASE_BIT(PHASE_1),
+        .greenOn    = LED_BIT(W_RIGHT_GREEN_ARROW),
+        .greenOff   = LED_BIT(W_RIGHT_RED),
+        .yellowOn   = LED_BIT(W_RIGHT_YELLOW),
+        .yellowOff  = LED_BIT(W_RIGHT_RED),
+        .yellow     = TIME_OVERLAP_YELLOW,
+        .redClear   = TIME_OVERLAP_ALL_RED
+    }
+};
+
+/* ============================================================================
+ * PLANS
  *
- * DEMAND-ACTUATED LEFT TURNS:
- * Hall effect sensors on P2.4 (North) and P2.5 (South) set demand flags.
- * At the all-red before each left turn, we check the flag:
- *   - Flag SET   -> proceed to protected left green
- *   - Flag CLEAR -> skip left turn, jump to next phase
+ * DAYTIME - leading protected lefts (each only on a call): with both
+ * bays calling, N and S lefts run together on one shared clearance; each
+ * gaps out on its own queue (serviceLeftBays, controller.c) and its
+ * through follows while the longer left carries on alone. Then W and E
+ * through together. The right-turn arrows run as overlaps (S right with
+ * W through, W right with N left).
  *
- * This applies to both Daytime and High Traffic modes.
- * In HT mode, the left turns are states 21 (S left during N) and
- * 23 (N left during S), checked at states 20 and 22 respectively.
+ * HIGH TRAFFIC - north priority: N through leads and runs long, S left
+ * leads on the other ring (only on a call) and S through follows it; the N
+ * left lags at the end of the N/S barrier. E/W as daytime.
+ *
+ * A ring that reaches the barrier first rests its last phase in green until
+ * the other ring gets there, so lefts that are skipped or end early hand
+ * their time to the concurrent through.
  * ========================================================================= */
 
-TrafficState getNextState(TrafficState currentState, OperatingMode mode) {
-    if (mode == MODE_DAYTIME) {
-        switch (currentState) {
-            case STATE_NS_GREEN:        return STATE_NS_YELLOW;
-            case STATE_NS_YELLOW:       return STATE_ALL_RED_1;
-            case STATE_ALL_RED_1:
-                /* Decision: North left demanded? */
-                if (northLeftDemand){
-                    northLeftDemand = false;
-                    return STATE_N_LEFT_GREEN;
-                }
-                /* No demand - check South too before skipping both */
-                if (southLeftDemand) {
-                    southLeftDemand = false;
-                    return STATE_S_LEFT_GREEN;
-                }
-                /* Neither demanded - skip straight to W thru */
-                return STATE_W_THRU_GREEN;
-
-            case STATE_N_LEFT_GREEN:    return STATE_N_LEFT_YELLOW;
-            case STATE_N_LEFT_YELLOW:   return STATE_ALL_RED_2;
-            case STATE_ALL_RED_2:
-                /* Decision: South left demanded? */
-                if (southLeftDemand) {
-                    southLeftDemand = false;
-                    return STATE_S_LEFT_GREEN;
-                }
-                /* No demand - skip to W thru */
-                return STATE_W_THRU_GREEN;
-
-            case STATE_S_LEFT_GREEN:    return STATE_S_LEFT_YELLOW;
-            case STATE_S_LEFT_YELLOW:   return STATE_ALL_RED_3;
-            case STATE_ALL_RED_3:       return STATE_W_THRU_GREEN;
-            case STATE_W_THRU_GREEN:    return STATE_W_THRU_YELLOW;
-            case STATE_W_THRU_YELLOW:   return STATE_ALL_RED_4;
-            case STATE_ALL_RED_4:       return STATE_E_THRU_GREEN;
-            case STATE_E_THRU_GREEN:    return STATE_E_THRU_YELLOW;
-            case STATE_E_THRU_YELLOW:   return STATE_ALL_RED_5;
-            case STATE_ALL_RED_5:       return STATE_W_RIGHT_GREEN;
-            case STATE_W_RIGHT_GREEN:   return STATE_W_RIGHT_YELLOW;
-            case STATE_W_RIGHT_YELLOW:  return STATE_ALL_RED_6;
-            case STATE_ALL_RED_6:       return STATE_RETURN_TO_START;
-            case STATE_RETURN_TO_START: return STATE_NS_GREEN;
-            default:                    return STATE_NS_GREEN;
+const PhasePlan daytimePlan = {
+    .sequence = {
+        { { PHASE_1, PHASE_2 }, { PHASE_4, PHASE_NONE } },
+        { { PHASE_5, PHASE_6 }, { PHASE_8, PHASE_NONE } }
+    },
+    .recall = PHASE_BIT(PHASE_2) | PHASE_BIT(PHASE_6) | PHASE_BIT(PHASE_4) |
+              PHASE_BIT(PHASE_8),
+    .split = {
+        [PHASE_1] = TIME_N_LEFT_GREEN,   [PHASE_2] = TIME_NS_GREEN,
+        [PHASE_4] = TIME_W_THRU_GREEN,   [PHASE_5] = TIME_S_LEFT_GREEN,
+        [PHASE_6] = TIME_NS_GREEN,       [PHASE_8] = TIME_E_THRU_GREEN
+    },
+    .minGreen = {
+        [PHASE_1] = TIME_MIN_LEFT_GREEN, [PHASE_2] = TIME_MIN_GREEN,
+        [PHASE_4] = TIME_MIN_GREEN,      [PHASE_5] = TIME_MIN_LEFT_GREEN,
+        [PHASE_6] = TIME_MIN_GREEN,      [PHASE_8] = TIME_MIN_GREEN
+    },
+    .yellow = {
+        [PHASE_1] = TIME_YELLOW, [PHASE_2] = TIME_YELLOW,
+        [PHASE_4] = TIME_YELLOW, [PHASE_5] = TIME_YELLOW,
+        [PHASE_6] = TIME_YELLOW, [PHASE_8] = TIME_YELLOW
+    },
+    .redClear = {
+        [PHASE_1] = TIME_ALL_RED, [PHASE_2] = TIME_ALL_RED,
+        [PHASE_4] = TIME_ALL_RED, [PHASE_5] = TIME_ALL_RED,
+        [PHASE_6] = TIME_ALL_RED, [PHASE_8] = TIME_ALL_RED
+    }
+};
+
+const PhasePlan highTrafficPlan = {
+    .sequence = {
+        { { PHASE_2, PHASE_1 }, { PHASE_4, PHASE_NONE } },
+        { { PHASE_5, PHASE_6 }, { PHASE_8, PHASE_NONE } }
+    },
+    .recall = PHASE_BIT(PHASE_2) | PHASE_BIT(PHASE_6) | PHASE_BIT(PHASE_4) |
+              PHASE_BIT(PHASE_8),
+    .split = {
+        [PHASE_1] = TIME_N_LEFT_DURING_S,
+        [PHASE_2] = TIME_N_SOLO_GREEN + TIME_S_LEFT_DURING_N +
+                    TIME_NS_BOTH_GREEN,
+        [PHASE_4] = TIME_W_THRU_GREEN_HT,
+        [PHASE_5] = TIME_S_LEFT_DURING_N,
+        [PHASE_6] = TIME_NS_BOTH_GREEN + TIME_N_LEFT_DURING_S,
+        [PHASE_8] = TIME_E_THRU_GREEN_HT
+    },
+    .minGreen = {
+        [PHASE_1] = TIME_MIN_LEFT_GREEN, [PHASE_2] = TIME_MIN_GREEN,
+        [PHASE_4] = TIME_MIN_GREEN,      [PHASE_5] = TIME_MIN_LEFT_GREEN,
+        [PHASE_6] = TIME_MIN_GREEN,      [PHASE_8] = TIME_MIN_GREEN
+    },
+    .yellow = {
+        [PHASE_1] = TIME_YELLOW, [PHASE_2] = TIME_YELLOW,
+        [PHASE_4] = TIME_YELLOW, [PHASE_5] = TIME_YELLOW,
+        [PHASE_6] = TIME_YELLOW, [PHASE_8] = TIME_YELLOW
+    },
+    .redClear = {
+        [PHASE_1] = TIME_ALL_RED, [PHASE_2] = TIME_ALL_RED,
+        [PHASE_4] = TIME_ALL_RED, [PHASE_5] = TIME_ALL_RED,
+        [PHASE_6] = TIME_ALL_RED, [PHASE_8] = TIME_ALL_RED
+    }
+};
+
+const PhasePlan *getPlanForMode(OperatingMode mode) {
+    return (mode == MODE_HIGH_TRAFFIC) ? &highTrafficPlan : &daytimePlan;
+}
+
+/* ============================================================================
+ * PHASE RENDERING
+ * ========================================================================= */
+
+static void applyLEDMask(LEDState *state, uint32_t on, uint32_t off) {
+    uint8_t i;
+    for (i = 0; i < 4; i++) {
+        state->byte[i] &= (uint8_t)~(off >> (8 * i));
+        state->byte[i] |= (uint8_t)(on >> (8 * i));
+    }
+}
+
+void renderPhases(LEDState *state, uint16_t greens, uint16_t yellows,
+                  uint8_t overlapGreens, uint8_t overlapYellows) {
+    uint8_t p, o;
+
+    setAllRed(state);
+
+    for (p = PHASE_1; p < NUM_PHASES; p++) {
+        if (yellows & PHASE_BIT(p)) {
+            applyLEDMask(state, phaseDefs[p].yellowOn, phaseDefs[p].yellowOff);
+        }
+    }
+    for (o = 0; o < NUM_OVERLAPS; o++) {
+        if (overlapYellows & OVERLAP_BIT(o)) {
+            applyLEDMask(state, overlapDefs[o].yellowOn,
+                         overlapDefs[o].yellowOff);
+        }
+    }
+    for (p = PHASE_1; p < NUM_PHASES; p++) {
+        if (greens & PHASE_BIT(p)) {
+            applyLEDMask(state, phaseDefs[p].greenOn, phaseDefs[p].greenOff);
         }
     }
-    else if (mode == MODE_HIGH_TRAFFIC) {
-        switch (currentState) {
-            case STATE_N_PRIORITY_START: return STATE_N_SOLO_GREEN;
-            case STATE_N_SOLO_GREEN:
-                /* Decision: South left demanded during North green? */
-                if (southLeftDemand) {
-                    southLeftDemand = false;
-                    return STATE_S_LEFT_DURING_N;
-                }
-                /* No demand - skip to both green */
-                return STATE_NS_BOTH_GREEN;
-
-            case STATE_S_LEFT_DURING_N:  return STATE_NS_BOTH_GREEN;
-            case STATE_NS_BOTH_GREEN:
-                /* Decision: North left demanded during South green? */
-                if (northLeftDemand) {
-                    northLeftDemand = false;
-                    return STATE_N_LEFT_DURING_S;
-                }
-                /* No demand - skip to yellow */
-                return STATE_NS_HT_YELLOW;
-
-            case STATE_N_LEFT_DURING_S:  return STATE_NS_HT_YELLOW;
-            case STATE_NS_HT_YELLOW:     return STATE_ALL_RED_HT_1;
-            case STATE_ALL_RED_HT_1:     return STATE_W_THRU_GREEN_HT;
-            case STATE_W_THRU_GREEN_HT:  return STATE_W_THRU_YELLOW_HT;
-            case STATE_W_THRU_YELLOW_HT: return STATE_ALL_RED_HT_2;
-            case STATE_ALL_RED_HT_2:     return STATE_E_THRU_GREEN_HT;
-            case STATE_E_THRU_GREEN_HT:  return STATE_E_THRU_YELLOW_HT;
-            case STATE_E_THRU_YELLOW_HT: return STATE_ALL_RED_HT_3;
-            case STATE_ALL_RED_HT_3:     return STATE_W_RIGHT_GREEN_HT;
-            case STATE_W_RIGHT_GREEN_HT: return STATE_W_RIGHT_YELLOW_HT;
-            case STATE_W_RIGHT_YELLOW_HT:return STATE_ALL_RED_HT_4;
-            case STATE_ALL_RED_HT_4:     return STATE_RETURN_HT;
-            case STATE_RETURN_HT:        return STATE_N_PRIORITY_START;
-            default:                     return STATE_N_PRIORITY_START;
+    for (o = 0; o < NUM_OVERLAPS; o++) {
+        if (overlapGreens & OVERLAP_BIT(o)) {
+            applyLEDMask(state, overlapDefs[o].greenOn,
+                         overlapDefs[o].greenOff);
         }
     }
-    else if (mode == MODE_NIGHT) {
+}
+
+/* ============================================================================
+ * NEXT STATE LOGIC
+ *
+ * Only the flashing and emergency modes step through states here. DAYTIME
+ * and HIGH TRAFFIC stay in STATE_PHASE_ENGINE and are sequenced by
+ * ring_engine.c from the plans above; left-turn demand is a call on phase
+ * 1 or 5 rather than a branch at an all-red. Leaving the flash they pass
+ * through STATE_NIGHT_TRANSITION, so no green follows a flashing yellow
+ * without an all-red.
+ * ========================================================================= */
+
+TrafficState getNextState(TrafficState currentState, OperatingMode mode) {
+    if (mode == MODE_NIGHT) {
         if (currentState == STATE_NIGHT_FLASH_ON) {
             return STATE_NIGHT_FLASH_OFF;
         } else {
@@ -689,5 +571,9 @@ TrafficState getNextState(TrafficState currentState, OperatingMode mode) {
         return STATE_EMERGENCY_HOLD;
     }
 
-    return STATE_NS_GREEN;
+    if (currentState == STATE_NIGHT_FLASH_ON ||
+        currentState == STATE_NIGHT_FLASH_OFF) {
+        return STATE_NIGHT_TRANSITION;
+    }
+    return STATE_PHASE_ENGINE;
 }
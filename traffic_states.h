@@ -54,45 +54,9 @@
  * ========================================================================= */
 
 typedef enum {
-    /* --- DAYTIME MODE (0-18) - 19 states --- */
-    STATE_NS_GREEN = 0,
-    STATE_NS_YELLOW,
-    STATE_ALL_RED_1,
-    STATE_N_LEFT_GREEN,
-    STATE_N_LEFT_YELLOW,
-    STATE_ALL_RED_2,
-    STATE_S_LEFT_GREEN,
-    STATE_S_LEFT_YELLOW,
-    STATE_ALL_RED_3,
-    STATE_W_THRU_GREEN,
-    STATE_W_THRU_YELLOW,
-    STATE_ALL_RED_4,
-    STATE_E_THRU_GREEN,
-    STATE_E_THRU_YELLOW,
-    STATE_ALL_RED_5,
-    STATE_W_RIGHT_GREEN,
-    STATE_W_RIGHT_YELLOW,
-    STATE_ALL_RED_6,
-    STATE_RETURN_TO_START,
-
-    /* --- HIGH TRAFFIC MODE (19-35) - 17 states --- */
-    STATE_N_PRIORITY_START = 19,
-    STATE_N_SOLO_GREEN,
-    STATE_S_LEFT_DURING_N,
-    STATE_NS_BOTH_GREEN,
-    STATE_N_LEFT_DURING_S,
-    STATE_NS_HT_YELLOW,
-    STATE_ALL_RED_HT_1,
-    STATE_W_THRU_GREEN_HT,
-    STATE_W_THRU_YELLOW_HT,
-    STATE_ALL_RED_HT_2,
-    STATE_E_THRU_GREEN_HT,
-    STATE_E_THRU_YELLOW_HT,
-    STATE_ALL_RED_HT_3,
-    STATE_W_RIGHT_GREEN_HT,
-    STATE_W_RIGHT_YELLOW_HT,
-    STATE_ALL_RED_HT_4,
-    STATE_RETURN_HT,
+    /* --- PHASE ENGINE (0) - DAYTIME and HIGH TRAFFIC run as ring plans,
+     *     see PHASES below and ring_engine.h --- */
+    STATE_PHASE_ENGINE = 0,
 
     /* --- NIGHT MODE (38-40) - 3 states --- */
     STATE_NIGHT_FLASH_ON = 38,
@@ -103,7 +67,18 @@ typedef enum {
     STATE_EMERGENCY_ALL_RED = 41,
     STATE_EMERGENCY_HOLD,
 
-    STATE_COUNT = 43
+    /* --- PREEMPTION (43-51) - 9 states --- */
+    STATE_PREEMPT_N_GREEN = 43,
+    STATE_PREEMPT_S_GREEN,
+    STATE_PREEMPT_E_GREEN,
+    STATE_PREEMPT_W_GREEN,
+    STATE_PREEMPT_N_YELLOW,
+    STATE_PREEMPT_S_YELLOW,
+    STATE_PREEMPT_E_YELLOW,
+    STATE_PREEMPT_W_YELLOW,
+    STATE_PREEMPT_EXIT_ALL_RED,
+
+    STATE_COUNT = 52
 } TrafficState;
 
 typedef enum {
@@ -113,19 +88,39 @@ typedef enum {
     MODE_EMERGENCY
 } OperatingMode;
 
+/* ============================================================================
+ * APPROACHES
+ * Not the index of the ped matrix corners and buzzers: those are PED_*
+ * (controller.h, N=0 E=1 S=2 W=3), and pedPhase[] gives the phase each
+ * crosswalk runs with.
+ * ========================================================================= */
+
+typedef enum {
+    APPROACH_NORTH = 0,
+    APPROACH_SOUTH,
+    APPROACH_EAST,
+    APPROACH_WEST,
+    NUM_APPROACHES
+} Approach;
+
+#define APPROACH_BIT(a)     ((uint8_t)(1u << (a)))
+
 /* ============================================================================
  * STATE TIMING (milliseconds)
  * ========================================================================= */
 
+/* Green times may be retimed at build time with -DTIMING_HEADER="file.h",
+ * a header written by host/plansearch.c that defines all eleven below */
+#ifdef TIMING_HEADER
+#include TIMING_HEADER
+#else
+
 /* Daytime */
 #define TIME_NS_GREEN           15000
 #define TIME_N_LEFT_GREEN        8000
 #define TIME_S_LEFT_GREEN        8000
 #define TIME_W_THRU_GREEN       15000
 #define TIME_E_THRU_GREEN       15000
-#define TIME_W_RIGHT_GREEN       8000
-#define TIME_YELLOW              3000
-#define TIME_ALL_RED             2000
 
 /* High Traffic */
 #define TIME_N_SOLO_GREEN       10000
@@ -134,7 +129,20 @@ typedef enum {
 #define TIME_N_LEFT_DURING_S     8000
 #define TIME_W_THRU_GREEN_HT   15000
 #define TIME_E_THRU_GREEN_HT   15000
-#define TIME_W_RIGHT_GREEN_HT   8000
+
+#endif /* TIMING_HEADER */
+
+#define TIME_YELLOW              3000
+#define TIME_ALL_RED             2000
+
+/* Overlap clearances (right-turn arrows) */
+#define TIME_OVERLAP_YELLOW      3000
+#define TIME_OVERLAP_ALL_RED     2000
+
+/* Phase minimums - a green is never terminated before these by an early
+ * barrier crossing (spillback); splits above are the normal green times */
+#define TIME_MIN_GREEN           5000
+#define TIME_MIN_LEFT_GREEN      4000
 
 /* Night */
 #define TIME_NIGHT_FLASH_ON     1000
@@ -143,6 +151,11 @@ typedef enum {
 /* Emergency */
 #define TIME_EMERGENCY_HOLD     5000
 
+/* Preemption - track green runs at least this long, then is re-checked
+ * every TIME_PREEMPT_RECHECK until the call drops */
+#define TIME_PREEMPT_MIN_GREEN  8000
+#define TIME_PREEMPT_RECHECK    1000
+
 /* ============================================================================
  * LED STATE STRUCTURE
  * ========================================================================= */
@@ -152,25 +165,100 @@ typedef struct {
 } LEDState;
 
 /* ============================================================================
- * HALL EFFECT SENSOR DEMAND FLAGS
- * Set in main.c by sampling P2.4/P2.5, read in getNextState
+ * PHASES (NEMA dual ring)
+ *
+ *            |------- barrier 0 -------|------- barrier 1 -------|
+ *   ring 0   |  1 N left    2 N thru   |  3 (unused)  4 W thru   |
+ *   ring 1   |  5 S left    6 S thru   |  7 (unused)  8 E thru   |
+ *
+ * Any ring 0 phase may be green alongside any ring 1 phase of the same
+ * barrier (opposing protected lefts, a left with the opposing through, W
+ * through with E through and its permissive left). Phases of different
+ * barriers, or of the same ring, conflict.
+ *
+ * Each phase drives its signal heads through LED masks applied over an
+ * all-red base: yellows first, then greens, so a head shared by a phase and
+ * an overlap shows the green when either is green.
  * ========================================================================= */
 
-extern volatile bool northLeftDemand;
-extern volatile bool southLeftDemand;
+typedef enum {
+    PHASE_NONE = 0,
+    PHASE_1,            /* N protected left */
+    PHASE_2,            /* N through + combo ball */
+    PHASE_3,            /* unused */
+    PHASE_4,            /* W through + right ball */
+    PHASE_5,            /* S protected left */
+    PHASE_6,            /* S through + combo ball + right ball */
+    PHASE_7,            /* unused */
+    PHASE_8,            /* E through + permissive left */
+    NUM_PHASES
+} Phase;
+
+#define PHASE_BIT(p)        ((uint16_t)(1u << (p)))
+#define LED_BIT(n)          (1UL << (n))
+
+#define NUM_RINGS           2
+#define NUM_BARRIERS        2
+#define PHASES_PER_SLOT     2   /* phases per ring within one barrier */
+
+typedef struct {
+    uint32_t greenOn;       /* LEDs lit while green */
+    uint32_t greenOff;      /* LEDs (reds, shared yellows) cleared while green */
+    uint32_t yellowOn;
+    uint32_t yellowOff;
+    uint8_t  ring;
+    uint8_t  barrier;
+    uint8_t  approaches;    /* APPROACH_BIT of through movements served */
+    uint8_t  leftArrows;    /* APPROACH_BIT of protected left arrows */
+    uint16_t conflicts;     /* PHASE_BIT of phases never shown with this one */
+} PhaseDef;
+
+/* A plan orders each ring's phases within each barrier and times them.
+ * Phases in `recall` are served every cycle, others only on a call. */
+typedef struct {
+    uint8_t  sequence[NUM_RINGS][NUM_BARRIERS][PHASES_PER_SLOT];
+    uint16_t recall;
+    uint16_t split[NUM_PHASES];     /* green, ms */
+    uint16_t minGreen[NUM_PHASES];
+    uint16_t yellow[NUM_PHASES];
+    uint16_t redClear[NUM_PHASES];
+} PhasePlan;
 
 /* ============================================================================
- * BUZZER CONTROL FLAGS
- * [0]=North  [1]=South  [2]=East  [3]=West
+ * OVERLAPS (right-turn arrows)
+ *
+ * An overlap is green whenever any of its parent phases is green, and
+ * times its own yellow and red clearance once the last parent ends:
+ *
+ *   OVERLAP_S_RIGHT   S right arrow, parent 4 (W through)
+ *   OVERLAP_W_RIGHT   W right arrow, parent 1 (N protected left)
+ *
+ * An overlap that is still clearing holds the barrier crossing, and it
+ * does not turn green again until its red clearance has finished.
  * ========================================================================= */
 
-extern volatile bool buzzerActive[4];
+typedef enum {
+    OVERLAP_S_RIGHT = 0,
+    OVERLAP_W_RIGHT,
+    NUM_OVERLAPS
+} Overlap;
 
-/* ============================================================================
- * PEDESTRIAN WALK REQUEST FLAGS
- * ========================================================================= */
+#define OVERLAP_BIT(o)      ((uint8_t)(1u << (o)))
 
-extern volatile bool pedWalkRequest[4];
+typedef struct {
+    uint16_t parents;       /* PHASE_BIT of parent phases */
+    uint32_t greenOn;
+    uint32_t greenOff;
+    uint32_t yellowOn;
+    uint32_t yellowOff;
+    uint16_t yellow;        /* ms */
+    uint16_t redClear;
+} OverlapDef;
+
+extern const PhaseDef   phaseDefs[NUM_PHASES];
+extern const OverlapDef overlapDefs[NUM_OVERLAPS];
+extern const PhasePlan daytimePlan;
+extern const PhasePlan highTrafficPlan;
 
 /* ============================================================================
  * FUNCTION PROTOTYPES
@@ -188,46 +276,12 @@ bool getLED(LEDState *state, uint8_t ledNumber);
 void executeState(LEDState *state, TrafficState currentState);
 uint32_t getStateDuration(TrafficState state);
 TrafficState getNextState(TrafficState currentState, OperatingMode mode);
+uint8_t getStateLeftArrows(TrafficState state);
 
-/* Daytime state functions (0-18) */
-void setState_0_NSGreen(LEDState *state);
-void setState_1_NSYellow(LEDState *state);
-void setState_2_AllRed1(LEDState *state);
-void setState_3_NLeftGreen(LEDState *state);
-void setState_4_NLeftYellow(LEDState *state);
-void setState_5_AllRed2(LEDState *state);
-void setState_6_SLeftGreen(LEDState *state);
-void setState_7_SLeftYellow(LEDState *state);
-void setState_8_AllRed3(LEDState *state);
-void setState_9_WThruGreen(LEDState *state);
-void setState_10_WThruYellow(LEDState *state);
-void setState_11_AllRed4(LEDState *state);
-void setState_12_EThruGreen(LEDState *state);
-void setState_13_EThruYellow(LEDState *state);
-void setState_14_AllRed5(LEDState *state);
-void setState_15_WRightGreen(LEDState *state);
-void setState_16_WRightYellow(LEDState *state);
-void setState_17_AllRed6(LEDState *state);
-void setState_18_ReturnStart(LEDState *state);
-
-/* High Traffic state functions (19-35) */
-void setState_19_NPriorityStart(LEDState *state);
-void setState_20_NSoloGreen(LEDState *state);
-void setState_21_SLeftDuringN(LEDState *state);
-void setState_22_NSBothGreen(LEDState *state);
-void setState_23_NLeftDuringS(LEDState *state);
-void setState_24_NSHTYellow(LEDState *state);
-void setState_25_AllRedHT1(LEDState *state);
-void setState_26_WThruGreenHT(LEDState *state);
-void setState_27_WThruYellowHT(LEDState *state);
-void setState_28_AllRedHT2(LEDState *state);
-void setState_29_EThruGreenHT(LEDState *state);
-void setState_30_EThruYellowHT(LEDState *state);
-void setState_31_AllRedHT3(LEDState *state);
-void setState_32_WRightGreenHT(LEDState *state);
-void setState_33_WRightYellowHT(LEDState *state);
-void setState_34_AllRedHT4(LEDState *state);
-void setState_35_ReturnHT(LEDState *state);
+/* Phase tables */
+const PhasePlan *getPlanForMode(OperatingMode mode);
+void renderPhases(LEDState *state, uint16_t greens, uint16_t yellows,
+                  uint8_t overlapGreens, uint8_t overlapYellows);
 
 /* Night state functions (38-40) */
 void setState_38_NightFlashOn(LEDState *state);
@@ -238,4 +292,15 @@ void setState_40_NightTransition(LEDState *state);
 void setState_41_EmergencyAllRed(LEDState *state);
 void setState_42_EmergencyHold(LEDState *state);
 
+/* Preemption state functions (43-51) */
+void setState_43_PreemptNGreen(LEDState *state);
+void setState_44_PreemptSGreen(LEDState *state);
+void setState_45_PreemptEGreen(LEDState *state);
+void setState_46_PreemptWGreen(LEDState *state);
+void setState_47_PreemptNYellow(LEDState *state);
+void setState_48_PreemptSYellow(LEDState *state);
+void setState_49_PreemptEYellow(LEDState *state);
+void setState_50_PreemptWYellow(LEDState *state);
+void setState_51_PreemptExitAllRed(LEDState *state);
+
 #endif /* TRAFFIC_STATES_H */
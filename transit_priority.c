@@ -0,0 +1,137 @@
+#include "transit_priority.h"
+
+/* ============================================================================
+ * HELPERS
+ * ========================================================================= */
+
+static bool anyCallPending(const TspState *tsp) {
+    uint8_t i;
+    for (i = 0; i < NUM_APPROACHES; i++) {
+        if (tsp->callPending[i]) return true;
+    }
+    return false;
+}
+
+/* Cut up to `wanted` ms from a conflicting green and book it as debt */
+static uint32_t takeEarlyGreen(TspState *tsp, uint8_t greenApproaches,
+                               uint32_t wanted) {
+    uint32_t budget;
+    uint8_t i;
+
+    budget = TSP_MAX_EARLY_GREEN - tsp->earlyGreenUsed;
+    if (wanted > budget) wanted = budget;
+
+    tsp->earlyGreenUsed += wanted;
+    for (i = 0; i < NUM_APPROACHES; i++) {
+        if (greenApproaches & APPROACH_BIT(i)) tsp->debt[i] += wanted;
+    }
+    return wanted;
+}
+
+/* ============================================================================
+ * PUBLIC API
+ * ========================================================================= */
+
+void tspInit(TspState *tsp) {
+    uint8_t i;
+    for (i = 0; i < NUM_APPROACHES; i++) {
+        tsp->callPending[i] = false;
+        tsp->debt[i]        = 0;
+    }
+    tsp->extendedThisGreen = false;
+    tsp->earlyGreenUsed    = 0;
+}
+
+bool tspDecodeCall(uint32_t code, Approach *approach) {
+    uint8_t addr    = (uint8_t)(code);
+    uint8_t addrInv = (uint8_t)(code >> 8);
+    uint8_t cmd     = (uint8_t)(code >> 16);
+    uint8_t cmdInv  = (uint8_t)(code >> 24);
+
+    if (addr != TSP_NEC_ADDRESS) return false;
+    if ((uint8_t)(addr ^ addrInv) != 0xFF) return false;
+    if ((uint8_t)(cmd ^ cmdInv) != 0xFF) return false;
+    if (cmd < TSP_CMD_BASE || cmd >= TSP_CMD_BASE + NUM_APPROACHES) return false;
+
+    *approach = (Approach)(cmd - TSP_CMD_BASE);
+    return true;
+}
+
+/* Called for each running green whenever a bus call is decoded. Returns
+ * the ms that green has left, for the caller to write back to its ring
+ * (ringSetGreenRemaining); a cut green keeps at least 1 ms and ends on the
+ * phase engine's next step. */
+uint32_t tspCall(TspState *tsp, Approach approach, uint8_t greenApproaches,
+                 uint32_t elapsed, uint32_t remaining) {
+    uint32_t floor;
+
+    /* Bus approach already green - extend once */
+    if (greenApproaches & APPROACH_BIT(approach)) {
+        tsp->callPending[approach] = false;
+        if (!tsp->extendedThisGreen) {
+            tsp->extendedThisGreen = true;
+            remaining += TSP_MAX_EXTENSION;
+        }
+        return remaining;
+    }
+
+    tsp->callPending[approach] = true;
+
+    /* Clearance or turn phase - the call waits for the next green start */
+    if (greenApproaches == 0) return remaining;
+
+    /* Conflicting green - truncate towards TSP_MIN_GREEN */
+    floor = (elapsed >= TSP_MIN_GREEN) ? 1 : (TSP_MIN_GREEN - elapsed);
+    if (remaining > floor) {
+        remaining -= takeEarlyGreen(tsp, greenApproaches, remaining - floor);
+    }
+    return remaining;
+}
+
+/* Called as each green is entered. Returns the adjusted green duration. */
+uint32_t tspGreenStart(TspState *tsp, uint8_t greenApproaches,
+                       uint32_t duration) {
+    uint32_t owed = 0;
+    uint32_t repay;
+    bool served = false;
+    uint8_t i;
+
+    if (greenApproaches == 0) return duration;
+
+    tsp->extendedThisGreen = false;
+
+    for (i = 0; i < NUM_APPROACHES; i++) {
+        if ((greenApproaches & APPROACH_BIT(i)) && tsp->callPending[i]) {
+            tsp->callPending[i] = false;
+            served = true;
+        }
+    }
+
+    if (!anyCallPending(tsp)) tsp->earlyGreenUsed = 0;
+
+    /* A bus is still waiting further down the cycle - keep cutting */
+    if (!served && anyCallPending(tsp)) {
+        if (duration > TSP_MIN_GREEN) {
+            duration -= takeEarlyGreen(tsp, greenApproaches,
+                                       duration - TSP_MIN_GREEN);
+        }
+        return duration;
+    }
+
+    /* Otherwise repay what this phase lost in earlier cycles */
+    for (i = 0; i < NUM_APPROACHES; i++) {
+        if ((greenApproaches & APPROACH_BIT(i)) && tsp->debt[i] > owed) {
+            owed = tsp->debt[i];
+        }
+    }
+
+    repay = (owed > TSP_REPAY_PER_CYCLE) ? TSP_REPAY_PER_CYCLE : owed;
+
+    for (i = 0; i < NUM_APPROACHES; i++) {
+        if (greenApproaches & APPROACH_BIT(i)) {
+            tsp->debt[i] = (tsp->debt[i] > repay) ? tsp->debt[i] - repay : 0;
+        }
+    }
+
+    return duration + repay;
+}
@@ -0,0 +1,56 @@
+#ifndef TRANSIT_PRIORITY_H
+#define TRANSIT_PRIORITY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "traffic_states.h"
+
+/* ============================================================================
+ * TRANSIT SIGNAL PRIORITY (TSP)
+ *
+ * Bus emitters send ordinary 32-bit NEC frames on a dedicated address.
+ * The command byte carries the approach the bus is arriving on:
+ *
+ *   bits  0-7   TSP_NEC_ADDRESS
+ *   bits  8-15  ~TSP_NEC_ADDRESS
+ *   bits 16-23  TSP_CMD_BASE + Approach
+ *   bits 24-31  ~command
+ *
+ * A call is granted in one of two ways:
+ *   - GREEN EXTENSION: the bus approach is already green, so its green is
+ *     stretched by up to TSP_MAX_EXTENSION (once per green).
+ *   - EARLY GREEN:     a conflicting green is running, so it and any other
+ *     conflicting greens before the bus phase are cut short, never below
+ *     TSP_MIN_GREEN, and by no more than TSP_MAX_EARLY_GREEN in total.
+ *
+ * Green time cut from a phase is recorded as debt against its approaches
+ * and repaid as extra green over the following cycles, at most
+ * TSP_REPAY_PER_CYCLE per green.
+ *
+ * Only green durations are touched - yellow, all-red and the pedestrian
+ * holdover in main.c run exactly as before.
+ * ========================================================================= */
+
+#define TSP_NEC_ADDRESS         0x5A
+#define TSP_CMD_BASE            0x40
+
+#define TSP_MAX_EXTENSION      10000
+#define TSP_MAX_EARLY_GREEN    10000
+#define TSP_MIN_GREEN           5000
+#define TSP_REPAY_PER_CYCLE     3000
+
+typedef struct {
+    bool     callPending[NUM_APPROACHES];
+    bool     extendedThisGreen;
+    uint32_t earlyGreenUsed;
+    uint32_t debt[NUM_APPROACHES];
+} TspState;
+
+void     tspInit(TspState *tsp);
+bool     tspDecodeCall(uint32_t code, Approach *approach);
+uint32_t tspCall(TspState *tsp, Approach approach, uint8_t greenApproaches,
+                 uint32_t elapsed, uint32_t remaining);
+uint32_t tspGreenStart(TspState *tsp, uint8_t greenApproaches,
+                       uint32_t duration);
+
+#endif /* TRANSIT_PRIORITY_H */